@@ -11,9 +11,13 @@
 //	we use ReadFrom/WriteBack to fetch the contents of the directory
 //	from disk, and to write back any modifications back to disk.
 //
-//	Also, this implementation has the restriction that the size
-//	of the directory cannot expand.  In other words, once all the
-//	entries in the directory are used, no more files can be created.
+//	When every entry is in use, the table is doubled in size; the
+//	file holding the directory grows as the new entries are written
+//	back.  A directory can hold as many entries as fit in a file
+//	(MaxFileSize bytes).
+//
+//	Names are looked up through a hash table over the entries in use,
+//	which is rebuilt whenever the table is fetched or reallocated.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -24,6 +28,29 @@
 #include "filehdr.h"
 #include "directory.h"
 
+//----------------------------------------------------------------------
+// EntryKey, HashName
+//	The functions the hash table index needs: the key of a directory
+//	entry is its name, and names hash on their first FileNameMaxLen
+//	characters.
+//----------------------------------------------------------------------
+
+static EntryName
+EntryKey(DirectoryEntry *entry)
+{
+    return EntryName(entry->name);
+}
+
+static unsigned
+HashName(EntryName key)
+{
+    unsigned hash = 5381;
+
+    for (int i = 0; i < FileNameMaxLen && key.name[i] != '\0'; i++)
+	hash = hash * 33 + key.name[i];
+    return hash;
+}
+
 //----------------------------------------------------------------------
 // Directory::Directory
 // 	Initialize a directory; initially, the directory is completely
@@ -38,8 +65,10 @@ Directory::Directory(int size)
 {
     table = new DirectoryEntry[size];
     tableSize = size;
-    for (int i = 0; i < tableSize; i++)
-	table[i].inUse = FALSE;
+    bzero(table, size * sizeof(DirectoryEntry));	// no entry is in use
+    index = new HashTable<EntryName, DirectoryEntry *>(EntryKey, HashName);
+    firstDirty = 0;			// all of it needs to be written
+    lastDirty = tableSize - 1;
 }
 
 //----------------------------------------------------------------------
@@ -49,12 +78,15 @@ Directory::Directory(int size)
 
 Directory::~Directory()
 { 
+    ClearIndex();
+    delete index;
     delete [] table;
 } 
 
 //----------------------------------------------------------------------
 // Directory::FetchFrom
-// 	Read the contents of the directory from disk.
+// 	Read the contents of the directory from disk.  The table is
+//	resized to hold every entry in the file.
 //
 //	"file" -- file containing the directory contents
 //----------------------------------------------------------------------
@@ -62,12 +94,24 @@ Directory::~Directory()
 void
 Directory::FetchFrom(OpenFile *file)
 {
+    int size = file->Length() / sizeof(DirectoryEntry);
+
+    ClearIndex();
+    if (size != tableSize) {
+	delete [] table;
+	table = new DirectoryEntry[size];
+	tableSize = size;
+    }
     (void) file->ReadAt((char *)table, tableSize * sizeof(DirectoryEntry), 0);
+    BuildIndex();
+    firstDirty = tableSize;		// nothing has changed yet
+    lastDirty = -1;
 }
 
 //----------------------------------------------------------------------
 // Directory::WriteBack
-// 	Write any modifications to the directory back to disk
+// 	Write any modifications to the directory back to disk.  Only
+//	the entries that have changed are written.
 //
 //	"file" -- file to contain the new directory contents
 //----------------------------------------------------------------------
@@ -75,7 +119,13 @@ Directory::FetchFrom(OpenFile *file)
 void
 Directory::WriteBack(OpenFile *file)
 {
-    (void) file->WriteAt((char *)table, tableSize * sizeof(DirectoryEntry), 0);
+    if (firstDirty > lastDirty)
+	return;				// nothing to write
+    (void) file->WriteAt((char *)&table[firstDirty],
+		(lastDirty - firstDirty + 1) * sizeof(DirectoryEntry),
+		firstDirty * sizeof(DirectoryEntry));
+    firstDirty = tableSize;
+    lastDirty = -1;
 }
 
 //----------------------------------------------------------------------
@@ -89,9 +139,10 @@ Directory::WriteBack(OpenFile *file)
 int
 Directory::FindIndex(char *name)
 {
-    for (int i = 0; i < tableSize; i++)
-        if (table[i].inUse && !strncmp(table[i].name, name, FileNameMaxLen))
-	    return i;
+    DirectoryEntry *entry;
+
+    if (index->Find(EntryName(name), &entry))
+	return entry - table;
     return -1;		// name not in directory
 }
 
@@ -114,31 +165,58 @@ Directory::Find(char *name)
     return -1;
 }
 
+//----------------------------------------------------------------------
+// Directory::IsDirectory
+// 	Return TRUE if "name" is in the directory, and is itself a
+//	directory.
+//
+//	"name" -- the file name to look up
+//----------------------------------------------------------------------
+
+bool
+Directory::IsDirectory(char *name)
+{
+    int i = FindIndex(name);
+
+    return (i != -1) && table[i].isDirectory;
+}
+
 //----------------------------------------------------------------------
 // Directory::Add
 // 	Add a file into the directory.  Return TRUE if successful;
 //	return FALSE if the file name is already in the directory, or if
-//	the directory is completely full, and has no more space for
-//	additional file names.
+//	the directory is as big as a file can be, and has no more space
+//	for additional file names.
 //
 //	"name" -- the name of the file being added
 //	"newSector" -- the disk sector containing the added file's header
+//	"isDirectory" -- is the file being added a directory?
 //----------------------------------------------------------------------
 
 bool
-Directory::Add(char *name, int newSector)
+Directory::Add(char *name, int newSector, bool isDirectory)
 { 
+    int i;
+
     if (FindIndex(name) != -1)
 	return FALSE;
 
-    for (int i = 0; i < tableSize; i++)
-        if (!table[i].inUse) {
-            table[i].inUse = TRUE;
-            strncpy(table[i].name, name, FileNameMaxLen); 
-            table[i].sector = newSector;
-        return TRUE;
-	}
-    return FALSE;	// no space.  Fix when we have extensible files.
+    for (i = 0; i < tableSize; i++)
+        if (!table[i].inUse)
+	    break;
+    if ((i + 1) * sizeof(DirectoryEntry) > MaxFileSize)
+	return FALSE;	// no space, even if the file grows
+    if (i == tableSize)
+	Resize(max(2 * tableSize, 1));
+
+    bzero(&table[i], sizeof(DirectoryEntry));
+    table[i].inUse = TRUE;
+    table[i].isDirectory = isDirectory;
+    strncpy(table[i].name, name, FileNameMaxLen); 
+    table[i].sector = newSector;
+    index->Insert(&table[i]);
+    MarkDirty(i);
+    return TRUE;
 }
 
 //----------------------------------------------------------------------
@@ -156,13 +234,28 @@ Directory::Remove(char *name)
 
     if (i == -1)
 	return FALSE; 		// name not in directory
+    index->Remove(EntryName(table[i].name));
     table[i].inUse = FALSE;
+    MarkDirty(i);
     return TRUE;	
 }
 
+//----------------------------------------------------------------------
+// Directory::IsEmpty
+// 	Return TRUE if no entries are in use.  Only an empty directory
+//	can be removed.
+//----------------------------------------------------------------------
+
+bool
+Directory::IsEmpty()
+{
+    return index->IsEmpty();
+}
+
 //----------------------------------------------------------------------
 // Directory::List
-// 	List all the file names in the directory. 
+// 	List all the file names in the directory.  Subdirectories are
+//	marked with a trailing '/'.
 //----------------------------------------------------------------------
 
 void
@@ -170,7 +263,7 @@ Directory::List()
 {
    for (int i = 0; i < tableSize; i++)
 	if (table[i].inUse)
-	    printf("%s\n", table[i].name);
+	    printf("%s%s\n", table[i].name, table[i].isDirectory ? "/" : "");
 }
 
 //----------------------------------------------------------------------
@@ -187,10 +280,68 @@ Directory::Print()
     printf("Directory contents:\n");
     for (int i = 0; i < tableSize; i++)
 	if (table[i].inUse) {
-	    printf("Name: %s, Sector: %d\n", table[i].name, table[i].sector);
+	    printf("Name: %s%s, Sector: %d\n", table[i].name,
+			table[i].isDirectory ? "/" : "", table[i].sector);
 	    hdr->FetchFrom(table[i].sector);
 	    hdr->Print();
 	}
     printf("\n");
     delete hdr;
 }
+
+//----------------------------------------------------------------------
+// Directory::Resize
+// 	Change the number of entries in the table, keeping the ones that
+//	are there.  The entries move, so the index is rebuilt.
+//
+//	"newSize" -- the new number of entries
+//----------------------------------------------------------------------
+
+void
+Directory::Resize(int newSize)
+{
+    DirectoryEntry *newTable = new DirectoryEntry[newSize];
+
+    ASSERT(newSize >= tableSize);
+    ClearIndex();
+    bcopy(table, newTable, tableSize * sizeof(DirectoryEntry));
+    bzero(&newTable[tableSize], (newSize - tableSize) * sizeof(DirectoryEntry));
+    delete [] table;
+    table = newTable;
+    tableSize = newSize;
+    BuildIndex();
+}
+
+//----------------------------------------------------------------------
+// Directory::BuildIndex, ClearIndex
+// 	Put every entry in use into the hash table index, or take them
+//	all out again (before the table is freed or overwritten).
+//----------------------------------------------------------------------
+
+void
+Directory::BuildIndex()
+{
+    for (int i = 0; i < tableSize; i++)
+	if (table[i].inUse)
+	    index->Insert(&table[i]);
+}
+
+void
+Directory::ClearIndex()
+{
+    for (int i = 0; i < tableSize; i++)
+	if (table[i].inUse)
+	    index->Remove(EntryName(table[i].name));
+}
+
+//----------------------------------------------------------------------
+// Directory::MarkDirty
+// 	Note that entry "i" has changed, and must be written back.
+//----------------------------------------------------------------------
+
+void
+Directory::MarkDirty(int i)
+{
+    firstDirty = min(firstDirty, i);
+    lastDirty = max(lastDirty, i);
+}
@@ -4,7 +4,11 @@
 //      A directory is a table of pairs: <file name, sector #>,
 //	giving the name of each file in the directory, and 
 //	where to find its file header (the data structure describing
-//	where to find the file's data blocks) on disk.
+//	where to find the file's data blocks) on disk.  An entry
+//	can itself be a directory, so directories form a tree.
+//
+//	In memory, the table is indexed by a hash table on file names,
+//	so that looking up a name doesn't have to scan the table.
 //
 //      We assume mutual exclusion is provided by the caller.
 //
@@ -18,6 +22,7 @@
 #define DIRECTORY_H
 
 #include "openfile.h"
+#include "hash.h"
 
 #define FileNameMaxLen 		9	// for simplicity, we assume 
 					// file names are <= 9 characters long
@@ -32,12 +37,26 @@
 class DirectoryEntry {
   public:
     bool inUse;				// Is this directory entry in use?
+    bool isDirectory;			// Is this entry a subdirectory?
     int sector;				// Location on disk to find the 
 					//   FileHeader for this file 
     char name[FileNameMaxLen + 1];	// Text name for file, with +1 for 
 					// the trailing '\0'
 };
 
+// The key for the hash table index over a directory's entries: a file
+// name.  Two keys are equal if the names are, up to FileNameMaxLen
+// characters -- the same rule that the directory has always used.
+
+class EntryName {
+  public:
+    EntryName(char *n) { name = n; }
+    bool operator==(const EntryName &other) const
+	{ return strncmp(name, other.name, FileNameMaxLen) == 0; }
+
+    char *name;
+};
+
 // The following class defines a UNIX-like "directory".  Each entry in
 // the directory describes a file, and where to find it on disk.
 //
@@ -46,7 +65,8 @@ class DirectoryEntry {
 //
 // The constructor initializes a directory structure in memory; the
 // FetchFrom/WriteBack operations shuffle the directory information
-// from/to disk. 
+// from/to disk.  The table grows when it fills up; WriteBack only
+// writes the entries that have changed, growing the file as needed.
 
 class Directory {
   public:
@@ -60,11 +80,15 @@ class Directory {
 
     int Find(char *name);		// Find the sector number of the 
 					// FileHeader for file: "name"
+    bool IsDirectory(char *name);	// Is "name" a subdirectory?
 
-    bool Add(char *name, int newSector);  // Add a file name into the directory
+    bool Add(char *name, int newSector, bool isDirectory);
+					// Add a file name into the directory
 
     bool Remove(char *name);		// Remove a file from the directory
 
+    bool IsEmpty();			// Are there no files in the directory?
+
     void List();			// Print the names of all the files
 					//  in the directory
     void Print();			// Verbose print of the contents
@@ -75,9 +99,17 @@ class Directory {
     int tableSize;			// Number of directory entries
     DirectoryEntry *table;		// Table of pairs: 
 					// <file name, file header location> 
+    HashTable<EntryName, DirectoryEntry *> *index;
+					// The entries in use, by name
+    int firstDirty, lastDirty;		// Range of entries changed since
+					// the last FetchFrom or WriteBack
 
     int FindIndex(char *name);		// Find the index into the directory 
 					//  table corresponding to "name"
+    void Resize(int newSize);		// Change the size of the table
+    void BuildIndex();			// Put the entries in use into, or
+    void ClearIndex();			//  take them out of, the index
+    void MarkDirty(int i);		// Entry "i" needs to be written back
 };
 
 #endif // DIRECTORY_H
@@ -29,6 +29,33 @@
 #include "synchdisk.h"
 #include "main.h"
 
+//----------------------------------------------------------------------
+// ReadSector, WriteSector
+// 	Read/write a sector of a file header, or of a file.  The real
+//	file system sends these through its journal; with the stub one,
+//	headers are never used, but still have to link.
+//----------------------------------------------------------------------
+
+static void
+ReadSector(int sector, char *data)
+{
+#ifdef FILESYS_STUB
+    kernel->synchDisk->ReadSector(sector, data);
+#else
+    kernel->fileSystem->ReadSector(sector, data);
+#endif
+}
+
+static void
+WriteSector(int sector, char *data)
+{
+#ifdef FILESYS_STUB
+    kernel->synchDisk->WriteSector(sector, data);
+#else
+    kernel->fileSystem->WriteSector(sector, data);
+#endif
+}
+
 //----------------------------------------------------------------------
 // FileHeader::Allocate
 // 	Initialize a fresh file header for a newly created file.
@@ -73,6 +100,79 @@ FileHeader::Deallocate(PersistentBitmap *freeMap)
     }
 }
 
+//----------------------------------------------------------------------
+// FileHeader::Extend
+// 	Grow the file to "newSize" bytes, allocating any data blocks
+//	that it needs out of the map of free disk blocks.  Blocks are
+//	allocated GrowSectors at a time (as one contiguous run, if there
+//	is one), so that a long series of small appends only changes
+//	the free map once every few sectors.
+//
+//	Only the in-memory header is changed; the caller must write it
+//	back to disk.  Return FALSE, leaving the file unchanged, if the
+//	file would be too big, or there is not enough free space.
+//
+//	"freeMap" is the bit map of free disk sectors
+//	"newSize" is the new length of the file, in bytes
+//----------------------------------------------------------------------
+
+bool
+FileHeader::Extend(PersistentBitmap *freeMap, int newSize)
+{
+    int needed = divRoundUp(newSize, SectorSize);
+    int wanted, first;
+
+    ASSERT(newSize >= numBytes);
+    if (newSize > (int) MaxFileSize)
+	return FALSE;		// no room in the header
+    if (needed > numSectors) {
+	if (freeMap->NumClear() < needed - numSectors)
+	    return FALSE;	// not enough space
+
+	// round the request up to a whole batch, but don't take more
+	// than the header can hold, or than is left on the disk
+	wanted = min(divRoundUp(needed, GrowSectors) * GrowSectors,
+						(int) NumDirect);
+	wanted = min(wanted, numSectors + freeMap->NumClear());
+
+	first = freeMap->FindAndSetRun(wanted - numSectors);
+	for (; numSectors < wanted; numSectors++) {
+	    if (first >= 0) {
+		dataSectors[numSectors] = first++;
+	    } else {
+		dataSectors[numSectors] = freeMap->FindAndSet();
+	    }
+	    ASSERT(dataSectors[numSectors] >= 0);
+	}
+    }
+    numBytes = newSize;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// FileHeader::Trim
+// 	Give back the data blocks that Extend allocated ahead of need,
+//	once the file is done growing.  Return TRUE if any were freed
+//	(and so the free map has changed).
+//
+//	"freeMap" is the bit map of free disk sectors
+//----------------------------------------------------------------------
+
+bool
+FileHeader::Trim(PersistentBitmap *freeMap)
+{
+    int needed = divRoundUp(numBytes, SectorSize);
+    bool trimmed = FALSE;
+
+    while (numSectors > needed) {
+	numSectors--;
+	ASSERT(freeMap->Test(dataSectors[numSectors]));
+	freeMap->Clear(dataSectors[numSectors]);
+	trimmed = TRUE;
+    }
+    return trimmed;
+}
+
 //----------------------------------------------------------------------
 // FileHeader::FetchFrom
 // 	Fetch contents of file header from disk. 
@@ -83,7 +183,7 @@ FileHeader::Deallocate(PersistentBitmap *freeMap)
 void
 FileHeader::FetchFrom(int sector)
 {
-    kernel->synchDisk->ReadSector(sector, (char *)this);
+    ReadSector(sector, (char *)this);
 }
 
 //----------------------------------------------------------------------
@@ -96,7 +196,7 @@ FileHeader::FetchFrom(int sector)
 void
 FileHeader::WriteBack(int sector)
 {
-    kernel->synchDisk->WriteSector(sector, (char *)this); 
+    WriteSector(sector, (char *)this);
 }
 
 //----------------------------------------------------------------------
@@ -143,7 +243,7 @@ FileHeader::Print()
 	printf("%d ", dataSectors[i]);
     printf("\nFile contents:\n");
     for (i = k = 0; i < numSectors; i++) {
-	kernel->synchDisk->ReadSector(dataSectors[i], data);
+	ReadSector(dataSectors[i], data);
         for (j = 0; (j < SectorSize) && (k < numBytes); j++, k++) {
 	    if ('\040' <= data[j] && data[j] <= '\176')   // isprint(data[j])
 		printf("%c", data[j]);
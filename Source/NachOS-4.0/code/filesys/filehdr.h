@@ -19,6 +19,7 @@
 
 #define NumDirect 	((SectorSize - 2 * sizeof(int)) / sizeof(int))
 #define MaxFileSize 	(NumDirect * SectorSize)
+#define GrowSectors	8	// sectors added at a time when a file grows
 
 // The following class defines the Nachos "file header" (in UNIX terms,  
 // the "i-node"), describing where on disk to find all of the data in the file.
@@ -34,6 +35,10 @@
 // There is no constructor; rather the file header can be initialized
 // by allocating blocks for the file (if it is a new file), or by
 // reading it from disk.
+//
+// A file that is written past its end grows by GrowSectors data blocks
+// at a time, so while it is open it may own a few more blocks than its
+// length needs; they are given back (by Trim) when the file is closed.
 
 class FileHeader {
   public:
@@ -42,6 +47,11 @@ class FileHeader {
 						//  on disk for the file data
     void Deallocate(PersistentBitmap *bitMap);  // De-allocate this file's 
 						//  data blocks
+    bool Extend(PersistentBitmap *bitMap, int newSize); // Grow the file to
+						//  "newSize" bytes, allocating
+						//  data blocks in batches
+    bool Trim(PersistentBitmap *bitMap);	// Give back data blocks past
+						//  the end of the file
 
     void FetchFrom(int sectorNumber); 	// Initialize file header from disk
     void WriteBack(int sectorNumber); 	// Write modifications to file header
@@ -11,33 +11,53 @@
 //
 // 	The file system consists of several data structures:
 //	   A bitmap of free disk sectors (cf. bitmap.h)
-//	   A directory of file names and file headers
+//	   A tree of directories of file names and file headers
 //
-//      Both the bitmap and the directory are represented as normal
-//	files.  Their file headers are located in specific sectors
-//	(sector 0 and sector 1), so that the file system can find them
-//	on bootup.
+//      Both the bitmap and the directories are represented as normal
+//	files.  The file headers of the bitmap and of the root directory
+//	are located in specific sectors (sector 0 and sector 1), so that
+//	the file system can find them on bootup.  Every other directory
+//	is found through its entry in its parent.
 //
-//	The file system assumes that the bitmap and directory files are
-//	kept "open" continuously while Nachos is running.
+//	File names are paths from the root, such as "/dir/file" (the
+//	leading '/' is optional).  Each component is at most
+//	FileNameMaxLen characters; longer ones are truncated.
+//
+//	The file system assumes that the bitmap and root directory files
+//	are kept "open" continuously while Nachos is running.  The bitmap
+//	is also kept in memory, so allocating a sector doesn't have to
+//	read it in from disk; so is each directory, once it has been
+//	looked at, so that looking up a name doesn't either.  On top of
+//	that, a cache of recently opened path names remembers where each
+//	file's header is, so opening it again skips the path walk.
+//
+//	File headers are kept in memory while their file is open, and
+//	shared by everyone who has it open, so they all agree on how long
+//	it is.  A header stays in memory for a while after it is closed,
+//	too, in case the file is opened again.
 //
 //	For those operations (such as Create, Remove) that modify the
 //	directory and/or bitmap, if the operation succeeds, the changes
-//	are written immediately back to disk (the two files are kept
-//	open during all this time).  If the operation fails, and we have
-//	modified part of the directory and/or bitmap, we simply discard
-//	the changed version, without writing it back to disk. ???
+//	are written back through the journal (cf. journal.h), which
+//	commits the changes of many operations to a log on disk at once,
+//	and replays the log when the disk is mounted, so that a crash
+//	can't leave an operation half done.  If the operation fails, and
+//	we have modified part of the directory and/or bitmap, we undo the
+//	changes to the in-memory bitmap, and discard the changed directory.
+//
+//	Files grow when they are written past their end.  The sectors
+//	this takes are marked in the in-memory bitmap, but the bitmap
+//	and the file header are only written back when the last OpenFile
+//	on the file is closed (or the file system is synced), to batch up
+//	a run of small writes.
 //
 // 	Our implementation at this point has the following restrictions:
 //
 //	   there is no synchronization for concurrent accesses
-//	   files have a fixed size, set when the file is created
 //	   files cannot be bigger than about 3KB in size
-//	   there is no hierarchical directory structure, and only a limited
-//	     number of files can be added to the system
-//	   there is no attempt to make the system robust to failures
-//	    (if Nachos exits in the middle of an operation that modifies
-//	    the file system, it may corrupt the disk)
+//	   a directory can't hold more entries than fit in a file
+//	   file data isn't journaled, only metadata; an operation that
+//	    hadn't been committed yet when Nachos stopped is lost
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -45,12 +65,16 @@
 #ifndef FILESYS_STUB
 
 #include "copyright.h"
+#include "main.h"
 #include "debug.h"
 #include "disk.h"
 #include "pbitmap.h"
 #include "directory.h"
 #include "filehdr.h"
 #include "filesys.h"
+#include "hash.h"
+#include "list.h"
+#include "journal.h"
 
 // Sectors containing the file headers for the bitmap of free sectors,
 // and the directory of files.  These file headers are placed in well-known
@@ -58,13 +82,314 @@
 #define FreeMapSector 0
 #define DirectorySector 1
 
-// Initial file sizes for the bitmap and directory; until the file system
-// supports extensible files, the directory size sets the maximum number
-// of files that can be loaded onto the disk.
+// Initial file sizes for the bitmap and directories; a directory grows
+// when all of its entries are in use.
 #define FreeMapFileSize (NumSectors / BitsInByte)
 #define NumDirEntries 10
 #define DirectoryFileSize (sizeof(DirectoryEntry) * NumDirEntries)
 
+// How many path names the name cache remembers, and the longest one
+// it will remember.
+#define NameCacheSize 64
+#define NameCacheMaxPath 64
+
+// How many file headers no file is open on are kept in memory
+#define IdleHeaders 32
+
+// How many files the benchmark creates, and how big each is
+#define BenchFiles 100
+#define BenchFileSize 100
+
+// A directory that has been read into memory, together with the open
+// file it is stored in.  Once read, directories stay in memory until
+// they are removed.
+
+class CachedDirectory
+{
+public:
+    CachedDirectory(int hdrSector, OpenFile *dirFile)
+    {
+        sector = hdrSector;
+        file = dirFile;
+        directory = new Directory(0);
+        directory->FetchFrom(file);
+    }
+    ~CachedDirectory()
+    {
+        delete directory;
+        delete file;
+    }
+
+    int sector;           // Where the directory's file header is
+    OpenFile *file;       // The file holding the directory
+    Directory *directory; // Its contents
+};
+
+// A path name, as a key in the name cache.  Unlike the name of a
+// directory entry, the whole string is significant.
+
+class PathName
+{
+public:
+    PathName(char *p) { path = p; }
+    bool operator==(const PathName &other) const
+    {
+        return strcmp(path, other.path) == 0;
+    }
+
+    char *path;
+};
+
+// What the name cache remembers about one path: the sector holding
+// the header of the file it names, or -1 if it doesn't name a file
+// that can be opened (it doesn't exist, or is a directory).
+
+class CachedName
+{
+public:
+    char path[NameCacheMaxPath + 1]; // The path, normalized
+    int sector;                      // Its file header, or -1
+};
+
+// A kernel-wide cache from path names to file headers, so that opening
+// the same file again doesn't have to walk its path.  Paths that don't
+// name a file are remembered too, so looking for a file that isn't
+// there is just as quick.  When the cache is full, the name used least
+// recently is forgotten.
+
+class NameCache
+{
+public:
+    NameCache();
+    ~NameCache();
+
+    bool Lookup(char *name, int *sector); // Is "name" in the cache?
+    void Enter(char *name, int sector);   // Remember where "name" is
+    void Forget(char *name);              // "name" has been created
+                                          // or removed
+
+private:
+    static bool Normalize(char *name, char *path);
+    // Put "name" in a canonical form
+
+    HashTable<PathName, CachedName *> *table; // The names, by path
+    List<CachedName *> *lru;                  // The names, least
+                                              // recently used first
+    int hits, misses;                         // For debugging
+};
+
+//----------------------------------------------------------------------
+// NameKey, HashPath
+//	The functions the name cache needs: it is keyed by the whole
+//	(normalized) path name.
+//----------------------------------------------------------------------
+
+static PathName
+NameKey(CachedName *name)
+{
+    return PathName(name->path);
+}
+
+static unsigned
+HashPath(PathName key)
+{
+    unsigned hash = 5381;
+
+    for (char *p = key.path; *p != '\0'; p++)
+        hash = hash * 33 + *p;
+    return hash;
+}
+
+//----------------------------------------------------------------------
+// NameCache::NameCache, NameCache::~NameCache
+//	Initialize an empty name cache, and de-allocate one.
+//----------------------------------------------------------------------
+
+NameCache::NameCache()
+{
+    table = new HashTable<PathName, CachedName *>(NameKey, HashPath);
+    lru = new List<CachedName *>;
+    hits = misses = 0;
+}
+
+NameCache::~NameCache()
+{
+    DEBUG(dbgFile, "Name cache: " << hits << " hits, " << misses << " misses");
+    while (!lru->IsEmpty())
+    {
+        CachedName *name = lru->RemoveFront();
+
+        table->Remove(PathName(name->path));
+        delete name;
+    }
+    delete table;
+    delete lru;
+}
+
+//----------------------------------------------------------------------
+// NameCache::Normalize
+//	Copy "name" into "path" in the form the cache keeps it in: no
+//	leading, trailing or repeated '/', and each component truncated
+//	to FileNameMaxLen characters, as FileSystem::FindParent does.
+//	So "/dir//file" and "dir/file" are the same name.
+//
+//	Return FALSE if the result is too long to be cached.
+//
+//	"path" -- where to put it (NameCacheMaxPath + 1 bytes)
+//----------------------------------------------------------------------
+
+bool NameCache::Normalize(char *name, char *path)
+{
+    int length = 0, component;
+
+    for (;;)
+    {
+        while (*name == '/')
+            name++;
+        if (*name == '\0')
+            break;
+        if (length > 0)
+        {
+            if (length == NameCacheMaxPath)
+                return FALSE;
+            path[length++] = '/';
+        }
+        for (component = 0; *name != '\0' && *name != '/'; name++, component++)
+        {
+            if (component >= FileNameMaxLen)
+                continue;
+            if (length == NameCacheMaxPath)
+                return FALSE;
+            path[length++] = *name;
+        }
+    }
+    path[length] = '\0';
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// NameCache::Lookup
+//	Look up a path name in the cache.  If it is there, return TRUE,
+//	and put where its file header is (or -1) into "sector".
+//
+//	"name" -- the path name to look up
+//	"sector" -- where to put the sector of its file header
+//----------------------------------------------------------------------
+
+bool NameCache::Lookup(char *name, int *sector)
+{
+    char path[NameCacheMaxPath + 1];
+    CachedName *entry;
+
+    if (!Normalize(name, path) || !table->Find(PathName(path), &entry))
+    {
+        misses++;
+        return FALSE;
+    }
+    hits++;
+    lru->Remove(entry); // it's now the most recently used
+    lru->Append(entry);
+    *sector = entry->sector;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// NameCache::Enter
+//	Remember where the file header of a path name is, forgetting the
+//	least recently used name if the cache is full.
+//
+//	"name" -- the path name
+//	"sector" -- the sector of its file header, or -1 if it doesn't
+//		name a file
+//----------------------------------------------------------------------
+
+void NameCache::Enter(char *name, int sector)
+{
+    CachedName *entry = new CachedName;
+
+    if (!Normalize(name, entry->path))
+    {
+        delete entry; // too long to bother with
+        return;
+    }
+    entry->sector = sector;
+    Forget(entry->path);
+    if ((int)lru->NumInList() == NameCacheSize)
+    {
+        CachedName *victim = lru->RemoveFront();
+
+        table->Remove(PathName(victim->path));
+        delete victim;
+    }
+    table->Insert(entry);
+    lru->Append(entry);
+}
+
+//----------------------------------------------------------------------
+// NameCache::Forget
+//	A file has been created or removed; forget what the cache knew
+//	about its name.
+//
+//	Nothing else can be out of date: a directory can only be removed
+//	when it is empty, so no file below it is in the cache, and any
+//	path below it that wasn't a file still isn't one.
+//
+//	"name" -- the path name of the file
+//----------------------------------------------------------------------
+
+void NameCache::Forget(char *name)
+{
+    char path[NameCacheMaxPath + 1];
+    CachedName *entry;
+
+    if (Normalize(name, path) && table->Find(PathName(path), &entry))
+    {
+        table->Remove(PathName(path));
+        lru->Remove(entry);
+        delete entry;
+    }
+}
+
+// A file header that has been read into memory.  Every OpenFile on a
+// file shares the same one, so they all see the file grow; it is
+// written back when the last of them is closed, if it has changed.
+// It then stays in memory for a while, in case the file is opened
+// again.
+
+class CachedHeader
+{
+public:
+    int sector;      // Where the header is on disk
+    FileHeader *hdr; // The header itself
+    int refCount;    // How many OpenFiles are using it
+    bool dirty;      // Has it changed since it was written back?
+    bool removed;    // Was the file removed while it was open?
+};
+
+//----------------------------------------------------------------------
+// DirectoryKey, HeaderKey, HashSector
+//	The functions the tables of cached directories and file headers
+//	need: both are keyed by the sector holding the file header.
+//----------------------------------------------------------------------
+
+static int
+DirectoryKey(CachedDirectory *dir)
+{
+    return dir->sector;
+}
+
+static int
+HeaderKey(CachedHeader *header)
+{
+    return header->sector;
+}
+
+static unsigned
+HashSector(int sector)
+{
+    return (unsigned)sector;
+}
+
 //----------------------------------------------------------------------
 // FileSystem::FileSystem
 // 	Initialize the file system.  If format = TRUE, the disk has
@@ -81,19 +406,26 @@
 FileSystem::FileSystem(bool format)
 {
     DEBUG(dbgFile, "Initializing the file system.");
+    kernel->fileSystem = this; // the OpenFiles below share headers
+                               // through it
+    headers = new HashTable<int, CachedHeader *>(HeaderKey, HashSector);
+    idleHeaders = new ::List<CachedHeader *>;
+    journal = new Journal(format); // replays the log, if need be
     if (format)
     {
-        PersistentBitmap *freeMap = new PersistentBitmap(NumSectors);
         Directory *directory = new Directory(NumDirEntries);
         FileHeader *mapHdr = new FileHeader;
         FileHeader *dirHdr = new FileHeader;
 
         DEBUG(dbgFile, "Formatting the file system.");
+        freeMap = new PersistentBitmap(NumSectors);
 
         // First, allocate space for FileHeaders for the directory and bitmap
         // (make sure no one else grabs these!)
         freeMap->Mark(FreeMapSector);
         freeMap->Mark(DirectorySector);
+        for (int i = 0; i < LogSectors; i++)
+            freeMap->Mark(LogHeaderSector + i);
 
         // Second, allocate space for the data blocks containing the contents
         // of the directory and bitmap files.  There better be enough space!
@@ -132,7 +464,6 @@ FileSystem::FileSystem(bool format)
             freeMap->Print();
             directory->Print();
         }
-        delete freeMap;
         delete directory;
         delete mapHdr;
         delete dirHdr;
@@ -143,7 +474,14 @@ FileSystem::FileSystem(bool format)
         // the bitmap and directory; these are left open while Nachos is running
         freeMapFile = new OpenFile(FreeMapSector);
         directoryFile = new OpenFile(DirectorySector);
+        freeMap = new PersistentBitmap(freeMapFile, NumSectors);
     }
+    freeMapDirty = FALSE;
+
+    directories = new HashTable<int, CachedDirectory *>(DirectoryKey, HashSector);
+    root = new CachedDirectory(DirectorySector, directoryFile);
+    directories->Insert(root);
+    names = new NameCache;
 
     this->ListFile = new OpenFile *[20];
     for (int i = 0; i < 20; ++i)
@@ -155,9 +493,11 @@ FileSystem::FileSystem(bool format)
     this->Create("stdout", 0);
 
     this->ListFile[0] = this->Open("stdin");
-    this->ListFile[0]->fileName = "stdin";
+    this->ListFile[0]->fileName = new char[strlen("stdin") + 1]; // ~FileSystem
+    strcpy(this->ListFile[0]->fileName, "stdin");                  // deletes it
     this->ListFile[1] = this->Open("stdout");
-    this->ListFile[1]->fileName = "stdout";
+    this->ListFile[1]->fileName = new char[strlen("stdout") + 1];
+    strcpy(this->ListFile[1]->fileName, "stdout");
 }
 
 // Ham tim slot trong
@@ -186,25 +526,68 @@ FileSystem::~FileSystem()
         }
     }
     delete[] ListFile;
+    delete names;
 }
 
 //----------------------------------------------------------------------
 // FileSystem::Create
 // 	Create a file in the Nachos file system (similar to UNIX create).
-//	Since we can't increase the size of files dynamically, we have
-//	to give Create the initial size of the file.
+//	Files grow as they are written, so the initial size is usually
+//	0; a bigger one reserves the space up front.
+//
+//	"name" -- path name of file to be created
+//	"initialSize" -- size of file to be created
+//----------------------------------------------------------------------
+
+bool FileSystem::Create(char *name, int initialSize)
+{
+    bool success;
+
+    DEBUG(dbgFile, "Creating file " << name << " size " << initialSize);
+    names->Forget(name);
+    journal->BeginOp();
+    success = CreateEntry(name, initialSize, FALSE);
+    journal->EndOp();
+    return success;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::CreateDirectory
+// 	Create an empty directory (similar to UNIX mkdir).
+//
+//	"name" -- path name of directory to be created
+//----------------------------------------------------------------------
+
+bool FileSystem::CreateDirectory(char *name)
+{
+    bool success;
+
+    DEBUG(dbgFile, "Creating directory " << name);
+    names->Forget(name);
+    journal->BeginOp();
+    success = CreateEntry(name, DirectoryFileSize, TRUE);
+    journal->EndOp();
+    return success;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::CreateEntry
+// 	Create a file or directory.
 //
 //	The steps to create a file are:
+//	  Find the directory it goes in
 //	  Make sure the file doesn't already exist
 //        Allocate a sector for the file header
 // 	  Allocate space on disk for the data blocks for the file
 //	  Add the name to the directory
 //	  Store the new file header on disk
+//	  If it is a directory, store an empty directory in it
 //	  Flush the changes to the bitmap and the directory back to disk
 //
 //	Return TRUE if everything goes ok, otherwise, return FALSE.
 //
 // 	Create fails if:
+//		some directory along the path doesn't exist
 //   		file is already in directory
 //	 	no free space for file header
 //	 	no free entry for file in directory
@@ -213,51 +596,69 @@ FileSystem::~FileSystem()
 // 	Note that this implementation assumes there is no concurrent access
 //	to the file system!
 //
-//	"name" -- name of file to be created
+//	"name" -- path name of file to be created
 //	"initialSize" -- size of file to be created
+//	"isDirectory" -- is it a directory?
 //----------------------------------------------------------------------
 
-bool FileSystem::Create(char *name, int initialSize)
+bool FileSystem::CreateEntry(char *name, int initialSize, bool isDirectory)
 {
+    CachedDirectory *parent;
     Directory *directory;
-    PersistentBitmap *freeMap;
     FileHeader *hdr;
+    OpenFile *newFile;
+    char leaf[FileNameMaxLen + 1];
     int sector;
     bool success;
 
-    DEBUG(dbgFile, "Creating file " << name << " size " << initialSize);
-
-    directory = new Directory(NumDirEntries);
-    directory->FetchFrom(directoryFile);
+    parent = FindParent(name, leaf);
+    if (parent == NULL || leaf[0] == '\0')
+        return FALSE; // no such directory
+    directory = parent->directory;
 
-    if (directory->Find(name) != -1)
+    if (directory->Find(leaf) != -1)
         success = FALSE; // file is already in directory
     else
     {
-        freeMap = new PersistentBitmap(freeMapFile, NumSectors);
         sector = freeMap->FindAndSet(); // find a sector to hold the file header
         if (sector == -1)
             success = FALSE; // no free block for file header
-        else if (!directory->Add(name, sector))
+        else if (!directory->Add(leaf, sector, isDirectory))
+        {
+            freeMap->Clear(sector);
             success = FALSE; // no space in directory
+        }
         else
         {
             hdr = new FileHeader;
             if (!hdr->Allocate(freeMap, initialSize))
+            {
+                directory->Remove(leaf);
+                freeMap->Clear(sector);
                 success = FALSE; // no space on disk for data
+            }
             else
             {
                 success = TRUE;
                 // everthing worked, flush all changes back to disk
                 hdr->WriteBack(sector);
-                directory->WriteBack(directoryFile);
-                freeMap->WriteBack(freeMapFile);
+                if (isDirectory)
+                {
+                    Directory *empty = new Directory(NumDirEntries);
+
+                    newFile = new OpenFile(sector);
+                    empty->WriteBack(newFile);
+                    delete newFile;
+                    delete empty;
+                }
+                directory->WriteBack(parent->file);
+                parent->file->Flush(); // in case the directory grew
+                freeMapDirty = TRUE;
+                FlushFreeMap();
             }
             delete hdr;
         }
-        delete freeMap;
     }
-    delete directory;
     return success;
 }
 
@@ -265,87 +666,424 @@ bool FileSystem::Create(char *name, int initialSize)
 // FileSystem::Open
 // 	Open a file for reading and writing.
 //	To open a file:
-//	  Find the ader, using the directory
+//	  Find the header, in the name cache or else by using the
+//	    directories along its path
 //	  Bring the header into memory
 //
-//	"name" -- the text name of the file to be opened
+//	Directories can't be opened this way.
+//
+//	"name" -- the path name of the file to be opened
 //----------------------------------------------------------------------
 
 OpenFile *
 FileSystem::Open(char *name)
 {
-    int freeSlot = this->FindFreeSlot();
-    Directory *directory = new Directory(NumDirEntries);
-    OpenFile *openFile = NULL;
+    CachedDirectory *parent;
+    char leaf[FileNameMaxLen + 1];
     int sector;
 
     DEBUG(dbgFile, "Opening file" << name);
-    directory->FetchFrom(directoryFile);
-    sector = directory->Find(name);
-    if (sector >= 0)
-        openFile = new OpenFile(sector); // name was found in directory
-    delete directory;
-    return ListFile[freeSlot]; // return NULL if not found
+    if (!names->Lookup(name, &sector))
+    {
+        sector = -1;
+        parent = FindParent(name, leaf);
+        if (parent != NULL && leaf[0] != '\0' &&
+            !parent->directory->IsDirectory(leaf))
+            sector = parent->directory->Find(leaf);
+        names->Enter(name, sector);
+    }
+    if (sector == -1)
+        return NULL; // not found
+    return new OpenFile(sector); // name was found in directory
 }
 
 //----------------------------------------------------------------------
 // FileSystem::Remove
-// 	Delete a file from the file system.  This requires:
-//	    Remove it from the directory
+// 	Delete a file, or an empty directory, from the file system.
+//	This requires:
+//	    Remove it from its directory
 //	    Delete the space for its header
 //	    Delete the space for its data blocks
 //	    Write changes to directory, bitmap back to disk
 //
+//	If the file is open, its space is only given back when the last
+//	OpenFile on it is closed.
+//
 //	Return TRUE if the file was deleted, FALSE if the file wasn't
-//	in the file system.
+//	in the file system (or is a directory with files in it).
 //
-//	"name" -- the text name of the file to be removed
+//	"name" -- the path name of the file to be removed
 //----------------------------------------------------------------------
 
 bool FileSystem::Remove(char *name)
 {
+    bool success;
+
+    journal->BeginOp();
+    success = RemoveEntry(name);
+    journal->EndOp();
+    return success;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::RemoveEntry
+// 	Do the work of Remove, as part of a journaled operation.
+//
+//	"name" -- the path name of the file to be removed
+//----------------------------------------------------------------------
+
+bool FileSystem::RemoveEntry(char *name)
+{
+    CachedDirectory *parent, *dir;
     Directory *directory;
-    PersistentBitmap *freeMap;
-    FileHeader *fileHdr;
+    char leaf[FileNameMaxLen + 1];
     int sector;
 
-    directory = new Directory(NumDirEntries);
-    directory->FetchFrom(directoryFile);
-    sector = directory->Find(name);
+    parent = FindParent(name, leaf);
+    if (parent == NULL || leaf[0] == '\0')
+        return FALSE; // no such directory, or the root
+    directory = parent->directory;
+    sector = directory->Find(leaf);
     if (sector == -1)
-    {
-        delete directory;
         return FALSE; // file not found
+    names->Forget(name);
+    if (directory->IsDirectory(leaf))
+    {
+        dir = LoadDirectory(sector);
+        if (!dir->directory->IsEmpty())
+            return FALSE; // directory not empty
+        directories->Remove(sector);
+        delete dir;
     }
-    fileHdr = new FileHeader;
-    fileHdr->FetchFrom(sector);
+    directory->Remove(leaf);
+    directory->WriteBack(parent->file); // flush to disk
 
-    freeMap = new PersistentBitmap(freeMapFile, NumSectors);
+    OpenHeader(sector);
+    FindHeader(sector)->removed = TRUE;
+    CloseHeader(sector); // give back its space, unless it's open
+    return TRUE;
+}
 
-    fileHdr->Deallocate(freeMap); // remove data blocks
-    freeMap->Clear(sector);       // remove header block
-    directory->Remove(name);
+//----------------------------------------------------------------------
+// FileSystem::FindParent
+// 	Walk down the directory tree along the path "name", and return
+//	the directory that holds (or would hold) its last component.
+//	The last component is copied into "leaf"; it is empty if the
+//	path names the root.
+//
+//	Return NULL if some directory along the way doesn't exist.
+//
+//	"name" -- the path name to look up
+//	"leaf" -- where to put the last component (FileNameMaxLen + 1 bytes)
+//----------------------------------------------------------------------
+
+CachedDirectory *
+FileSystem::FindParent(char *name, char *leaf)
+{
+    CachedDirectory *dir = root;
+    char *end;
+    int length, sector;
 
-    freeMap->WriteBack(freeMapFile);     // flush to disk
-    directory->WriteBack(directoryFile); // flush to disk
-    delete fileHdr;
-    delete directory;
-    delete freeMap;
+    for (;;)
+    {
+        while (*name == '/')
+            name++;
+        end = name;
+        while (*end != '\0' && *end != '/')
+            end++;
+        length = end - name;
+        if (length > FileNameMaxLen)
+            length = FileNameMaxLen; // truncate, as Directory does
+        strncpy(leaf, name, length);
+        leaf[length] = '\0';
+
+        while (*end == '/')
+            end++;
+        if (*end == '\0')
+            return dir; // that was the last component
+
+        sector = dir->directory->Find(leaf);
+        if (sector == -1 || !dir->directory->IsDirectory(leaf))
+            return NULL;
+        dir = LoadDirectory(sector);
+        name = end;
+    }
+}
+
+//----------------------------------------------------------------------
+// FileSystem::LoadDirectory
+// 	Return the directory whose file header is in "sector", reading
+//	it into memory if this is the first time it has been used.
+//----------------------------------------------------------------------
+
+CachedDirectory *
+FileSystem::LoadDirectory(int sector)
+{
+    CachedDirectory *dir;
+
+    if (!directories->Find(sector, &dir))
+    {
+        CachedDirectory *other;
+
+        DEBUG(dbgFile, "Reading in directory at sector " << sector);
+        dir = new CachedDirectory(sector, new OpenFile(sector));
+        if (directories->Find(sector, &other))
+        { // someone else read it in while we waited for the disk
+            delete dir;
+            return other;
+        }
+        directories->Insert(dir);
+    }
+    return dir;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::OpenHeader
+// 	Return the in-memory copy of the file header in "sector", reading
+//	it from disk only if no one has it in memory.  Each call must be
+//	matched by a call to CloseHeader.
+//
+//	"sector" -- where the file header is on disk
+//----------------------------------------------------------------------
+
+FileHeader *
+FileSystem::OpenHeader(int sector)
+{
+    CachedHeader *header;
+
+    if (headers->Find(sector, &header))
+    {
+        if (header->refCount == 0)
+            idleHeaders->Remove(header);
+    }
+    else
+    {
+        FileHeader *hdr = new FileHeader;
+
+        hdr->FetchFrom(sector);
+        if (headers->Find(sector, &header))
+        { // someone else read it in while we waited for the disk
+            delete hdr;
+            if (header->refCount == 0)
+                idleHeaders->Remove(header);
+        }
+        else
+        {
+            header = new CachedHeader;
+            header->sector = sector;
+            header->hdr = hdr;
+            header->refCount = 0;
+            header->dirty = FALSE;
+            header->removed = FALSE;
+            headers->Insert(header);
+        }
+    }
+    header->refCount++;
+    return header->hdr;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::CloseHeader
+// 	An OpenFile is done with the file header in "sector".  If it
+//	was the last one using it, write the header back if it changed,
+//	or if the file has been removed, give back its space.
+//
+//	"sector" -- where the file header is on disk
+//----------------------------------------------------------------------
+
+void FileSystem::CloseHeader(int sector)
+{
+    CachedHeader *header = FindHeader(sector);
+
+    ASSERT(header->refCount > 0);
+    if (--header->refCount > 0)
+        return;
+    if (header->removed)
+    {
+        journal->BeginOp();
+        header->hdr->Deallocate(freeMap); // remove data blocks
+        freeMap->Clear(sector);           // remove header block
+        freeMapDirty = TRUE;
+        FlushFreeMap();
+        journal->EndOp();
+        headers->Remove(sector);
+        delete header->hdr;
+        delete header;
+        return;
+    }
+    WriteHeader(header);
+    idleHeaders->Append(header);
+    if ((int)idleHeaders->NumInList() > IdleHeaders)
+    {
+        header = idleHeaders->RemoveFront(); // least recently closed
+        headers->Remove(header->sector);
+        delete header->hdr;
+        delete header;
+    }
+}
+
+//----------------------------------------------------------------------
+// FileSystem::FindHeader
+// 	Return the file header in "sector", which must be in memory.
+//----------------------------------------------------------------------
+
+CachedHeader *
+FileSystem::FindHeader(int sector)
+{
+    CachedHeader *header = NULL;
+
+    headers->Find(sector, &header);
+    ASSERT(header != NULL);
+    return header;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::Extend
+// 	Grow an open file to "newSize" bytes, allocating sectors for it
+//	out of the in-memory bitmap.  Neither the bitmap nor the file
+//	header is written back until the header is flushed.
+//
+//	Return FALSE if the file can't grow that big.
+//
+//	"sector" -- where the file header is on disk
+//	"newSize" -- the new length of the file, in bytes
+//----------------------------------------------------------------------
+
+bool FileSystem::Extend(int sector, int newSize)
+{
+    CachedHeader *header = FindHeader(sector);
+
+    if (!header->hdr->Extend(freeMap, newSize))
+        return FALSE;
+    header->dirty = TRUE;
+    freeMapDirty = TRUE;
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// FileSystem::FlushHeader
+// 	Write the file header in "sector" back to disk, if it changed.
+//----------------------------------------------------------------------
+
+void FileSystem::FlushHeader(int sector)
+{
+    WriteHeader(FindHeader(sector));
+}
+
+//----------------------------------------------------------------------
+// FileSystem::WriteHeader
+// 	If a file header has changed since it was last written back,
+//	give back the sectors the file allocated ahead of need, and
+//	write the bitmap and the header back to disk.
+//----------------------------------------------------------------------
+
+void FileSystem::WriteHeader(CachedHeader *header)
+{
+    if (header->dirty)
+    {
+        journal->BeginOp();
+        if (header->hdr->Trim(freeMap))
+            freeMapDirty = TRUE;
+        FlushFreeMap();
+        header->hdr->WriteBack(header->sector);
+        header->dirty = FALSE;
+        journal->EndOp();
+    }
+}
+
+//----------------------------------------------------------------------
+// FileSystem::FlushFreeMap
+// 	Write the in-memory bitmap back to disk, if it has changed.
+//----------------------------------------------------------------------
+
+void FileSystem::FlushFreeMap()
+{
+    if (freeMapDirty)
+    {
+        freeMap->WriteBack(freeMapFile);
+        freeMapDirty = FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// FileSystem::Sync
+// 	Write back everything the file system is holding in memory:
+//	the headers of files that have grown, the bitmap, and the
+//	changes waiting in the journal.
+//	Called when Nachos halts, since open files are never closed.
+//----------------------------------------------------------------------
+
+void FileSystem::Sync()
+{
+    HashIterator<int, CachedHeader *> iter(headers);
+
+    for (; !iter.IsDone(); iter.Next())
+        WriteHeader(iter.Item());
+    journal->BeginOp();
+    FlushFreeMap();
+    journal->EndOp();
+    journal->Sync();
+}
+
+//----------------------------------------------------------------------
+// FileSystem::ReadSector, FileSystem::WriteSector
+// 	Read or write a sector of a file or file header.  These go
+//	through the journal, so that changes to metadata are logged,
+//	and reads see changes that haven't reached their home on disk.
+//
+//	"sectorNumber" -- the disk sector to read or write
+//	"data" -- the contents of the disk sector
+//----------------------------------------------------------------------
+
+void FileSystem::ReadSector(int sectorNumber, char *data)
+{
+    journal->ReadSector(sectorNumber, data);
+}
+
+void FileSystem::WriteSector(int sectorNumber, char *data)
+{
+    journal->WriteSector(sectorNumber, data);
+}
+
+//----------------------------------------------------------------------
+// FileSystem::ReadSectors, FileSystem::WriteSectors
+// 	Read or write several sectors of a file at once, through the
+//	journal, with as few disk requests as possible.
+//
+//	"numSectors" -- how many sectors to read or write
+//	"sectorNumbers" -- which ones
+//	"data" -- their contents, one after another
+//----------------------------------------------------------------------
+
+void FileSystem::ReadSectors(int numSectors, int *sectorNumbers, char *data)
+{
+    journal->ReadSectors(numSectors, sectorNumbers, data);
+}
+
+void FileSystem::WriteSectors(int numSectors, int *sectorNumbers, char *data)
+{
+    journal->WriteSectors(numSectors, sectorNumbers, data);
+}
+
 //----------------------------------------------------------------------
 // FileSystem::List
-// 	List all the files in the file system directory.
+// 	List all the files in a directory.
+//
+//	"name" -- the path name of the directory
 //----------------------------------------------------------------------
 
-void FileSystem::List()
+void FileSystem::List(char *name)
 {
-    Directory *directory = new Directory(NumDirEntries);
+    CachedDirectory *parent;
+    char leaf[FileNameMaxLen + 1];
 
-    directory->FetchFrom(directoryFile);
-    directory->List();
-    delete directory;
+    parent = FindParent(name, leaf);
+    if (parent != NULL && leaf[0] == '\0')
+        parent->directory->List(); // the root
+    else if (parent != NULL && parent->directory->IsDirectory(leaf))
+        LoadDirectory(parent->directory->Find(leaf))->directory->List();
+    else
+        printf("List: %s is not a directory\n", name);
 }
 
 //----------------------------------------------------------------------
@@ -362,8 +1100,6 @@ void FileSystem::Print()
 {
     FileHeader *bitHdr = new FileHeader;
     FileHeader *dirHdr = new FileHeader;
-    PersistentBitmap *freeMap = new PersistentBitmap(freeMapFile, NumSectors);
-    Directory *directory = new Directory(NumDirEntries);
 
     printf("Bit map file header:\n");
     bitHdr->FetchFrom(FreeMapSector);
@@ -375,13 +1111,63 @@ void FileSystem::Print()
 
     freeMap->Print();
 
-    directory->FetchFrom(directoryFile);
-    directory->Print();
+    root->directory->Print();
 
     delete bitHdr;
     delete dirHdr;
-    delete freeMap;
-    delete directory;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::Benchmark
+// 	Measure how fast small files can be created: make BenchFiles
+//	files of BenchFileSize bytes in a new directory, sync, and print
+//	the cost per file in simulated time, disk writes and real time.
+//	Everything is removed again afterwards.
+//----------------------------------------------------------------------
+
+void FileSystem::Benchmark()
+{
+    char name[32], data[BenchFileSize];
+    OpenFile *file;
+    int startTicks, startWrites, i;
+    double start;
+
+    if (!CreateDirectory("/fsbench"))
+    {
+        printf("File creation benchmark: can't create /fsbench\n");
+        return;
+    }
+    memset(data, 'x', sizeof(data));
+
+    startTicks = kernel->stats->totalTicks;
+    startWrites = kernel->stats->numDiskWrites;
+    start = WallTime();
+    for (i = 0; i < BenchFiles; i++)
+    {
+        sprintf(name, "/fsbench/f%d", i);
+        bool created = Create(name, 0);
+        ASSERT(created);
+        file = Open(name);
+        ASSERT(file != NULL);
+        file->Write(data, sizeof(data));
+        delete file;
+    }
+    Sync();
+    cout << "File creation benchmark, " << BenchFiles << " files of "
+         << BenchFileSize << " bytes\n";
+    cout << "per file: " << (kernel->stats->totalTicks - startTicks) / BenchFiles
+         << " ticks, "
+         << (double)(kernel->stats->numDiskWrites - startWrites) / BenchFiles
+         << " disk writes, "
+         << (WallTime() - start) * 1e6 / BenchFiles << " us\n";
+
+    for (i = 0; i < BenchFiles; i++)
+    {
+        sprintf(name, "/fsbench/f%d", i);
+        Remove(name);
+    }
+    Remove("/fsbench");
+    Sync();
 }
 
 #endif // FILESYS_STUB
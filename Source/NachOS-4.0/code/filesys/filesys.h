@@ -20,13 +20,13 @@
 //	file system (in a file named "DISK").
 //
 //	In the "real" implementation, there are two key data structures used
-//	in the file system.  There is a single "root" directory, listing
-//	all of the files in the file system; unlike UNIX, the baseline
-//	system does not provide a hierarchical directory structure.
-//	In addition, there is a bitmap for allocating
-//	disk sectors.  Both the root directory and the bitmap are themselves
-//	stored as files in the Nachos file system -- this causes an interesting
-//	bootstrap problem when the simulated disk is initialized.
+//	in the file system.  There is a tree of directories, as in UNIX,
+//	starting from a "root" directory; files are named by their path
+//	from the root, such as "/dir/file".  In addition, there is a
+//	bitmap for allocating disk sectors.  Both the directories and the
+//	bitmap are themselves stored as files in the Nachos file system --
+//	this causes an interesting bootstrap problem when the simulated
+//	disk is initialized.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -109,6 +109,14 @@ public:
 };
 
 #else // FILESYS
+class FileHeader;
+class PersistentBitmap;
+class CachedDirectory;
+class CachedHeader;
+class Journal;
+class NameCache;
+template <class Key, class T> class HashTable;
+template <class T> class List;
 
 class FileSystem
 {
@@ -125,22 +133,80 @@ public:
 	bool Create(char *name, int initialSize);
 	// Create a file (UNIX creat)
 
+	bool CreateDirectory(char *name); // Create a directory (UNIX mkdir)
+
 	OpenFile *Open(char *name); // Open a file (UNIX open)
 
-	bool Remove(char *name); // Delete a file (UNIX unlink)
+	bool Remove(char *name); // Delete a file or empty directory
+							 // (UNIX unlink, rmdir)
 
-	void List(); // List all the files in the file system
+	void List(char *name); // List all the files in a directory
 
 	void Print(); // List all the files and their contents
 
+	void Benchmark(); // Time the creation of small files
+
 	int FindFreeSlot();
 	~FileSystem();
 
+	FileHeader *OpenHeader(int sector); // Share the in-memory copy
+										// of a file header
+	void CloseHeader(int sector);		// Done with it
+
+	bool Extend(int sector, int newSize); // Grow an open file
+
+	void FlushHeader(int sector); // Write a file header back
+								  // to disk, if it changed
+
+	void Sync(); // Write back everything still
+				 // cached in memory
+
+	void ReadSector(int sectorNumber, char *data);
+	void WriteSector(int sectorNumber, char *data);
+	// Read/write a sector of a file,
+	// through the journal
+	void ReadSectors(int numSectors, int *sectorNumbers, char *data);
+	void WriteSectors(int numSectors, int *sectorNumbers, char *data);
+	// Read/write several at once
+
 private:
+	bool CreateEntry(char *name, int initialSize, bool isDirectory);
+	// Create a file or directory
+
+	CachedDirectory *FindParent(char *name, char *leaf);
+	// Find the directory holding
+	// the last component of a path
+
+	CachedDirectory *LoadDirectory(int sector); // Bring a directory
+												// into memory
+
+	bool RemoveEntry(char *name); // Remove a file or directory
+
+	CachedHeader *FindHeader(int sector); // Find an open file header
+
+	void WriteHeader(CachedHeader *header); // Write a file header
+											// back, if changed
+
+	void FlushFreeMap(); // Write the free map back, if changed
+
 	OpenFile *freeMapFile;	 // Bit map of free disk blocks,
 							 // represented as a file
 	OpenFile *directoryFile; // "Root" directory -- list of
 							 // file names, represented as a file
+	CachedDirectory *root;	 // The root directory, in memory
+	HashTable<int, CachedDirectory *> *directories;
+	// Every directory read into memory,
+	// by the sector of its file header
+	Journal *journal;		   // Log of changes to metadata
+	NameCache *names;		   // Where recently opened files are
+	HashTable<int, CachedHeader *> *headers;
+	// Every file header in memory,
+	// by the sector it lives in
+	::List<CachedHeader *> *idleHeaders; // The ones no file is open
+									   // on, least recent first
+	PersistentBitmap *freeMap; // In-memory copy of the bit map
+	bool freeMapDirty;		   // Has freeMap changed since it
+							   // was last written back?
 };
 
 #endif // FILESYS
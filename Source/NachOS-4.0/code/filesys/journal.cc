@@ -0,0 +1,568 @@
+// journal.cc
+//	Routines to keep a write-ahead log of file system metadata.
+//
+//	The log on disk is a header, holding the number of sectors in
+//	the last commit and where each of them belongs, followed by their
+//	contents.  A commit writes the contents first, and the header
+//	last -- the sector with the count in it very last; once that is
+//	on disk, the commit is done.  After the contents have been copied
+//	to their homes, an empty header is written, so they won't be
+//	copied again.
+//
+//	In memory there are two transactions: the running one, that
+//	operations add their changes to, and the committed one, that is
+//	on disk in the log and waiting to be checkpointed.  Reads look
+//	in both, so that they see changes that aren't home yet.
+//
+//	The running transaction is committed when there might not be
+//	room in the log for another operation, when it has been waiting
+//	for CommitDelay ticks, or when the file system is synced.  There
+//	can only be one commit in the log at a time, so a commit first
+//	checkpoints the one before it, if the background thread hasn't
+//	got to it yet.
+//
+//	The lock is only held to look at and change the transactions in
+//	memory, never while waiting for the disk, so that reads and
+//	writes of file data can be at the disk at the same time as each
+//	other, and as a commit or checkpoint.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "journal.h"
+#include "synchdisk.h"
+#include "synch.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// Transaction::Transaction, Transaction::~Transaction
+//	Initialize an empty transaction, and de-allocate one.
+//----------------------------------------------------------------------
+
+Transaction::Transaction()
+{
+    numSectors = 0;
+    data = new char[LogSize * SectorSize];
+}
+
+Transaction::~Transaction()
+{
+    delete [] data;
+}
+
+//----------------------------------------------------------------------
+// Transaction::Find
+//	Return where in the transaction a sector is kept, or -1 if it
+//	isn't part of it.
+//----------------------------------------------------------------------
+
+int
+Transaction::Find(int sectorNumber)
+{
+    for (int i = 0; i < numSectors; i++)
+	if (sector[i] == sectorNumber)
+	    return i;
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// Journal::Journal
+//	Initialize the log.  If the disk is being formatted, the log
+//	region is just emptied; otherwise, any commit that wasn't
+//	checkpointed before Nachos stopped is replayed.  The caller
+//	must keep the log region out of the bitmap of free sectors.
+//
+//	"format" -- is the disk being formatted?
+//----------------------------------------------------------------------
+
+Journal::Journal(bool format)
+{
+    lock = new Lock("journal");
+    opEnded = new Condition("journal op ended");
+    logIdle = new Condition("journal log idle");
+    wakeup = new Semaphore("journal wakeup", 0);
+    inOp = new List<OpThread *>;
+    outstanding = 0;
+    timerSet = FALSE;
+    commitDue = FALSE;
+    busy = FALSE;
+    running = new Transaction;
+    committed = new Transaction;
+    numCommits = numLogged = numAbsorbed = 0;
+
+    if (format)
+	WriteLogHeader(committed);	// empty
+    else
+	Recover();
+
+    Thread *t = new Thread("checkpoint");
+    t->Fork(Checkpointer, (void *) this);
+}
+
+//----------------------------------------------------------------------
+// Journal::~Journal
+//	De-allocate the log.  Anything not yet synced is lost.
+//----------------------------------------------------------------------
+
+Journal::~Journal()
+{
+    delete lock;
+    delete opEnded;
+    delete logIdle;
+    delete wakeup;
+    delete inOp;
+    delete running;
+    delete committed;
+}
+
+//----------------------------------------------------------------------
+// Journal::Recover
+//	Copy the last commit in the log to where it belongs, in case
+//	Nachos stopped before it was checkpointed.  Copying it again
+//	if it was is harmless.
+//----------------------------------------------------------------------
+
+void
+Journal::Recover()
+{
+    int header[LogHeaderSectors * SectorSize / sizeof(int)];
+    int where[LogHeaderSectors > LogSize ? LogHeaderSectors : LogSize];
+    int i;
+
+    for (i = 0; i < LogHeaderSectors; i++)
+	where[i] = LogHeaderSector + i;
+    kernel->synchDisk->ReadSectors(LogHeaderSectors, where, (char *) header);
+    if (header[0] <= 0 || header[0] > LogSize)
+	return;				// nothing to replay
+    DEBUG(dbgFile, "Replaying " << header[0] << " sectors from the log");
+    for (i = 0; i < header[0]; i++)
+	where[i] = LogStart + i;
+    kernel->synchDisk->ReadSectors(header[0], where, committed->data);
+    kernel->synchDisk->WriteSectors(header[0], &header[1], committed->data);
+    WriteLogHeader(committed);		// empty
+}
+
+//----------------------------------------------------------------------
+// Journal::BeginOp
+//	Start an operation that changes metadata.  Until the matching
+//	EndOp, the sectors written by this thread are kept in the
+//	running transaction.  Wait until there is room in the log for
+//	another operation; if no operation is going on, make room by
+//	committing.
+//
+//	Operations can be nested; only the outermost one counts.
+//----------------------------------------------------------------------
+
+void
+Journal::BeginOp()
+{
+    OpThread *op;
+
+    lock->Acquire();
+    if ((op = FindOp()) == NULL) {
+	while (running->numSectors + (outstanding + 1) * MaxOpSectors
+							> LogSize) {
+	    if (outstanding == 0) {
+		Commit();
+		wakeup->V();		// checkpoint it
+	    } else
+		opEnded->Wait(lock);
+	}
+	op = new OpThread;
+	op->thread = kernel->currentThread;
+	op->depth = 0;
+	inOp->Append(op);
+	outstanding++;
+    }
+    op->depth++;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// Journal::EndOp
+//	Finish an operation.  When the last one going on ends, the
+//	running transaction is committed if it is due, or if the log
+//	might not have room for another operation; otherwise, a commit
+//	is scheduled for later, so that more operations can share it.
+//----------------------------------------------------------------------
+
+void
+Journal::EndOp()
+{
+    OpThread *op;
+
+    lock->Acquire();
+    op = FindOp();
+    ASSERT(op != NULL);
+    if (--op->depth == 0) {
+	inOp->Remove(op);
+	delete op;
+	outstanding--;
+	if (outstanding == 0) {
+	    if (commitDue ||
+		running->numSectors + MaxOpSectors > LogSize) {
+		Commit();
+		wakeup->V();		// checkpoint it
+	    } else if (running->numSectors > 0 && !timerSet) {
+		timerSet = TRUE;
+		kernel->interrupt->Schedule(this, CommitDelay, DiskInt);
+	    }
+	}
+	opEnded->Broadcast(lock);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// Journal::ReadSector
+//	Read a sector, from the running or committed transaction if it
+//	is in one, otherwise from disk.
+//
+//	"sectorNumber" -- the disk sector to read
+//	"data" -- the buffer to hold the contents of the disk sector
+//----------------------------------------------------------------------
+
+void
+Journal::ReadSector(int sectorNumber, char *data)
+{
+    ReadSectors(1, &sectorNumber, data);
+}
+
+//----------------------------------------------------------------------
+// Journal::ReadSectors
+//	Read several sectors.  Those that are in the running or committed
+//	transaction are copied from there; all the rest are read from
+//	disk with a single request, without holding the lock.
+//
+//	"numSectors" -- how many sectors to read
+//	"sectorNumbers" -- which ones
+//	"data" -- the buffer to hold their contents, one after another
+//----------------------------------------------------------------------
+
+void
+Journal::ReadSectors(int numSectors, int *sectorNumbers, char *data)
+{
+    int *missing = new int[numSectors];	// the ones to read from disk
+    int *where = new int[numSectors];	// where each of them goes
+    int numMissing = 0;
+    char *buf;
+    int i, j;
+
+    lock->Acquire();
+    for (i = 0; i < numSectors; i++) {
+	if ((j = running->Find(sectorNumbers[i])) != -1)
+	    bcopy(&running->data[j * SectorSize], &data[i * SectorSize],
+		  SectorSize);
+	else if ((j = committed->Find(sectorNumbers[i])) != -1)
+	    bcopy(&committed->data[j * SectorSize], &data[i * SectorSize],
+		  SectorSize);
+	else {
+	    missing[numMissing] = sectorNumbers[i];
+	    where[numMissing++] = i;
+	}
+    }
+    lock->Release();
+
+    if (numMissing == numSectors)
+	kernel->synchDisk->ReadSectors(numSectors, sectorNumbers, data);
+    else if (numMissing > 0) {
+	buf = new char[numMissing * SectorSize];
+	kernel->synchDisk->ReadSectors(numMissing, missing, buf);
+	for (j = 0; j < numMissing; j++)
+	    bcopy(&buf[j * SectorSize], &data[where[j] * SectorSize],
+		  SectorSize);
+	delete [] buf;
+    }
+    delete [] missing;
+    delete [] where;
+}
+
+//----------------------------------------------------------------------
+// Journal::WriteSector
+//	Write a sector.  Inside an operation, it is added to the running
+//	transaction.  Otherwise it goes straight to disk -- but if some
+//	transaction still holds an old copy (the sector used to belong to
+//	something else), that copy is changed too, so that it doesn't
+//	overwrite the new contents when it is checkpointed, or replayed.
+//
+//	"sectorNumber" -- the disk sector to be written
+//	"data" -- the new contents of the disk sector
+//----------------------------------------------------------------------
+
+void
+Journal::WriteSector(int sectorNumber, char *data)
+{
+    WriteSectors(1, &sectorNumber, data);
+}
+
+//----------------------------------------------------------------------
+// Journal::WriteSectors
+//	Write several sectors, as WriteSector does.  Outside of an
+//	operation, they go to disk with a single request, without holding
+//	the lock -- but first, if one of them is in the committed
+//	transaction, wait until that isn't being written, and put the new
+//	contents in the log too, before they go home.
+//
+//	"numSectors" -- how many sectors to write
+//	"sectorNumbers" -- which ones
+//	"data" -- their new contents, one after another
+//----------------------------------------------------------------------
+
+void
+Journal::WriteSectors(int numSectors, int *sectorNumbers, char *data)
+{
+    int *slots = new int[numSectors];	// log sectors holding old copies
+    char *from;
+    bool logged;
+    int numSlots = 0;
+    int i, j;
+
+    lock->Acquire();
+    logged = (FindOp() != NULL);
+    while (!logged && busy && IsCommitted(numSectors, sectorNumbers))
+	logIdle->Wait(lock);
+    for (i = 0; i < numSectors; i++) {
+	from = &data[i * SectorSize];
+	if (logged) {
+	    if ((j = running->Find(sectorNumbers[i])) != -1)
+		numAbsorbed++;
+	    else {
+		ASSERT(running->numSectors < LogSize);
+		j = running->numSectors++;
+		running->sector[j] = sectorNumbers[i];
+	    }
+	    bcopy(from, &running->data[j * SectorSize], SectorSize);
+	} else {
+	    if ((j = running->Find(sectorNumbers[i])) != -1)
+		bcopy(from, &running->data[j * SectorSize], SectorSize);
+	    if ((j = committed->Find(sectorNumbers[i])) != -1) {
+		bcopy(from, &committed->data[j * SectorSize], SectorSize);
+		slots[numSlots++] = LogStart + j;
+	    }
+	}
+    }
+    if (numSlots > 0)
+	RewriteLog(numSlots, slots);
+    lock->Release();
+
+    if (!logged)
+	kernel->synchDisk->WriteSectors(numSectors, sectorNumbers, data);
+    delete [] slots;
+}
+
+//----------------------------------------------------------------------
+// Journal::Sync
+//	Commit the running transaction, and checkpoint it, so that
+//	everything is home on disk.  If an operation is still going on,
+//	its changes can't be committed yet.
+//----------------------------------------------------------------------
+
+void
+Journal::Sync()
+{
+    lock->Acquire();
+    if (outstanding == 0)
+	Commit();
+    Checkpoint();
+    DEBUG(dbgFile, "Journal: " << numCommits << " commits, " << numLogged
+	  << " sectors logged, " << numAbsorbed << " writes absorbed");
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// Journal::CallBack
+//	The running transaction has waited long enough; have the
+//	background thread commit it.  Called from the interrupt handler.
+//----------------------------------------------------------------------
+
+void
+Journal::CallBack()
+{
+    timerSet = FALSE;
+    commitDue = TRUE;
+    wakeup->V();
+}
+
+//----------------------------------------------------------------------
+// Journal::Commit
+//	Write the running transaction to the log: first the contents,
+//	then the header that makes it count.  It becomes the committed
+//	transaction at once, so that operations can go on adding to a new
+//	running one while it is written; the one before it is checkpointed
+//	first, to make room in the log.
+//
+//	The lock must be held, and no operation can be going on.  It is
+//	let go while waiting for the disk; if an operation has begun by
+//	the time the log is free, nothing is committed.
+//----------------------------------------------------------------------
+
+void
+Journal::Commit()
+{
+    Transaction *trans;
+    int where[LogSize];
+
+    ASSERT(outstanding == 0);
+    Checkpoint();			// waits for the log to be free
+    if (outstanding > 0 || running->numSectors == 0)
+	return;
+    commitDue = FALSE;
+
+    trans = running;
+    running = committed;		// it's empty
+    committed = trans;
+    numCommits++;
+    numLogged += trans->numSectors;
+
+    for (int i = 0; i < trans->numSectors; i++)
+	where[i] = LogStart + i;
+    busy = TRUE;
+    lock->Release();
+    kernel->synchDisk->WriteSectors(trans->numSectors, where, trans->data);
+    WriteLogHeader(trans);		// the commit point
+    lock->Acquire();
+    busy = FALSE;
+    logIdle->Broadcast(lock);
+}
+
+//----------------------------------------------------------------------
+// Journal::Checkpoint
+//	Copy the committed transaction to where it belongs, and empty
+//	the log.  The lock must be held; it is let go while waiting for
+//	the log to be free, and for the disk.
+//----------------------------------------------------------------------
+
+void
+Journal::Checkpoint()
+{
+    while (busy)
+	logIdle->Wait(lock);
+    if (committed->numSectors == 0)
+	return;
+
+    busy = TRUE;
+    lock->Release();
+    kernel->synchDisk->WriteSectors(committed->numSectors, committed->sector,
+				    committed->data);
+    lock->Acquire();
+    committed->numSectors = 0;		// they are home now
+    lock->Release();
+    WriteLogHeader(committed);
+    lock->Acquire();
+    busy = FALSE;
+    logIdle->Broadcast(lock);
+}
+
+//----------------------------------------------------------------------
+// Journal::WriteLogHeader
+//	Write the log header that says which sectors "trans" holds.  The
+//	first sector, with the count, is written last, by a request of
+//	its own, so that the whole header is on disk before it counts.
+//----------------------------------------------------------------------
+
+void
+Journal::WriteLogHeader(Transaction *trans)
+{
+    int header[LogHeaderSectors * SectorSize / sizeof(int)];
+    int where[LogHeaderSectors];
+    int i;
+
+    bzero(header, sizeof(header));
+    header[0] = trans->numSectors;
+    for (i = 0; i < trans->numSectors; i++)
+	header[1 + i] = trans->sector[i];
+    for (i = 1; i < LogHeaderSectors; i++)
+	where[i - 1] = LogHeaderSector + i;
+    if (LogHeaderSectors > 1)
+	kernel->synchDisk->WriteSectors(LogHeaderSectors - 1, where,
+				(char *) header + SectorSize);
+    kernel->synchDisk->WriteSector(LogHeaderSector, (char *) header);
+}
+
+//----------------------------------------------------------------------
+// Journal::RewriteLog
+//	Write some sectors of the committed transaction to the log again,
+//	after they have been changed in memory.  Otherwise, if Nachos
+//	stopped before they were checkpointed, the log would be replayed
+//	with the old contents, over whatever the sectors hold by then.
+//	The lock must be held; it is let go while waiting for the disk.
+//
+//	"numSlots" -- how many log sectors to write
+//	"slots" -- which ones
+//----------------------------------------------------------------------
+
+void
+Journal::RewriteLog(int numSlots, int *slots)
+{
+    char *buf = new char[numSlots * SectorSize];
+
+    ASSERT(!busy);
+    DEBUG(dbgFile, "Rewriting " << numSlots << " sectors in the log");
+    for (int i = 0; i < numSlots; i++)
+	bcopy(&committed->data[(slots[i] - LogStart) * SectorSize],
+	      &buf[i * SectorSize], SectorSize);
+    busy = TRUE;
+    lock->Release();
+    kernel->synchDisk->WriteSectors(numSlots, slots, buf);
+    lock->Acquire();
+    busy = FALSE;
+    logIdle->Broadcast(lock);
+    delete [] buf;
+}
+
+//----------------------------------------------------------------------
+// Journal::IsCommitted
+//	Return TRUE if any of "sectorNumbers" is in the committed
+//	transaction.  The lock must be held.
+//----------------------------------------------------------------------
+
+bool
+Journal::IsCommitted(int numSectors, int *sectorNumbers)
+{
+    for (int i = 0; i < numSectors; i++)
+	if (committed->Find(sectorNumbers[i]) != -1)
+	    return TRUE;
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// Journal::FindOp
+//	Return the record of the operation the current thread is in the
+//	middle of, or NULL if it isn't in one.  The lock must be held.
+//----------------------------------------------------------------------
+
+OpThread *
+Journal::FindOp()
+{
+    ListIterator<OpThread *> iter(inOp);
+
+    for (; !iter.IsDone(); iter.Next())
+	if (iter.Item()->thread == kernel->currentThread)
+	    return iter.Item();
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// Journal::Checkpointer
+//	The background thread.  Whenever it is woken up, it commits the
+//	running transaction if that is due, and checkpoints.
+//
+//	"journal" -- the log to look after
+//----------------------------------------------------------------------
+
+void
+Journal::Checkpointer(void *journal)
+{
+    Journal *j = (Journal *) journal;
+
+    for (;;) {
+	j->wakeup->P();
+	j->lock->Acquire();
+	if (j->commitDue && j->outstanding == 0)
+	    j->Commit();
+	j->Checkpoint();
+	j->lock->Release();
+    }
+}
@@ -0,0 +1,135 @@
+// journal.h
+//	Data structures for a write-ahead log of file system metadata.
+//
+//	Operations that change the file system's metadata (the bitmap,
+//	directories and file headers) are bracketed by BeginOp and EndOp.
+//	The sectors they write don't go to their home on disk right away;
+//	they collect in memory, and the changes of many operations are
+//	written to a log region on disk all at once, by a single commit.
+//	Once a commit is on disk, the sectors are copied to their homes
+//	("checkpointed") by a background thread.  If Nachos stops in the
+//	middle, the log is replayed when the disk is next mounted, so
+//	each operation happens either entirely or not at all.
+//
+//	Writes made outside of an operation (file data) go straight to
+//	disk.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "copyright.h"
+#include "disk.h"
+#include "callback.h"
+#include "list.h"
+
+class Lock;
+class Condition;
+class Semaphore;
+class Thread;
+
+// The log lives just after the file headers of the bitmap and the root
+// directory (see filesys.cc).  Its first few sectors, the log header,
+// say how many sectors the rest of it holds, and which ones they are;
+// those follow the log header on disk.
+
+#define LogHeaderSector 2
+#define LogSize 62			// How many sectors a commit can hold
+#define LogHeaderSectors ((int) divRoundUp((1 + LogSize) * sizeof(int), SectorSize))
+#define LogStart (LogHeaderSector + LogHeaderSectors)
+#define LogSectors (LogHeaderSectors + LogSize)
+					// Size of the whole log region
+#define MaxOpSectors 8			// Most sectors one operation writes
+#define CommitDelay 1000000		// How long changes can wait in memory
+					// before they are committed, in ticks
+
+// The changes that are waiting to be committed (or checkpointed):
+// a set of sectors, and their new contents.  Writing the same sector
+// twice only keeps the latest contents.
+
+class Transaction {
+  public:
+    Transaction();
+    ~Transaction();
+
+    int Find(int sectorNumber);		// Where is this sector kept?
+					// -1 if it isn't
+
+    int numSectors;			// How many sectors are in it
+    int sector[LogSize];		// Which sectors they are
+    char *data;				// Their contents, one after another
+};
+
+// A thread that is in the middle of an operation, and how many
+// operations it has begun but not ended.
+
+class OpThread {
+  public:
+    Thread *thread;
+    int depth;
+};
+
+class Journal : public CallBackObj {
+  public:
+    Journal(bool format);		// Set up the log; if "format",
+					// the disk is empty, otherwise
+					// replay whatever is in the log
+    ~Journal();
+
+    void BeginOp();			// Start changing metadata
+    void EndOp();			// Done; the changes may be committed
+
+    void ReadSector(int sectorNumber, char *data);
+    void WriteSector(int sectorNumber, char *data);
+					// Read/write a sector, seeing any
+					// changes not yet checkpointed
+    void ReadSectors(int numSectors, int *sectorNumbers, char *data);
+    void WriteSectors(int numSectors, int *sectorNumbers, char *data);
+					// Read/write several at once
+
+    void Sync();			// Commit and checkpoint everything
+
+    void CallBack();			// Time to commit
+
+  private:
+    void Recover();			// Replay the log, after a crash
+    void Commit();			// Write the running transaction
+					// to the log
+    void Checkpoint();			// Copy the committed transaction
+					// to where it belongs
+    void WriteLogHeader(Transaction *trans);
+    void RewriteLog(int numSlots, int *slots);
+					// Put changed committed sectors
+					// back in the log
+    bool IsCommitted(int numSectors, int *sectorNumbers);
+					// Is one of these sectors in the
+					// committed transaction?
+    OpThread *FindOp();			// Is the current thread in an
+					// operation?
+    static void Checkpointer(void *journal);
+					// The background thread
+
+    Lock *lock;				// Protects everything below; not
+					// held while waiting for the disk
+    Condition *opEnded;			// Someone waits for room in the log
+    Condition *logIdle;			// Someone waits for "busy" to clear
+    Semaphore *wakeup;			// Wakes the background thread
+    List<OpThread *> *inOp;		// Threads in an operation
+    int outstanding;			// How many operations are going on
+    bool timerSet;			// Is a commit scheduled?
+    bool commitDue;			// Has the commit delay passed?
+    bool busy;				// Is the committed transaction being
+					// written to disk?  Then it can't
+					// be changed, or replaced
+    Transaction *running;		// Changes not yet committed
+    Transaction *committed;		// Committed, not yet checkpointed
+
+    int numCommits;			// For debugging
+    int numLogged;
+    int numAbsorbed;
+};
+
+#endif // JOURNAL_H
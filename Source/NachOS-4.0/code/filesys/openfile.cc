@@ -5,7 +5,10 @@
 //	the OpenFile data structure).
 //
 //	Also as in UNIX, for convenience, we keep the file header in
-//	memory while the file is open.
+//	memory while the file is open.  Writing past the end of the file
+//	grows it; the header on disk is only brought up to date when the
+//	file is flushed or closed, so a run of appends costs one header
+//	write rather than one per call.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -17,19 +20,21 @@
 #include "filehdr.h"
 #include "openfile.h"
 #include "synchdisk.h"
+#include "filesys.h"
 
 //----------------------------------------------------------------------
 // OpenFile::OpenFile
 // 	Open a Nachos file for reading and writing.  Bring the file header
-//	into memory while the file is open.
+//	into memory while the file is open; every OpenFile on the same
+//	file shares the same copy of it.
 //
 //	"sector" -- the location on disk of the file header for this file
 //----------------------------------------------------------------------
 
 OpenFile::OpenFile(int sector)
 {
-    hdr = new FileHeader;
-    hdr->FetchFrom(sector);
+    hdr = kernel->fileSystem->OpenHeader(sector);
+    hdrSector = sector;
     seekPosition = 0;
 }
 
@@ -40,7 +45,19 @@ OpenFile::OpenFile(int sector)
 
 OpenFile::~OpenFile()
 {
-    delete hdr;
+    kernel->fileSystem->CloseHeader(hdrSector);
+}
+
+//----------------------------------------------------------------------
+// OpenFile::Flush
+// 	If the file has grown since its header was last written back,
+//	give back the sectors allocated ahead of need, and write the
+//	file header back to disk.
+//----------------------------------------------------------------------
+
+void OpenFile::Flush()
+{
+    kernel->fileSystem->FlushHeader(hdrSector);
 }
 
 //----------------------------------------------------------------------
@@ -97,7 +114,9 @@ int OpenFile::Write(char *into, int numBytes)
 //	   We read in all of the full or partial sectors that are part of the
 //	   request, but we only copy the part we are interested in.
 //	For WriteAt:
-//	   We must first read in any sectors that will be partially written,
+//	   If the request runs past the end of the file, we first grow
+//	   the file to fit (if we can't, we only write up to the old end).
+//	   We must then read in any sectors that will be partially written,
 //	   so that we don't overwrite the unmodified portion.  We then copy
 //	   in the data that will be modified, and write back all the full
 //	   or partial sectors that are part of the request.
@@ -113,6 +132,7 @@ int OpenFile::ReadAt(char *into, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
     int i, firstSector, lastSector, numSectors;
+    int *sectors;
     char *buf;
 
     if ((numBytes <= 0) || (position >= fileLength))
@@ -125,14 +145,17 @@ int OpenFile::ReadAt(char *into, int numBytes, int position)
     lastSector = divRoundDown(position + numBytes - 1, SectorSize);
     numSectors = 1 + lastSector - firstSector;
 
-    // read in all the full and partial sectors that we need
+    // read in all the full and partial sectors that we need,
+    // with a single request
     buf = new char[numSectors * SectorSize];
+    sectors = new int[numSectors];
     for (i = firstSector; i <= lastSector; i++)
-        kernel->synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize),
-                                      &buf[(i - firstSector) * SectorSize]);
+        sectors[i - firstSector] = hdr->ByteToSector(i * SectorSize);
+    kernel->fileSystem->ReadSectors(numSectors, sectors, buf);
 
     // copy the part we want
     bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
+    delete[] sectors;
     delete[] buf;
     return numBytes;
 }
@@ -142,12 +165,18 @@ int OpenFile::WriteAt(char *from, int numBytes, int position)
     int fileLength = hdr->FileLength();
     int i, firstSector, lastSector, numSectors;
     bool firstAligned, lastAligned;
+    int *sectors;
     char *buf;
 
-    if ((numBytes <= 0) || (position >= fileLength))
+    if ((numBytes <= 0) || (position > fileLength))
         return 0; // check request
     if ((position + numBytes) > fileLength)
-        numBytes = fileLength - position;
+    {
+        if (!kernel->fileSystem->Extend(hdrSector, position + numBytes))
+            numBytes = fileLength - position;
+        if (numBytes <= 0)
+            return 0; // no room to grow
+    }
     DEBUG(dbgFile, "Writing " << numBytes << " bytes at " << position << " from file of length " << fileLength);
 
     firstSector = divRoundDown(position, SectorSize);
@@ -169,10 +198,12 @@ int OpenFile::WriteAt(char *from, int numBytes, int position)
     // copy in the bytes we want to change
     bcopy(from, &buf[position - (firstSector * SectorSize)], numBytes);
 
-    // write modified sectors back
+    // write modified sectors back, with a single request
+    sectors = new int[numSectors];
     for (i = firstSector; i <= lastSector; i++)
-        kernel->synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize),
-                                       &buf[(i - firstSector) * SectorSize]);
+        sectors[i - firstSector] = hdr->ByteToSector(i * SectorSize);
+    kernel->fileSystem->WriteSectors(numSectors, sectors, buf);
+    delete[] sectors;
     delete[] buf;
     return numBytes;
 }
@@ -121,6 +121,9 @@ public:
 				  // than the UNIX idiom -- lseek to
 				  // end of file, tell, lseek back
 
+	void Flush(); // If the file has grown, write its
+				  // header back to disk
+
 	///------------------------ update
 	int GetCurrentPos()
 	{
@@ -130,7 +133,9 @@ public:
 	char *fileName;
 
 private:
-	FileHeader *hdr;  // Header for this file
+	FileHeader *hdr;  // Header for this file, shared with
+					  // every other OpenFile on it
+	int hdrSector;	  // Where the header lives on disk
 	int seekPosition; // Current position within the file
 };
 
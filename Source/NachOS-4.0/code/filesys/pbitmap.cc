@@ -63,6 +63,7 @@ void
 PersistentBitmap::FetchFrom(OpenFile *file) 
 {
     file->ReadAt((char *)map, numWords * sizeof(unsigned), 0);
+    nextFree = 0;		// the old hint says nothing about the new map
 }
 
 //----------------------------------------------------------------------
@@ -5,10 +5,17 @@
 //	the disk providing a synchronous interface (requests wait until
 //	the request completes).
 //
-//	Use a semaphore to synchronize the interrupt handlers with the
-//	pending requests.  And, because the physical disk can only
-//	handle one operation at a time, use a lock to enforce mutual
-//	exclusion.
+//	Use a semaphore per request to synchronize the interrupt
+//	handlers with the thread waiting for it.  And, because each
+//	physical disk can only handle one operation at a time, keep the
+//	requests that arrive while it is busy in a queue, and start the
+//	next one from the interrupt handler.  The queues are shared with
+//	the interrupt handlers, so they are protected by disabling
+//	interrupts.
+//
+//	When there are several disks, a request is split into one
+//	request for each disk involved, all of which are started at
+//	once; the thread waits for all of them.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -16,20 +23,240 @@
 
 #include "copyright.h"
 #include "synchdisk.h"
+#include "synch.h"
+#include "main.h"
+
+// How many threads the benchmark runs at once, and how many random
+// sectors each reads
+#define BenchThreads 8
+#define BenchReads 64
+
+static int benchSector[BenchThreads][BenchReads];
+static Semaphore *benchDone;
+
+// How many requests a replay keeps outstanding at once, and where
+// the replay threads are in the trace
+
+#define ReplayThreads 8
+
+static DiskTraceRecord *replayTrace;
+static int replayRecords;		// records in the trace
+static int replayNext;			// the next one to replay
+static int replayRequests;		// requests replayed so far
+static int *replayLatency;		// how long each one took
 
+//----------------------------------------------------------------------
+// DiskRequest::DiskRequest, DiskRequest::~DiskRequest
+// 	Initialize an empty request to read or write some sectors of a
+//	disk, and de-allocate one.
+//
+//	"maxSectors" -- the most sectors that will be added to it
+//	"isWrite" -- is it a write?
+//	"whenDone" -- what to signal when it has finished
+//----------------------------------------------------------------------
+
+DiskRequest::DiskRequest(int maxSectors, bool isWrite, Semaphore *whenDone)
+{
+    ASSERT(maxSectors > 0);
+    numSectors = 0;
+    sectors = new int[maxSectors];
+    index = new int[maxSectors];
+    data = new char[maxSectors * SectorSize];
+    writing = isWrite;
+    arrival = kernel->stats->totalTicks;
+    done = whenDone;
+}
+
+DiskRequest::~DiskRequest()
+{
+    delete [] sectors;
+    delete [] index;
+    delete [] data;
+}
+
+//----------------------------------------------------------------------
+// DiskRequest::Add
+// 	Add a sector to the request.
+//
+//	"sectorNumber" -- the sector, on this request's disk
+//	"where" -- which sector it is of the request made to the SynchDisk
+//----------------------------------------------------------------------
+
+void
+DiskRequest::Add(int sectorNumber, int where)
+{
+    if (numSectors == 0)
+	sector = sectorNumber;
+    sectors[numSectors] = sectorNumber;
+    index[numSectors++] = where;
+}
+
+//----------------------------------------------------------------------
+// DiskUnit::DiskUnit
+// 	Initialize one of the disks under a SynchDisk.
+//
+//	"unit" -- which one it is
+//	"sync" -- when the raw disk should push writes to its UNIX file
+//	"model" -- how the raw disk behaves, or NULL for the default
+//----------------------------------------------------------------------
+
+DiskUnit::DiskUnit(int unit, DiskSync sync, DiskModel *model)
+{
+    schedule = DiskCLOOK;
+    queue = new List<DiskRequest *>;
+    current = NULL;
+    headSector = 0;
+    goingUp = TRUE;
+    disk = new Disk(this, sync, model, unit);
+}
+
+DiskUnit::~DiskUnit()
+{
+    delete disk;
+    delete queue;
+}
+
+//----------------------------------------------------------------------
+// DiskUnit::Request
+// 	Send a request to the disk if it is idle, otherwise queue it.
+//	Interrupts must be off, since the queue is shared with the
+//	interrupt handler.
+//----------------------------------------------------------------------
+
+void
+DiskUnit::Request(DiskRequest *request)
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    if (current == NULL)
+	Start(request);
+    else
+	queue->Append(request);
+}
+
+//----------------------------------------------------------------------
+// DiskUnit::Load
+// 	Return how many requests the disk has to finish, before it could
+//	start on a new one.
+//----------------------------------------------------------------------
+
+int
+DiskUnit::Load()
+{
+    return queue->NumInList() + (current != NULL ? 1 : 0);
+}
+
+//----------------------------------------------------------------------
+// DiskUnit::Start
+// 	Send a request to the raw disk, keeping track of how far the
+//	head has to move for it.
+//----------------------------------------------------------------------
+
+void
+DiskUnit::Start(DiskRequest *request)
+{
+    current = request;
+    for (int i = 0; i < request->numSectors; i++) {
+	kernel->stats->diskSeekTracks +=
+		abs(disk->Track(request->sectors[i]) - disk->Track(headSector));
+	headSector = request->sectors[i];
+    }
+    if (request->writing)
+	disk->WriteRequest(request->numSectors, request->sectors,
+			   request->data);
+    else
+	disk->ReadRequest(request->numSectors, request->sectors,
+			  request->data);
+}
+
+//----------------------------------------------------------------------
+// DiskUnit::PickNext
+// 	Take the request to serve next off the queue, according to the
+//	scheduling policy.  Return NULL if the queue is empty.
+//
+//	SCAN and C-LOOK order requests by sector number, so requests on
+//	the same track are served in the order they come under the head.
+//----------------------------------------------------------------------
+
+DiskRequest *
+DiskUnit::PickNext()
+{
+    ListIterator<DiskRequest *> iter(queue);
+    DiskRequest *best = NULL, *lowest = NULL, *r;
+
+    if (queue->IsEmpty())
+	return NULL;
+    if (schedule == DiskFCFS)
+	return queue->RemoveFront();
+
+    for (; !iter.IsDone(); iter.Next()) {
+	r = iter.Item();
+	if (lowest == NULL || r->sector < lowest->sector)
+	    lowest = r;
+	if (goingUp || schedule == DiskCLOOK) {
+	    if (r->sector >= headSector
+		    && (best == NULL || r->sector < best->sector))
+		best = r;		// closest one above the head
+	} else {
+	    if (r->sector <= headSector
+		    && (best == NULL || r->sector > best->sector))
+		best = r;		// closest one below the head
+	}
+    }
+    if (best == NULL) {
+	if (schedule == DiskCLOOK)
+	    best = lowest;		// jump back to the start
+	else {
+	    goingUp = !goingUp;		// nothing more this way; reverse
+	    return PickNext();
+	}
+    }
+    queue->Remove(best);
+    return best;
+}
+
+//----------------------------------------------------------------------
+// DiskUnit::CallBack
+// 	Disk interrupt handler.  Start the next request waiting for the
+//	disk, if any, and wake up the thread waiting for this one to
+//	finish.
+//----------------------------------------------------------------------
+
+void
+DiskUnit::CallBack()
+{ 
+    DiskRequest *finished = current;
+    DiskRequest *next;
+
+    kernel->stats->numDiskRequests++;
+    kernel->stats->diskLatencyTicks +=
+		kernel->stats->totalTicks - finished->arrival;
+    current = NULL;
+    if ((next = PickNext()) != NULL)
+	Start(next);
+    finished->done->V();
+}
 
 //----------------------------------------------------------------------
 // SynchDisk::SynchDisk
-// 	Initialize the synchronous interface to the physical disk, in turn
-//	initializing the physical disk.
+// 	Initialize the synchronous interface to the physical disks, in
+//	turn initializing the physical disks.
 //
+//	"policy" -- the order in which to serve waiting requests
+//	"sync" -- when the raw disks should push writes to their UNIX files
+//	"model" -- how the raw disks behave, or NULL for the default
+//	"array" -- whether to stripe or mirror sectors across the disks
+//	"numDisks" -- how many disks there are
 //----------------------------------------------------------------------
 
-SynchDisk::SynchDisk()
+SynchDisk::SynchDisk(DiskSchedule policy, DiskSync sync, DiskModel *model,
+		     DiskArray array, int numDisks)
 {
-    semaphore = new Semaphore("synch disk", 0);
-    lock = new Lock("synch disk lock");
-    disk = new Disk(this);
+    ASSERT(numDisks >= 1 && numDisks <= MaxDisks);
+    numUnits = numDisks;
+    layout = array;
+    for (int i = 0; i < numUnits; i++)
+	units[i] = new DiskUnit(i, sync, model);
+    SetSchedule(policy);
 }
 
 //----------------------------------------------------------------------
@@ -40,9 +267,21 @@ SynchDisk::SynchDisk()
 
 SynchDisk::~SynchDisk()
 {
-    delete disk;
-    delete lock;
-    delete semaphore;
+    for (int i = 0; i < numUnits; i++)
+	delete units[i];
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::SetSchedule
+// 	Change the order in which every disk serves its requests.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::SetSchedule(DiskSchedule policy)
+{
+    schedule = policy;
+    for (int i = 0; i < numUnits; i++)
+	units[i]->schedule = policy;
 }
 
 //----------------------------------------------------------------------
@@ -57,10 +296,7 @@ SynchDisk::~SynchDisk()
 void
 SynchDisk::ReadSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// only one disk I/O at a time
-    disk->ReadRequest(sectorNumber, data);
-    semaphore->P();			// wait for interrupt
-    lock->Release();
+    Transfer(1, &sectorNumber, data, FALSE);
 }
 
 //----------------------------------------------------------------------
@@ -75,20 +311,409 @@ SynchDisk::ReadSector(int sectorNumber, char* data)
 void
 SynchDisk::WriteSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// only one disk I/O at a time
-    disk->WriteRequest(sectorNumber, data);
-    semaphore->P();			// wait for interrupt
-    lock->Release();
+    Transfer(1, &sectorNumber, data, TRUE);
 }
 
 //----------------------------------------------------------------------
-// SynchDisk::CallBack
-// 	Disk interrupt handler.  Wake up any thread waiting for the disk
-//	request to finish.
+// SynchDisk::ReadSectors
+// 	Read the contents of several disk sectors into a buffer, with a
+//	single request to each disk involved.  Return only after the
+//	data has been read.
+//
+//	"numSectors" -- how many sectors to read
+//	"sectorNumbers" -- which ones, in the order they are to be read
+//	"data" -- the buffer to hold their contents, one after another
 //----------------------------------------------------------------------
 
 void
-SynchDisk::CallBack()
-{ 
-    semaphore->V();
+SynchDisk::ReadSectors(int numSectors, int *sectorNumbers, char *data)
+{
+    Transfer(numSectors, sectorNumbers, data, FALSE);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::WriteSectors
+// 	Write the contents of a buffer into several disk sectors, with
+//	a single request to each disk involved.  Return only after the
+//	data has been written.
+//
+//	"numSectors" -- how many sectors to write
+//	"sectorNumbers" -- which ones, in the order they are to be written
+//	"data" -- their new contents, one after another
+//----------------------------------------------------------------------
+
+void
+SynchDisk::WriteSectors(int numSectors, int *sectorNumbers, char *data)
+{
+    Transfer(numSectors, sectorNumbers, data, TRUE);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Transfer
+// 	Read or write some sectors.  Work out which disk each sector is
+//	on (for mirrored writes, every disk), give each disk involved a
+//	request for its sectors, and wait until they have all finished.
+//	The request goes into the disk trace, if there is one, as it was
+//	made: these sector numbers, from now until then.
+//
+//	"numSectors" -- how many sectors to read or write
+//	"sectorNumbers" -- which ones
+//	"data" -- their contents, one after another
+//	"writing" -- is it a write?
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Transfer(int numSectors, int *sectorNumbers, char *data,
+		    bool writing)
+{
+    Semaphore *done = new Semaphore("disk request", 0);
+    DiskRequest *part[MaxDisks];
+    int i, j, u, physical, mirror = -1;
+    int issue = kernel->stats->totalTicks;
+    IntStatus oldLevel;
+
+    for (u = 0; u < numUnits; u++)
+	part[u] = NULL;
+    if (layout == DiskMirrored && !writing)
+	mirror = ChooseMirror(sectorNumbers[0]);
+    for (i = 0; i < numSectors; i++) {
+	ASSERT(sectorNumbers[i] >= 0 && sectorNumbers[i] < NumSectors);
+	if (layout == DiskMirrored) {
+	    for (u = 0; u < numUnits; u++) {
+		if (mirror != -1 && u != mirror)
+		    continue;
+		if (part[u] == NULL)
+		    part[u] = new DiskRequest(numSectors, writing, done);
+		part[u]->Add(sectorNumbers[i], i);
+	    }
+	} else {
+	    physical = Locate(sectorNumbers[i], &u);
+	    if (part[u] == NULL)
+		part[u] = new DiskRequest(numSectors, writing, done);
+	    part[u]->Add(physical, i);
+	}
+    }
+
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    for (u = 0; u < numUnits; u++)
+	if (part[u] != NULL) {
+	    if (writing)
+		for (j = 0; j < part[u]->numSectors; j++)
+		    bcopy(&data[part[u]->index[j] * SectorSize],
+			  &part[u]->data[j * SectorSize], SectorSize);
+	    units[u]->Request(part[u]);
+	}
+    (void) kernel->interrupt->SetLevel(oldLevel);
+
+    for (u = 0; u < numUnits; u++)
+	if (part[u] != NULL)
+	    done->P();			// wait for one of them to finish
+    for (u = 0; u < numUnits; u++)
+	if (part[u] != NULL) {
+	    if (!writing)
+		for (j = 0; j < part[u]->numSectors; j++)
+		    bcopy(&part[u]->data[j * SectorSize],
+			  &data[part[u]->index[j] * SectorSize], SectorSize);
+	    delete part[u];
+	}
+    delete done;
+    if (kernel->diskTrace != NULL)
+	kernel->diskTrace->Record(numSectors, sectorNumbers, writing, issue,
+				  kernel->stats->totalTicks);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Locate
+// 	Return where a sector is kept when the disks are striped: which
+//	sector of which disk.
+//
+//	"sector" -- the sector, as the file system sees it
+//	"unit" -- set to which disk it is on
+//----------------------------------------------------------------------
+
+int
+SynchDisk::Locate(int sector, int *unit)
+{
+    int stripe = sector / StripeSectors;
+
+    *unit = stripe % numUnits;
+    return (stripe / numUnits) * StripeSectors + sector % StripeSectors;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Peek
+// 	Copy out the contents of a sector, without making a request of
+//	any disk or letting time pass.
+//
+//	"sectorNumber" -- the sector to look at
+//	"data" -- the buffer to hold its contents
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Peek(int sectorNumber, char *data)
+{
+    int unit = 0;
+    int physical = sectorNumber;
+
+    if (layout == DiskStriped)
+	physical = Locate(sectorNumber, &unit);
+    units[unit]->disk->Peek(physical, data);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ChooseMirror
+// 	Return which disk should serve a read of "sector", when they all
+//	hold a copy: the one with the least work ahead of it, and of
+//	those, the one whose head can get to the sector soonest.
+//----------------------------------------------------------------------
+
+int
+SynchDisk::ChooseMirror(int sector)
+{
+    int best = 0, bestLoad = 0, bestLatency = 0;
+    int load, latency;
+
+    for (int u = 0; u < numUnits; u++) {
+	load = units[u]->Load();
+	latency = units[u]->disk->ComputeLatency(sector, FALSE);
+	if (u == 0 || load < bestLoad
+		|| (load == bestLoad && latency < bestLatency)) {
+	    best = u;
+	    bestLoad = load;
+	    bestLatency = latency;
+	}
+    }
+    return best;
+}
+
+//----------------------------------------------------------------------
+// BenchReader
+// 	One of the threads run by SynchDisk::Benchmark: read its share
+//	of the random sectors, one after another.
+//
+//	"which" -- the thread's number
+//----------------------------------------------------------------------
+
+static void
+BenchReader(int which)
+{
+    char buf[SectorSize];
+
+    for (int i = 0; i < BenchReads; i++)
+	kernel->synchDisk->ReadSector(benchSector[which][i], buf);
+    benchDone->V();
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Benchmark
+// 	Compare the scheduling policies: under each, have several
+//	threads read the same random sectors at once, and print how far
+//	the heads moved and how long requests waited, on average, and
+//	the throughput of all the disks together.
+//	Must be called on kernel->synchDisk.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Benchmark()
+{
+    static char *names[] = { "FCFS", "SCAN", "C-LOOK" };
+    DiskSchedule oldSchedule = schedule;
+    Statistics *stats = kernel->stats;
+    int i, j, requests, seeks, start, elapsed;
+    long long latency;
+
+    for (i = 0; i < BenchThreads; i++)
+	for (j = 0; j < BenchReads; j++)
+	    benchSector[i][j] = RandomNumber() % NumSectors;
+    benchDone = new Semaphore("disk benchmark", 0);
+
+    cout << "Disk benchmark, " << numUnits
+	 << (layout == DiskMirrored ? " mirrored" : " striped") << " x ";
+    units[0]->disk->Model()->Print();
+    cout << "\n";
+    for (int p = DiskFCFS; p <= DiskCLOOK; p++) {
+	SetSchedule((DiskSchedule) p);
+	start = stats->totalTicks;
+	requests = stats->numDiskRequests;
+	seeks = stats->diskSeekTracks;
+	latency = stats->diskLatencyTicks;
+	for (i = 0; i < BenchThreads; i++) {
+	    Thread *t = new Thread("disk benchmark");
+	    t->Fork((VoidFunctionPtr) BenchReader, (void *) i);
+	}
+	for (i = 0; i < BenchThreads; i++)
+	    benchDone->P();
+	requests = stats->numDiskRequests - requests;
+	elapsed = stats->totalTicks - start;
+	cout << "Disk " << names[p] << ": " << requests << " reads, avg seek "
+	     << (double) (stats->diskSeekTracks - seeks) / requests
+	     << " tracks, avg latency "
+	     << (stats->diskLatencyTicks - latency) / requests << " ticks, "
+	     << (double) BenchThreads * BenchReads * 1000000 / elapsed
+	     << " reads per million ticks\n";
+    }
+    delete benchDone;
+    SetSchedule(oldSchedule);
+}
+
+//----------------------------------------------------------------------
+// ReplayWorker
+// 	One of the threads run by SynchDisk::Replay: take the next
+//	request in the trace, make it, and record how long it took, until
+//	the trace runs out.  A write puts back what is already in the
+//	sectors, so replaying a trace leaves the disk as it was.
+//
+//	"which" -- the thread's number
+//----------------------------------------------------------------------
+
+static void
+ReplayWorker(int which)
+{
+    int *sectors;
+    char *data;
+    DiskTraceRecord *r;
+    IntStatus oldLevel;
+    int n, request, start;
+
+    for (;;) {
+	oldLevel = kernel->interrupt->SetLevel(IntOff);
+	if (replayNext >= replayRecords) {
+	    (void) kernel->interrupt->SetLevel(oldLevel);
+	    break;
+	}
+	r = &replayTrace[replayNext];
+	n = r->numSectors;
+	replayNext += n;
+	request = replayRequests++;
+	(void) kernel->interrupt->SetLevel(oldLevel);
+
+	sectors = new int[n];
+	data = new char[n * SectorSize];
+	for (int i = 0; i < n; i++) {
+	    sectors[i] = r[i].sector;
+	    if (r->writing)
+		kernel->synchDisk->Peek(sectors[i], &data[i * SectorSize]);
+	}
+	start = kernel->stats->totalTicks;
+	if (r->writing)
+	    kernel->synchDisk->WriteSectors(n, sectors, data);
+	else
+	    kernel->synchDisk->ReadSectors(n, sectors, data);
+	replayLatency[request] = kernel->stats->totalTicks - start;
+	delete [] sectors;
+	delete [] data;
+    }
+    benchDone->V();
+}
+
+//----------------------------------------------------------------------
+// CompareTicks
+// 	Order two latencies, for qsort.
+//----------------------------------------------------------------------
+
+static int
+CompareTicks(const void *a, const void *b)
+{
+    return *(int *) a - *(int *) b;
+}
+
+//----------------------------------------------------------------------
+// PrintLatencies
+// 	Print the median, 90th and 99th percentile, and worst of some
+//	request latencies.  Sorts them.
+//----------------------------------------------------------------------
+
+static void
+PrintLatencies(int *latency, int n)
+{
+    qsort(latency, n, sizeof(int), CompareTicks);
+    cout << "latency p50 " << latency[n / 2]
+	 << ", p90 " << latency[n * 90 / 100]
+	 << ", p99 " << latency[n * 99 / 100]
+	 << ", max " << latency[n - 1] << " ticks\n";
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Replay
+// 	Replay a trace captured with -dt, under each scheduling policy,
+//	and print the throughput and the latency percentiles.  The
+//	trace holds the sectors the file system asked for, so it can be
+//	replayed on this SynchDisk whatever disks it is made of and
+//	however they are combined; comparing runs with different -dm and
+//	-raid settings shows what they do to the same workload.
+//
+//	The requests are made in the order they were captured, as fast
+//	as the disks will take them, with ReplayThreads of them
+//	outstanding at once.  Must be called on kernel->synchDisk.
+//
+//	"traceFile" -- the UNIX file holding the trace
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Replay(char *traceFile)
+{
+    static char *names[] = { "FCFS", "SCAN", "C-LOOK" };
+    DiskSchedule oldSchedule = schedule;
+    Statistics *stats = kernel->stats;
+    int i, n, numRequests = 0, start, elapsed;
+
+    replayTrace = DiskTrace::Load(traceFile, &replayRecords);
+    if (replayTrace == NULL) {
+	cout << "Replay: can't read disk trace " << traceFile << "\n";
+	return;
+    }
+    for (i = 0; i < replayRecords; i += n) {
+	n = replayTrace[i].numSectors;
+	bool damaged = (n < 1 || i + n > replayRecords);
+
+	for (int j = i; !damaged && j < i + n; j++)
+	    damaged = (replayTrace[j].sector < 0
+		       || replayTrace[j].sector >= NumSectors);
+	if (damaged) {
+	    cout << "Replay: " << traceFile << " is damaged\n";
+	    delete [] replayTrace;
+	    return;
+	}
+	numRequests++;
+    }
+    if (numRequests == 0) {
+	cout << "Replay: " << traceFile << " is empty\n";
+	delete [] replayTrace;
+	return;
+    }
+    replayLatency = new int[numRequests];
+    benchDone = new Semaphore("disk replay", 0);
+
+    cout << "Replaying " << numRequests << " requests for " << replayRecords
+	 << " sectors, captured over "
+	 << replayTrace[replayRecords - 1].complete - replayTrace[0].issue
+	 << " ticks\nRecorded: ";
+    for (i = 0, n = 0; i < replayRecords; i += replayTrace[i].numSectors)
+	replayLatency[n++] = replayTrace[i].complete - replayTrace[i].issue;
+    PrintLatencies(replayLatency, numRequests);
+
+    cout << "On " << numUnits
+	 << (layout == DiskMirrored ? " mirrored" : " striped") << " x ";
+    units[0]->disk->Model()->Print();
+    cout << "\n";
+    for (int p = DiskFCFS; p <= DiskCLOOK; p++) {
+	SetSchedule((DiskSchedule) p);
+	replayNext = replayRequests = 0;
+	start = stats->totalTicks;
+	for (i = 0; i < ReplayThreads; i++) {
+	    Thread *t = new Thread("disk replay");
+	    t->Fork((VoidFunctionPtr) ReplayWorker, (void *) i);
+	}
+	for (i = 0; i < ReplayThreads; i++)
+	    benchDone->P();
+	elapsed = stats->totalTicks - start;
+	cout << names[p] << ": " << (double) numRequests * 1000000 / elapsed
+	     << " requests per million ticks, ";
+	PrintLatencies(replayLatency, numRequests);
+    }
+
+    delete benchDone;
+    delete [] replayLatency;
+    delete [] replayTrace;
+    SetSchedule(oldSchedule);
 }
@@ -12,8 +12,83 @@
 #define SYNCHDISK_H
 
 #include "disk.h"
-#include "synch.h"
 #include "callback.h"
+#include "list.h"
+
+class Semaphore;
+
+// The order in which requests waiting for the disk are served:
+// first come first served; the elevator algorithm, sweeping the head
+// up and then back down, reversing at the last request in the way
+// (SCAN, in the LOOK variant); or always sweeping up, and jumping back
+// to the lowest request when there is nothing above the head (C-LOOK).
+
+enum DiskSchedule { DiskFCFS, DiskSCAN, DiskCLOOK };
+
+// How the disks under a SynchDisk are combined, when there is more
+// than one: sectors striped across them, StripeSectors at a time
+// (RAID-0); or each disk holding a copy of every sector (RAID-1).
+// Writes go to every copy; a read goes to the disk that should be
+// able to serve it soonest.
+
+enum DiskArray { DiskStriped, DiskMirrored };
+
+#define MaxDisks 8
+#define StripeSectors 8
+
+// A request for one disk, from a thread waiting for it to finish.
+// It can cover several sectors; it is scheduled by the first.  A
+// request to the SynchDisk becomes one of these for each disk it
+// involves.
+
+class DiskRequest {
+  public:
+    DiskRequest(int maxSectors, bool isWrite, Semaphore *whenDone);
+					// An empty request, for at most
+					// maxSectors sectors
+    ~DiskRequest();
+
+    void Add(int sectorNumber, int index);
+					// Add a sector of the disk, which is
+					// sector "index" of the whole request
+
+    int sector;				// The first sector to read/write
+    int numSectors;			// How many there are
+    int *sectors;			// Which ones
+    int *index;				// Where each is in the whole request
+    char *data;				// Their contents, one after another
+    bool writing;			// Is it a write?
+    int arrival;			// When it was made
+    Semaphore *done;			// Signalled when it has finished
+};
+
+// One of the disks under a SynchDisk, and the requests waiting for it.
+
+class DiskUnit : public CallBackObj {
+  public:
+    DiskUnit(int unit, DiskSync sync, DiskModel *model);
+    ~DiskUnit();
+
+    void Request(DiskRequest *request);	// Start a request, or queue it if
+					// the disk is busy; interrupts
+					// must be off
+    void CallBack();			// The disk finished a request
+    int Load();				// How many requests are in progress
+					// or waiting
+
+    Disk *disk;				// Raw disk device
+    DiskSchedule schedule;		// How to pick the next request
+
+  private:
+    void Start(DiskRequest *request);	// Send a request to the disk
+    DiskRequest *PickNext();		// Take the next request to serve
+					// off the queue
+
+    List<DiskRequest *> *queue;		// Requests waiting for the disk
+    DiskRequest *current;		// The one the disk is working on
+    int headSector;			// Where the last request was
+    bool goingUp;			// Which way SCAN is sweeping
+};
 
 // The following class defines a "synchronous" disk abstraction.
 // As with other I/O devices, the raw physical disk is an asynchronous device --
@@ -24,12 +99,21 @@
 //
 // This class provides the abstraction that for any individual thread
 // making a request, it waits around until the operation finishes before
-// returning.
+// returning.  Requests that arrive while the disk is busy wait in a
+// queue; when the disk finishes one, the next is picked according to
+// the scheduling policy.
+//
+// Underneath, there can be several disks, each with its own head,
+// queue and interrupts, striped or mirrored; the file system above
+// sees one disk of NumSectors sectors either way.
 
-class SynchDisk : public CallBackObj {
+class SynchDisk {
   public:
-    SynchDisk();    		        // Initialize a synchronous disk,
-					// by initializing the raw Disk.
+    SynchDisk(DiskSchedule policy = DiskCLOOK, DiskSync sync = DiskSyncNone,
+	      DiskModel *model = NULL, DiskArray array = DiskStriped,
+	      int numDisks = 1);
+					// Initialize a synchronous disk,
+					// by initializing the raw Disks.
     ~SynchDisk();			// De-allocate the synch disk data
     
     void ReadSector(int sectorNumber, char* data);
@@ -39,17 +123,35 @@ class SynchDisk : public CallBackObj {
     					// Disk::ReadRequest/WriteRequest and
 					// then wait until the request is done.
     void WriteSector(int sectorNumber, char* data);
-    
-    void CallBack();			// Called by the disk device interrupt
-					// handler, to signal that the
-					// current disk operation is complete.
+
+    void ReadSectors(int numSectors, int *sectorNumbers, char *data);
+    void WriteSectors(int numSectors, int *sectorNumbers, char *data);
+					// Read/write several sectors with a
+					// single request to each disk;
+					// "data" holds them back to back
+
+    void SetSchedule(DiskSchedule policy);
+
+    void Benchmark();			// Compare the scheduling policies
+
+    void Replay(char *traceFile);	// Replay a disk trace under each
+					// scheduling policy
+
+    void Peek(int sectorNumber, char *data);
+					// What is in a sector, without
+					// making a request
 
   private:
-    Disk *disk;		  		// Raw disk device
-    Semaphore *semaphore; 		// To synchronize requesting thread 
-					// with the interrupt handler
-    Lock *lock;		  		// Only one read/write request
-					// can be sent to the disk at a time
+    void Transfer(int numSectors, int *sectorNumbers, char *data,
+		  bool writing);	// Split a request between the disks,
+					// and wait for it to finish
+    int ChooseMirror(int sector);	// Which copy to read "sector" from
+    int Locate(int sector, int *unit);	// Where a striped sector is
+
+    DiskUnit *units[MaxDisks];		// The disks
+    int numUnits;
+    DiskArray layout;			// How they are combined
+    DiskSchedule schedule;
 };
 
 #endif // SYNCHDISK_H
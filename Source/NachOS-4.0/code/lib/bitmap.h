@@ -42,6 +42,9 @@ class Bitmap {
     int FindAndSet();         // Return the # of a clear bit, and as a side
 				// effect, set the bit. 
 				// If no bits are clear, return -1.
+    int FindAndSetRun(int count); // Return the # of the first of "count"
+				// consecutive clear bits, and set them all.
+				// If there is no such run, return -1.
     int NumClear() const;	// Return the number of clear bits
 
     void Print() const;		// Print contents of bitmap
@@ -54,6 +57,14 @@ class Bitmap {
 				//  multiple of the number of bits in
 				//  a word)
     unsigned int *map;		// bit storage
+    int nextFree;		// hint: every bit below this one is set,
+				// so searches can start here
+
+  private:
+    int NextClear(int from) const; // # of first clear bit at or after
+				// "from", or numBits if there is none
+    int NextSet(int from) const; // # of first set bit at or after
+				// "from", or numBits if there is none
 };
 
 #endif // BITMAP_H
@@ -1,6 +1,7 @@
 // libtest.cc 
 //	Driver code to call self-test routines for standard library
-//	classes -- bitmaps, lists, sorted lists, and hash tables.
+//	classes -- bitmaps, lists, sorted lists, and hash tables --
+//	and to time the ones that sit on hot paths.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -83,3 +84,126 @@ LibSelfTest () {
     delete sortList;
     delete hashTable;
 }
+
+// Size of the bitmaps timed by LibBenchmark -- the free map of a
+// disk of 32MB, much bigger than the default one -- and how many
+// operations to time for each routine.
+static const int benchBits = 1 << 18;
+static const int benchRounds = 1000;
+
+//----------------------------------------------------------------------
+// ScatterFree
+//	Clear "benchRounds" bits spread across a full bitmap, so that
+//	allocating them again has to search the whole map.
+//----------------------------------------------------------------------
+
+static void
+ScatterFree(Bitmap *map)
+{
+    for (int i = 0; i < benchRounds; i++) {
+	map->Clear((i * 7919) % benchBits);
+    }
+}
+
+//----------------------------------------------------------------------
+// BitByBitFindAndSet, BitByBitNumClear
+//	Reference versions of Bitmap::FindAndSet and Bitmap::NumClear
+//	that test one bit at a time, to compare the real ones against.
+//----------------------------------------------------------------------
+
+static int
+BitByBitFindAndSet(Bitmap *map)
+{
+    for (int i = 0; i < benchBits; i++) {
+	if (!map->Test(i)) {
+	    map->Mark(i);
+	    return i;
+	}
+    }
+    return -1;
+}
+
+static int
+BitByBitNumClear(Bitmap *map)
+{
+    int count = 0;
+
+    for (int i = 0; i < benchBits; i++) {
+	if (!map->Test(i)) {
+	    count++;
+	}
+    }
+    return count;
+}
+
+//----------------------------------------------------------------------
+// Report
+//	Print how long each of "count" operations took, on average.
+//----------------------------------------------------------------------
+
+static void
+Report(const char *what, double start, int count)
+{
+    cout << what << ": " << (WallTime() - start) * 1e9 / count
+	<< " ns per call\n";
+}
+
+//----------------------------------------------------------------------
+// LibBenchmark
+//	Time the bitmap routines used to allocate disk sectors and
+//	memory pages, on a large bitmap, against a bit-at-a-time scan.
+//----------------------------------------------------------------------
+
+void
+LibBenchmark () {
+    Bitmap *map = new Bitmap(benchBits);
+    double start;
+    int i, sum;
+
+    cout << "Bitmap benchmark, " << benchBits << " bits\n";
+
+    start = WallTime();
+    for (i = 0; i < benchBits; i++) {
+	map->FindAndSet();
+    }
+    Report("FindAndSet, filling an empty map", start, benchBits);
+
+    ScatterFree(map);
+    start = WallTime();
+    while (map->FindAndSet() != -1) {}
+    Report("FindAndSet, scattered free bits", start, benchRounds);
+
+    ScatterFree(map);
+    start = WallTime();
+    while (BitByBitFindAndSet(map) != -1) {}
+    Report("bit-by-bit FindAndSet, scattered free bits", start, benchRounds);
+
+    ScatterFree(map);
+    start = WallTime();
+    for (i = 0, sum = 0; i < benchRounds; i++) {
+	sum += map->NumClear();
+    }
+    Report("NumClear", start, benchRounds);
+    ASSERT(sum == benchRounds * map->NumClear());
+
+    start = WallTime();
+    for (i = 0, sum = 0; i < benchRounds; i++) {
+	sum += BitByBitNumClear(map);
+    }
+    Report("bit-by-bit NumClear", start, benchRounds);
+    ASSERT(sum == benchRounds * map->NumClear());
+
+    for (i = 0; i < benchBits; i += 64) {	// leave runs of 16 free bits
+	for (int j = 0; j < 16; j++) {
+	    map->Clear(i + j);
+	}
+    }
+    start = WallTime();
+    for (i = 0, sum = 0; i < benchRounds; i++) {
+	sum += (map->FindAndSetRun(8) != -1);
+    }
+    Report("FindAndSetRun(8)", start, benchRounds);
+    ASSERT(sum == benchRounds);
+
+    delete map;
+}
@@ -1,5 +1,6 @@
 // libtest.h 
-//	 Defines self test module for standard library routines.
+//	 Defines self test and benchmark modules for standard library
+//	 routines.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -11,5 +12,6 @@
 #include "copyright.h"
 
 extern void LibSelfTest();
+extern void LibBenchmark();
 
 #endif // LIBTEST_H
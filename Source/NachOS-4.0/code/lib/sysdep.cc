@@ -52,9 +52,7 @@ extern "C"
 #include <signal.h>
 #include <sys/types.h>
 
-#ifndef NO_MPROT
-#include <sys/mman.h>
-#endif
+#include <sys/mman.h> // for mprotect, and for mapping files
 
     // UNIX routines called by procedures in this file
 
@@ -144,6 +142,21 @@ void UDelay(unsigned int useconds)
     //#endif /* SOLARIS */
 }
 
+//----------------------------------------------------------------------
+// WallTime
+// 	Return the current host wall-clock time, in seconds.  Only
+//	differences between two calls are meaningful; used to time
+//	benchmarks of the simulation code itself.
+//----------------------------------------------------------------------
+
+double WallTime()
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return now.tv_sec + now.tv_usec / 1e6;
+}
+
 //----------------------------------------------------------------------
 // Abort
 // 	Quit and drop core.
@@ -398,6 +411,47 @@ bool Unlink(char *name)
     return unlink(name);
 }
 
+//----------------------------------------------------------------------
+// MapFile
+// 	Map the first "size" bytes of an open file into memory, shared,
+//	so that stores to the memory change the file.  Abort on error.
+//----------------------------------------------------------------------
+
+char *MapFile(int fd, int size)
+{
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    ASSERT(addr != MAP_FAILED);
+    return (char *)addr;
+}
+
+//----------------------------------------------------------------------
+// UnmapFile
+// 	Undo MapFile.  Changes still reach the file eventually.
+//----------------------------------------------------------------------
+
+void UnmapFile(char *addr, int size)
+{
+    int retVal = munmap(addr, size);
+    ASSERT(retVal == 0);
+}
+
+//----------------------------------------------------------------------
+// SyncMappedFile
+// 	Start writing the changed pages of a mapped file, among the ones
+//	holding "size" bytes at "addr", back to the file; if "wait",
+//	return only when they are on stable storage.
+//----------------------------------------------------------------------
+
+void SyncMappedFile(char *addr, int size, bool wait)
+{
+    int pgSize = getpagesize();
+    char *start = addr - ((unsigned long)addr % pgSize);
+    int retVal = msync(start, size + (addr - start),
+                       wait ? MS_SYNC : MS_ASYNC);
+    ASSERT(retVal == 0);
+}
+
 //----------------------------------------------------------------------
 // OpenSocket
 // 	Open an interprocess communication (IPC) connection.  For now,
@@ -25,6 +25,9 @@ extern void Exit(int exitCode);
 extern void Delay(int seconds);
 extern void UDelay(unsigned int usec);// rcgood - to avoid spinners.
 
+// Host wall-clock time in seconds, for timing benchmarks
+extern double WallTime();
+
 // Initialize system so that cleanUp routine is called when user hits ctl-C
 extern void CallOnUserAbort(void (*cleanup)(int));
 
@@ -53,6 +56,13 @@ extern int Tell(int fd);
 extern int Close(int fd);
 extern bool Unlink(char *name);
 
+// Map an open file into memory, so that it can be read and written
+// like an array; and push changes to part of the mapping out to the
+// file, waiting for them to get there if "wait".
+extern char *MapFile(int fd, int size);
+extern void UnmapFile(char *addr, int size);
+extern void SyncMappedFile(char *addr, int size, bool wait);
+
 // Other C library routines that are used by Nachos.
 // These are assumed to be portable, so we don't include a wrapper.
 extern "C" {
@@ -7,6 +7,10 @@
 //	Disk operations are asynchronous, so we have to invoke an interrupt
 //	handler when the simulated operation completes.
 //
+//	To keep the cost of simulating a disk request down, the UNIX
+//	file is mapped into memory once, rather than read and written
+//	with system calls for each sector.
+//
 //  DO NOT CHANGE -- part of the machine emulation
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
@@ -27,27 +31,113 @@ const int MagicNumber = 0x456789ab;
 const int MagicSize = sizeof(int);
 const int DiskSize = (MagicSize + (NumSectors * SectorSize));
 
+// Disk traces start with a magic number of their own.
+
+const int TraceMagic = 0x54524346;
+
+//----------------------------------------------------------------------
+// DiskModel::DiskModel()
+// 	Describe the default disk: a rotating one, with the geometry in
+//	disk.h and the timing in stats.h.  The flash disk settings are
+//	used if Parse switches to one.
+//----------------------------------------------------------------------
+
+DiskModel::DiskModel()
+{
+    kind = DiskRotating;
+    sectorsPerTrack = SectorsPerTrack;
+    seekTime = SeekTime;
+    rotationTime = RotationTime;
+    readTime = SSDReadTime;
+    writeTime = SSDWriteTime;
+    channels = SSDChannels;
+}
+
+//----------------------------------------------------------------------
+// DiskModel::Parse()
+// 	Set the model from a command line argument:
+//	   hdd[:sectorsPerTrack,seekTime,rotationTime]
+//	   ssd[:readTime,writeTime,channels]
+//	Settings left out keep their defaults.  Return FALSE, leaving the
+//	model as it was, if the argument doesn't make sense.
+//----------------------------------------------------------------------
+
+bool
+DiskModel::Parse(char *spec)
+{
+    DiskModel m;
+    int n;
+
+    if (strncmp(spec, "hdd", 3) == 0) {
+	m.kind = DiskRotating;
+	n = sscanf(spec, "hdd:%d,%d,%d", &m.sectorsPerTrack, &m.seekTime,
+		   &m.rotationTime);
+    } else if (strncmp(spec, "ssd", 3) == 0) {
+	m.kind = DiskSolidState;
+	n = sscanf(spec, "ssd:%d,%d,%d", &m.readTime, &m.writeTime,
+		   &m.channels);
+    } else
+	return FALSE;
+    if ((spec[3] != '\0' && (spec[3] != ':' || n < 1))
+	  || m.sectorsPerTrack < 1 || m.sectorsPerTrack > NumSectors
+	  || m.seekTime < 0 || m.rotationTime < 1
+	  || m.readTime < 1 || m.writeTime < 1
+	  || m.channels < 1 || m.channels > MaxSSDChannels)
+	return FALSE;
+    *this = m;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// DiskModel::Print()
+// 	Describe the model, for the benchmarks.
+//----------------------------------------------------------------------
+
+void
+DiskModel::Print()
+{
+    if (kind == DiskRotating)
+	cout << "rotating disk, " << divRoundUp(NumSectors, sectorsPerTrack)
+	     << " tracks of " << sectorsPerTrack << " sectors, seek "
+	     << seekTime << ", rotation " << rotationTime;
+    else
+	cout << "flash disk, " << channels << " channels, read "
+	     << readTime << ", write " << writeTime;
+}
+
 
 //----------------------------------------------------------------------
 // Disk::Disk()
 // 	Initialize a simulated disk.  Open the UNIX file (creating it
 //	if it doesn't exist), and check the magic number to make sure it's 
-// 	ok to treat it as Nachos disk storage.
+// 	ok to treat it as Nachos disk storage.  Then map it into memory.
 //
 //	"toCall" -- object to call when disk read/write request completes
+//	"sync" -- when writes should reach the UNIX file
+//	"diskModel" -- how the disk should behave, or NULL for the default
+//	"unit" -- which of this machine's disks it is: unit 0 is kept in
+//		DISK_<host>, the others in DISK_<host>.<unit>
 //----------------------------------------------------------------------
 
-Disk::Disk(CallBackObj *toCall)
+Disk::Disk(CallBackObj *toCall, DiskSync sync, DiskModel *diskModel, int unit)
 {
     int magicNum;
     int tmp = 0;
 
     DEBUG(dbgDisk, "Initializing the disk.");
     callWhenDone = toCall;
+    syncPolicy = sync;
+    if (diskModel != NULL)
+	model = *diskModel;
     lastSector = 0;
     bufferInit = 0;
+    for (int i = 0; i < MaxSSDChannels; i++)
+	channelFree[i] = 0;
     
-    sprintf(diskname,"DISK_%d",kernel->hostName);
+    if (unit == 0)
+	sprintf(diskname,"DISK_%d",kernel->hostName);
+    else
+	sprintf(diskname,"DISK_%d.%d",kernel->hostName,unit);
     fileno = OpenForReadWrite(diskname, FALSE);
     if (fileno >= 0) {		 	// file exists, check magic number 
 	Read(fileno, (char *) &magicNum, MagicSize);
@@ -61,17 +151,22 @@ Disk::Disk(CallBackObj *toCall)
         Lseek(fileno, DiskSize - sizeof(int), 0);	
 	WriteFile(fileno, (char *)&tmp, sizeof(int));  
     }
+    image = MapFile(fileno, DiskSize);
     active = FALSE;
 }
 
 //----------------------------------------------------------------------
 // Disk::~Disk()
 // 	Clean up disk simulation, by closing the UNIX file representing the
-//	disk.
+//	disk.  Unless writes were left to the host OS, make sure they
+//	all reach the file first.
 //----------------------------------------------------------------------
 
 Disk::~Disk()
 {
+    if (syncPolicy != DiskSyncNone)
+	SyncMappedFile(image, DiskSize, TRUE);
+    UnmapFile(image, DiskSize);
     Close(fileno);
 }
 
@@ -113,43 +208,129 @@ PrintSector (bool writing, int sector, char *data)
 void
 Disk::ReadRequest(int sectorNumber, char* data)
 {
-    int ticks = ComputeLatency(sectorNumber, FALSE);
+    ReadRequest(1, &sectorNumber, data);
+}
+
+void
+Disk::WriteRequest(int sectorNumber, char* data)
+{
+    WriteRequest(1, &sectorNumber, data);
+}
+
+//----------------------------------------------------------------------
+// Disk::ReadRequest/WriteRequest
+// 	Simulate a request to read/write several disk sectors, in the
+//	order given.  The sectors need not be next to each other, but
+//	the head has to visit each in turn: the request takes as long
+//	as that many single-sector requests made back to back, with
+//	no time lost in between.  So consecutive sectors cost one seek,
+//	then one rotation time each.
+//
+//	On a flash disk, the sectors on different channels are
+//	transferred at the same time.
+//
+//	"numSectors" -- how many sectors to read/write
+//	"sectorNumbers" -- which ones
+//	"data" -- the bytes to be written, the buffer to hold the incoming
+//		bytes; sector i is at data[i * SectorSize]
+//----------------------------------------------------------------------
+
+void
+Disk::ReadRequest(int numSectors, int *sectorNumbers, char *data)
+{
+    int ticks = RequestTime(numSectors, sectorNumbers, FALSE);
+    int sector;
 
     ASSERT(!active);				// only one request at a time
-    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
-    
-    DEBUG(dbgDisk, "Reading from sector " << sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    Read(fileno, data, SectorSize);
-    if (debug->IsEnabled('d'))
-	PrintSector(FALSE, sectorNumber, data);
+    for (int i = 0; i < numSectors; i++) {
+	sector = sectorNumbers[i];
+	ASSERT((sector >= 0) && (sector < NumSectors));
+	DEBUG(dbgDisk, "Reading from sector " << sector);
+	bcopy(&image[SectorSize * sector + MagicSize], &data[i * SectorSize],
+	      SectorSize);
+	if (debug->IsEnabled('d'))
+	    PrintSector(FALSE, sector, &data[i * SectorSize]);
+    }
     
     active = TRUE;
-    UpdateLast(sectorNumber);
-    kernel->stats->numDiskReads++;
+    kernel->stats->numDiskReads += numSectors;
     kernel->interrupt->Schedule(this, ticks, DiskInt);
 }
 
 void
-Disk::WriteRequest(int sectorNumber, char* data)
+Disk::WriteRequest(int numSectors, int *sectorNumbers, char *data)
 {
-    int ticks = ComputeLatency(sectorNumber, TRUE);
+    int ticks = RequestTime(numSectors, sectorNumbers, TRUE);
+    int sector;
 
     ASSERT(!active);
-    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
-    
-    DEBUG(dbgDisk, "Writing to sector " << sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    WriteFile(fileno, data, SectorSize);
-    if (debug->IsEnabled('d'))
-	PrintSector(TRUE, sectorNumber, data);
+    for (int i = 0; i < numSectors; i++) {
+	sector = sectorNumbers[i];
+	ASSERT((sector >= 0) && (sector < NumSectors));
+	DEBUG(dbgDisk, "Writing to sector " << sector);
+	bcopy(&data[i * SectorSize], &image[SectorSize * sector + MagicSize],
+	      SectorSize);
+	if (syncPolicy != DiskSyncNone)
+	    SyncMappedFile(&image[SectorSize * sector + MagicSize], SectorSize,
+			   syncPolicy == DiskSyncWait);
+	if (debug->IsEnabled('d'))
+	    PrintSector(TRUE, sector, &data[i * SectorSize]);
+    }
     
     active = TRUE;
-    UpdateLast(sectorNumber);
-    kernel->stats->numDiskWrites++;
+    kernel->stats->numDiskWrites += numSectors;
     kernel->interrupt->Schedule(this, ticks, DiskInt);
 }
 
+//----------------------------------------------------------------------
+// Disk::RequestTime()
+// 	Return how long a request for several sectors will take, and
+//	move the head (or keep the channels busy) accordingly.  On a
+//	rotating disk, each sector is started when the one before it is
+//	done; on a flash disk, they are all started at once, and each
+//	channel works through its share in turn.
+//
+//	"numSectors" -- how many sectors to read/write
+//	"sectorNumbers" -- which ones
+//	"writing" -- is it a write?
+//----------------------------------------------------------------------
+
+int
+Disk::RequestTime(int numSectors, int *sectorNumbers, bool writing)
+{
+    int start = kernel->stats->totalTicks;
+    int now = start;			// when each sector is started
+    int finish = start;			// when the last one is done
+    int latency;
+
+    for (int i = 0; i < numSectors; i++) {
+	latency = Latency(sectorNumbers[i], writing, now);
+	UpdateLast(sectorNumbers[i], now, now + latency);
+	if (now + latency > finish)
+	    finish = now + latency;
+	if (model.kind == DiskRotating)
+	    now += latency;
+    }
+    return finish - start;
+}
+
+//----------------------------------------------------------------------
+// Disk::Peek
+// 	Copy out the contents of a sector, without simulating a request.
+//	This is not something a real disk could do; it is for tools
+//	that need to know what is on the disk without disturbing it.
+//
+//	"sectorNumber" -- the disk sector to look at
+//	"data" -- the buffer to hold its contents
+//----------------------------------------------------------------------
+
+void
+Disk::Peek(int sectorNumber, char *data)
+{
+    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
+    bcopy(&image[SectorSize * sectorNumber + MagicSize], data, SectorSize);
+}
+
 //----------------------------------------------------------------------
 // Disk::CallBack()
 // 	Called by the machine simulation when the disk interrupt occurs.
@@ -169,27 +350,44 @@ Disk::CallBack ()
 //	to be in the middle of a sector that is rotating past the head,
 //	we also return how long until the head is at the next sector boundary.
 //	
-//   	Disk seeks at one track per SeekTime ticks (cf. stats.h)
-//   	and rotates at one sector per RotationTime ticks
+//   	Disk seeks at one track per model.seekTime ticks (by default,
+//	SeekTime in stats.h) and rotates at one sector per
+//	model.rotationTime ticks
+//
+//	"now" -- when the seek starts
 //----------------------------------------------------------------------
 
 int
-Disk::TimeToSeek(int newSector, int *rotation) 
+Disk::TimeToSeek(int newSector, int now, int *rotation) 
 {
-    int newTrack = newSector / SectorsPerTrack;
-    int oldTrack = lastSector / SectorsPerTrack;
-    int seek = abs(newTrack - oldTrack) * SeekTime;
+    int newTrack = Track(newSector);
+    int oldTrack = Track(lastSector);
+    int seek = abs(newTrack - oldTrack) * model.seekTime;
 				// how long will seek take?
-    int over = (kernel->stats->totalTicks + seek) % RotationTime; 
+    int over = (now + seek) % model.rotationTime; 
 				// will we be in the middle of a sector when
 				// we finish the seek?
 
     *rotation = 0;
     if (over > 0)	 	// if so, need to round up to next full sector
-   	*rotation = RotationTime - over;
+   	*rotation = model.rotationTime - over;
     return seek;
 }
 
+//----------------------------------------------------------------------
+// Disk::Track()
+// 	Return which track a sector is on.  A flash disk has no tracks;
+//	all its sectors are equally close.
+//----------------------------------------------------------------------
+
+int
+Disk::Track(int sector)
+{
+    if (model.kind == DiskSolidState)
+	return 0;
+    return sector / model.sectorsPerTrack;
+}
+
 //----------------------------------------------------------------------
 // Disk::ModuloDiff()
 // 	Return number of sectors of rotational delay between target sector
@@ -199,10 +397,11 @@ Disk::TimeToSeek(int newSector, int *rotation)
 int 
 Disk::ModuloDiff(int to, int from)
 {
-    int toOffset = to % SectorsPerTrack;
-    int fromOffset = from % SectorsPerTrack;
+    int toOffset = to % model.sectorsPerTrack;
+    int fromOffset = from % model.sectorsPerTrack;
 
-    return ((toOffset - fromOffset) + SectorsPerTrack) % SectorsPerTrack;
+    return ((toOffset - fromOffset) + model.sectorsPerTrack)
+						% model.sectorsPerTrack;
 }
 
 //----------------------------------------------------------------------
@@ -212,7 +411,8 @@ Disk::ModuloDiff(int to, int from)
 //
 //   	Latency = seek time + rotational latency + transfer time
 //   	Disk seeks at one track per SeekTime ticks (cf. stats.h)
-//   	and rotates at one sector per RotationTime ticks
+//   	and rotates at one sector per RotationTime ticks, unless the
+//	DiskModel says otherwise
 //
 //   	To find the rotational latency, we first must figure out where the 
 //   	disk head will be after the seek (if any).  We then figure out
@@ -229,40 +429,178 @@ Disk::ModuloDiff(int to, int from)
 int
 Disk::ComputeLatency(int newSector, bool writing)
 {
+    return Latency(newSector, writing, kernel->stats->totalTicks);
+}
+
+//----------------------------------------------------------------------
+// Disk::Latency()
+// 	Return how long it will take to read/write a disk sector, if the
+//	request is made at time "now" -- which may be in the future, for
+//	the later sectors of a multi-sector request.  See ComputeLatency.
+//
+//	On a flash disk, it is the time to wait for the sector's channel
+//	to be free, plus the time to transfer the sector.
+//----------------------------------------------------------------------
+
+int
+Disk::Latency(int newSector, bool writing, int now)
+{
+    int rotationTime = model.rotationTime;
+
+    if (model.kind == DiskSolidState) {
+	int wait = channelFree[newSector % model.channels] - now;
+
+	if (wait < 0)
+	    wait = 0;
+	return wait + (writing ? model.writeTime : model.readTime);
+    }
+
     int rotation;
-    int seek = TimeToSeek(newSector, &rotation);
-    int timeAfter = kernel->stats->totalTicks + seek + rotation;
+    int seek = TimeToSeek(newSector, now, &rotation);
+    int timeAfter = now + seek + rotation;
 
 #ifndef NOTRACKBUF	// turn this on if you don't want the track buffer stuff
     // check if track buffer applies
     if ((writing == FALSE) && (seek == 0) 
-		&& (((timeAfter - bufferInit) / RotationTime) 
-	     		> ModuloDiff(newSector, bufferInit / RotationTime))) {
-        DEBUG(dbgDisk, "Request latency = " << RotationTime);
-	return RotationTime; // time to transfer sector from the track buffer
+		&& (((timeAfter - bufferInit) / rotationTime) 
+	     		> ModuloDiff(newSector, bufferInit / rotationTime))) {
+        DEBUG(dbgDisk, "Request latency = " << rotationTime);
+	return rotationTime; // time to transfer sector from the track buffer
     }
 #endif
 
-    rotation += ModuloDiff(newSector, timeAfter / RotationTime) * RotationTime;
+    rotation += ModuloDiff(newSector, timeAfter / rotationTime) * rotationTime;
 
-    DEBUG(dbgDisk, "Request latency = " << (seek + rotation + RotationTime));
-    return(seek + rotation + RotationTime);
+    DEBUG(dbgDisk, "Request latency = " << (seek + rotation + rotationTime));
+    return(seek + rotation + rotationTime);
 }
 
 //----------------------------------------------------------------------
 // Disk::UpdateLast
 //   	Keep track of the most recently requested sector.  So we can know
-//	what is in the track buffer.
+//	what is in the track buffer -- or, on a flash disk, how long the
+//	sector's channel is busy.
+//
+//	"now" -- when the request for it is started
+//	"done" -- when it will be finished
 //----------------------------------------------------------------------
 
 void
-Disk::UpdateLast(int newSector)
+Disk::UpdateLast(int newSector, int now, int done)
 {
     int rotate;
-    int seek = TimeToSeek(newSector, &rotate);
+    int seek = TimeToSeek(newSector, now, &rotate);
     
-    if (seek != 0)
-	bufferInit = kernel->stats->totalTicks + seek + rotate;
+    if (model.kind == DiskSolidState)
+	channelFree[newSector % model.channels] = done;
+    else if (seek != 0)
+	bufferInit = now + seek + rotate;
     lastSector = newSector;
     DEBUG(dbgDisk, "Updating last sector = " << lastSector << " , " << bufferInit);
 }
+
+//----------------------------------------------------------------------
+// DiskTrace::DiskTrace
+// 	Start a trace of disk requests, in a new UNIX file.
+//
+//	"fileName" -- the UNIX file to put it in
+//----------------------------------------------------------------------
+
+DiskTrace::DiskTrace(char *fileName)
+{
+    int magicNum = TraceMagic;
+
+    fileno = OpenForWrite(fileName);
+    WriteFile(fileno, (char *) &magicNum, sizeof(int));
+    numBuffered = 0;
+}
+
+//----------------------------------------------------------------------
+// DiskTrace::~DiskTrace
+// 	Finish the trace.
+//----------------------------------------------------------------------
+
+DiskTrace::~DiskTrace()
+{
+    Flush();
+    Close(fileno);
+}
+
+//----------------------------------------------------------------------
+// DiskTrace::Record
+// 	Add a disk request to the trace, one record per sector.
+//
+//	"numSectors" -- how many sectors it was for
+//	"sectorNumbers" -- which ones
+//	"writing" -- was it a write?
+//	"issue", "complete" -- when it was made, and when it finished
+//----------------------------------------------------------------------
+
+void
+DiskTrace::Record(int numSectors, int *sectorNumbers, bool writing,
+		  int issue, int complete)
+{
+    DiskTraceRecord *r;
+
+    for (int i = 0; i < numSectors; i++) {
+	if (numBuffered == TraceBufferSize)
+	    Flush();
+	r = &buffer[numBuffered++];
+	r->sector = sectorNumbers[i];
+	r->issue = issue;
+	r->complete = complete;
+	r->numSectors = (i == 0) ? numSectors : 0;
+	r->writing = writing;
+	r->pad = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// DiskTrace::Flush
+// 	Write the buffered records out to the UNIX file.
+//----------------------------------------------------------------------
+
+void
+DiskTrace::Flush()
+{
+    if (numBuffered > 0)
+	WriteFile(fileno, (char *) buffer,
+		  numBuffered * sizeof(DiskTraceRecord));
+    numBuffered = 0;
+}
+
+//----------------------------------------------------------------------
+// DiskTrace::Load
+// 	Read a whole trace into memory.  Return an array of its records,
+//	or NULL if the file can't be opened or isn't a disk trace.  The
+//	caller must delete the array.
+//
+//	"fileName" -- the UNIX file the trace is in
+//	"numRecords" -- set to how many records there are
+//----------------------------------------------------------------------
+
+DiskTraceRecord *
+DiskTrace::Load(char *fileName, int *numRecords)
+{
+    DiskTraceRecord *records;
+    int fd = OpenForReadWrite(fileName, FALSE);
+    int magicNum = 0, size;
+
+    if (fd < 0)
+	return NULL;
+    Lseek(fd, 0, 2);
+    size = Tell(fd) - sizeof(int);
+    Lseek(fd, 0, 0);
+    if (size >= 0)
+	Read(fd, (char *) &magicNum, sizeof(int));
+    if (magicNum != TraceMagic || size % sizeof(DiskTraceRecord) != 0) {
+	Close(fd);
+	return NULL;
+    }
+    *numRecords = size / sizeof(DiskTraceRecord);
+    records = new DiskTraceRecord[*numRecords + 1];
+    if (size > 0)
+	Read(fd, (char *) records, size);
+    Close(fd);
+    return records;
+}
@@ -34,6 +34,9 @@
 // and an interrupt is invoked later to signal that the operation completed.
 //
 // The physical disk is in fact simulated via operations on a UNIX file.
+// The file is mapped into memory, so reading or writing a sector is
+// just a copy; when the changes are pushed out to the file is up to
+// the sync policy below.  None of this affects the simulated time.
 //
 // To make life a little more realistic, the simulated time for
 // each operation reflects a "track buffer" -- RAM to store the contents
@@ -46,18 +49,113 @@
 // disks these days now come with a track buffer.
 //
 // The track buffer simulation can be disabled by compiling with -DNOTRACKBUF
+//
+// The disk can also be simulated as flash (an SSD): there is no head,
+// so every sector takes the same time to read, and a longer time to
+// write.  The sectors are spread over several channels, which work
+// in parallel, so the sectors of a multi-sector request on different
+// channels are transferred at the same time.
+//
+// The size of the disk is fixed, since the file system depends on it,
+// but how it is laid out and how fast it is can be chosen when Nachos
+// starts (see DiskModel).
 
 const int SectorSize = 128;		// number of bytes per disk sector
 const int SectorsPerTrack  = 32;	// number of sectors per disk track 
 const int NumTracks = 32;		// number of tracks per disk
 const int NumSectors = (SectorsPerTrack * NumTracks);
 					// total # of sectors per disk
+const int SSDChannels = 4;		// number of channels on a flash disk
+const int MaxSSDChannels = 16;
+
+// When writes to the simulated disk are pushed out to its UNIX file:
+// whenever the host OS likes (they survive Nachos crashing, but not
+// the host); started as soon as each request is made; or each request
+// waits until they are on stable storage.
+
+enum DiskSync { DiskSyncNone, DiskSyncAsync, DiskSyncWait };
+
+// How the simulated disk behaves: what kind it is, and its geometry
+// and timing.  By default, it is the rotating disk described above,
+// with the geometry and timing given by the constants here and in
+// stats.h.
+
+enum DiskKind { DiskRotating, DiskSolidState };
+
+class DiskModel {
+  public:
+    DiskModel();			// The default rotating disk
+
+    bool Parse(char *spec);		// Set from "hdd[:spt,seek,rotation]"
+					// or "ssd[:read,write,channels]";
+					// return FALSE if it is malformed
+    void Print();			// Describe it
+
+    DiskKind kind;
+    int sectorsPerTrack;		// Rotating disk: sectors per track,
+    int seekTime;			// time to seek past one track,
+    int rotationTime;			// and to rotate past one sector
+    int readTime;			// Flash disk: time to read a sector,
+    int writeTime;			// and to write one,
+    int channels;			// and how many it can work on at once
+};
+
+// What a disk trace records about each sector of each disk request.
+// The records of a multi-sector request are kept together, in order;
+// the first of them says how many there are.  The sectors are the
+// ones the file system asked for, not where they are on which disk,
+// so a trace can be replayed however the disks are combined.
+
+class DiskTraceRecord {
+  public:
+    int sector;				// Which sector
+    int issue;				// When the request was made
+    int complete;			// When it finished
+    short numSectors;			// Sectors in the request, on its
+					// first record; 0 on the others
+    char writing;			// Was it a write?
+    char pad;				// Always 0; rounds the record out,
+					// so no stray byte is written
+};
+
+// A binary trace of the requests made to the disks, for replaying
+// later (see SynchDisk::Replay).  If kernel->diskTrace is set, every
+// request made of a SynchDisk is added to it, once it has finished.
+
+#define TraceBufferSize 256		// Records kept before writing them
+					// out to the UNIX file
+
+class DiskTrace {
+  public:
+    DiskTrace(char *fileName);		// Start a trace in a new UNIX file
+    ~DiskTrace();			// Write out what is left, and close
+
+    void Record(int numSectors, int *sectorNumbers, bool writing,
+		int issue, int complete);
+					// Add a request to the trace
+
+    static DiskTraceRecord *Load(char *fileName, int *numRecords);
+					// Read a whole trace back in; NULL
+					// if it can't be read
+
+  private:
+    void Flush();			// Write out the buffered records
+
+    int fileno;				// The UNIX file
+    DiskTraceRecord buffer[TraceBufferSize];
+    int numBuffered;
+};
 
 class Disk : public CallBackObj {
   public:
-    Disk(CallBackObj *toCall);          // Create a simulated disk.  
+    Disk(CallBackObj *toCall, DiskSync sync = DiskSyncNone,
+	 DiskModel *diskModel = NULL, int unit = 0);
+					// Create a simulated disk.  
 					// Invoke toCall->CallBack() 
 					// when each request completes.
+					// If "diskModel" is NULL, simulate
+					// the default disk.  Each "unit"
+					// is kept in a UNIX file of its own.
     ~Disk();				// Deallocate the disk.
     
     void ReadRequest(int sectorNumber, char* data);
@@ -67,6 +165,14 @@ class Disk : public CallBackObj {
     					// Only one request allowed at a time!
     void WriteRequest(int sectorNumber, char* data);
 
+    void ReadRequest(int numSectors, int *sectorNumbers, char *data);
+					// Read/write several sectors, one
+					// after another, in a single request;
+					// "data" holds them back to back.
+					// The disk seeks to each, but only
+					// interrupts once they are all done.
+    void WriteRequest(int numSectors, int *sectorNumbers, char *data);
+
     void CallBack();			// Invoked when disk request 
 					// finishes. In turn calls, callWhenDone.
 
@@ -75,18 +181,38 @@ class Disk : public CallBackObj {
 					// newSector will take: 
 					// (seek + rotational delay + transfer)
 
+    int Track(int sector);		// Which track "sector" is on; always
+					// 0 on a flash disk
+
+    DiskModel *Model() { return &model; }
+
+    void Peek(int sectorNumber, char *data);
+					// Copy out a sector's contents, with
+					// no request and no time passing
+
   private:
     int fileno;				// UNIX file number for simulated disk 
     char diskname[32];			// name of simulated disk's file
+    char *image;			// the file, mapped into memory
+    DiskSync syncPolicy;		// when to push writes out to the file
     CallBackObj *callWhenDone;		// Invoke when any disk request finishes
     bool active;     			// Is a disk operation in progress?
+    DiskModel model;			// How the disk behaves
     int lastSector;			// The previous disk request 
     int bufferInit;			// When the track buffer started 
 					// being loaded
+    int channelFree[MaxSSDChannels];	// When each channel of a flash
+					// disk will be done with its work
 
-    int TimeToSeek(int newSector, int *rotate); // time to get to the new track
+    int TimeToSeek(int newSector, int now, int *rotate);
+					// time to get to the new track
     int ModuloDiff(int to, int from);        // # sectors between to and from
-    void UpdateLast(int newSector);
+    int Latency(int newSector, bool writing, int now);
+					// ComputeLatency, for a request
+					// made at time "now"
+    void UpdateLast(int newSector, int now, int done);
+    int RequestTime(int numSectors, int *sectorNumbers, bool writing);
+					// How long a request will take
 };
 
 #endif // DISK_H
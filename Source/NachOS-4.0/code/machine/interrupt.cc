@@ -23,6 +23,7 @@
 #include "copyright.h"
 #include "interrupt.h"
 #include "main.h"
+#include "profile.h"
 
 // String definitions for debugging messages
 
@@ -245,7 +246,12 @@ void Interrupt::Idle()
 void Interrupt::Halt()
 {
     cout << "\nMachine halting!\n\n";
+#ifndef FILESYS_STUB
+    kernel->fileSystem->Sync(); // write back what's cached in memory
+#endif
     kernel->stats->Print();
+    if (kernel->profiler != NULL)
+        kernel->profiler->Print();
     delete kernel; // Never returns.
 }
 
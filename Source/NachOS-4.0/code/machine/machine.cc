@@ -58,6 +58,7 @@ Machine::Machine(bool debug)
 
     for (i = 0; i < NumTotalRegs; i++)
         registers[i] = 0;
+    llBit = FALSE;
     mainMemory = new char[MemorySize];
     for (i = 0; i < MemorySize; i++)
         mainMemory[i] = 0;
@@ -99,13 +100,17 @@ Machine::~Machine()
 
 void Machine::RaiseException(ExceptionType which, int badVAddr)
 {
+    MachineStatus oldStatus = kernel->interrupt->getStatus();
+
     DEBUG(dbgMach, "Exception: " << exceptionNames[which]);
 
     registers[BadVAddrReg] = badVAddr;
     DelayedLoad(0, 0); // finish anything in progress
+    llBit = FALSE;     // as the return from the exception would
     kernel->interrupt->setStatus(SystemMode);
     ExceptionHandler(which); // interrupts are enabled at this point
-    kernel->interrupt->setStatus(UserMode);
+    kernel->interrupt->setStatus(oldStatus); // a system call can fault on
+                                             // a page of a mapped file
 }
 
 //----------------------------------------------------------------------
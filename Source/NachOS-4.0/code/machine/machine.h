@@ -146,6 +146,11 @@ public:
 	// Read or write 1, 2, or 4 bytes of virtual
 	// memory (at addr).  Return FALSE if a
 	// correct translation couldn't be found.
+
+	void ClearLink() { llBit = FALSE; }
+	// Make the next SC fail, as returning
+	// from an exception does on the real
+	// hardware; called on a context switch
 private:
 	// Routines internal to the machine simulation -- DO NOT call these directly
 	void DelayedLoad(int nextReg, int nextVal);
@@ -171,6 +176,8 @@ private:
 	// Internal data structures
 
 	int registers[NumTotalRegs]; // CPU registers, for executing user programs
+	bool llBit;					 // set by LL; SC only stores if it
+								 // is still set
 
 	bool singleStep; // drop back into the debugger after each
 					 // simulated instruction
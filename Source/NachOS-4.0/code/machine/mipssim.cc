@@ -21,6 +21,8 @@
 #include "machine.h"
 #include "mipssim.h"
 #include "main.h"
+#include "ptable.h"
+#include "profile.h"
 
 static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
 
@@ -66,6 +68,11 @@ Machine::Run()
     for (;;) {
         OneInstruction(instr);
 	kernel->interrupt->OneTick();
+	if (kernel->profiler != NULL)
+	    kernel->profiler->Tick();
+	if (kernel->currentThread->space->exiting)
+	    kernel->processTable->ThreadExit(0);  // another thread of the
+						  // process called Exit
 	if (singleStep && (runUntilTime <= kernel->stats->totalTicks))
 	  Debugger();
     }
@@ -94,6 +101,38 @@ TypeToReg(RegType reg, Instruction *instr)
     }
 }
 
+//----------------------------------------------------------------------
+// ClassOf
+// 	Return which kind of instruction "opCode" is, for the counts
+//	kept in kernel->stats.
+//----------------------------------------------------------------------
+
+static InstructionClass
+ClassOf(int opCode)
+{
+    switch (opCode) {
+      case OP_LB: case OP_LBU: case OP_LH: case OP_LHU:
+      case OP_LW: case OP_LWL: case OP_LWR: case OP_LL:
+	return InstrLoad;
+      case OP_SB: case OP_SH: case OP_SW: case OP_SWL: case OP_SWR:
+      case OP_SC:
+	return InstrStore;
+      case OP_BEQ: case OP_BGEZ: case OP_BGEZAL: case OP_BGTZ:
+      case OP_BLEZ: case OP_BLTZ: case OP_BLTZAL: case OP_BNE:
+      case OP_J: case OP_JAL: case OP_JALR: case OP_JR:
+	return InstrBranch;
+      case OP_MULT: case OP_MULTU: case OP_DIV: case OP_DIVU:
+      case OP_MFHI: case OP_MFLO: case OP_MTHI: case OP_MTLO:
+	return InstrMultDiv;
+      case OP_SYSCALL:
+	return InstrSyscall;
+      case OP_RFE: case OP_UNIMP: case OP_RES:
+	return InstrOther;
+      default:
+	return InstrALU;
+    }
+}
+
 //----------------------------------------------------------------------
 // Machine::OneInstruction
 // 	Execute one instruction from a user-level program
@@ -134,6 +173,8 @@ Machine::OneInstruction(Instruction *instr)
 	return;			// exception occurred
     instr->value = raw;
     instr->Decode();
+    if (kernel->stats->countInstructions)
+	kernel->stats->numInstructions[ClassOf(instr->opCode)]++;
 
     if (debug->IsEnabled('m')) {
         struct OpString *str = &opStrings[instr->opCode];
@@ -308,6 +349,19 @@ Machine::OneInstruction(Instruction *instr)
 	nextLoadReg = instr->rt;
 	nextLoadValue = value;
 	break;
+
+      case OP_LL:		// LW, noting that an SC may follow
+	tmp = registers[instr->rs] + instr->extra;
+	if (tmp & 0x3) {
+	    RaiseException(AddressErrorException, tmp);
+	    return;
+	}
+	if (!ReadMem(tmp, 4, &value))
+	    return;
+	llBit = TRUE;
+	nextLoadReg = instr->rt;
+	nextLoadValue = value;
+	break;
     	
       case OP_LWL:	  
 	tmp = registers[instr->rs] + instr->extra;
@@ -548,6 +602,22 @@ Machine::OneInstruction(Instruction *instr)
 		(registers[instr->rs] + instr->extra), 4, registers[instr->rt]))
 	    return;
 	break;
+
+      case OP_SC:		// SW, unless anything else may have run
+				// since the LL; rt says which
+	tmp = registers[instr->rs] + instr->extra;
+	if (tmp & 0x3) {
+	    RaiseException(AddressErrorException, tmp);
+	    return;
+	}
+	if (llBit) {
+	    if (!WriteMem(tmp, 4, registers[instr->rt]))
+		return;
+	    llBit = FALSE;
+	    registers[instr->rt] = 1;
+	} else
+	    registers[instr->rt] = 0;
+	break;
 	
       case OP_SWL:	  
 	tmp = registers[instr->rs] + instr->extra;
@@ -10,6 +10,7 @@
 #include "copyright.h"
 #include "debug.h"
 #include "stats.h"
+#include "sysdep.h"
 
 //----------------------------------------------------------------------
 // Statistics::Statistics
@@ -20,8 +21,14 @@ Statistics::Statistics()
 {
     totalTicks = idleTicks = systemTicks = userTicks = 0;
     numDiskReads = numDiskWrites = 0;
+    numDiskRequests = diskSeekTracks = diskLatencyTicks = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numProcesses = spawnTicks = 0;
+    countInstructions = FALSE;
+    for (int i = 0; i < NumInstrClasses; i++)
+	numInstructions[i] = 0;
+    hostStartTime = WallTime();
 }
 
 //----------------------------------------------------------------------
@@ -37,9 +44,36 @@ Statistics::Print()
 		cout << ", system " << systemTicks << ", user " << userTicks <<"\n";
     cout << "Disk I/O: reads " << numDiskReads;
 		cout << ", writes " << numDiskWrites << "\n";
+    if (numDiskRequests > 0) {
+	cout << "Disk scheduling: avg seek "
+	     << (double) diskSeekTracks / numDiskRequests << " tracks";
+	cout << ", avg latency " << diskLatencyTicks / numDiskRequests
+	     << " ticks\n";
+    }
 		cout << "Console I/O: reads " << numConsoleCharsRead;
     cout << ", writes " << numConsoleCharsWritten << "\n";
     cout << "Paging: faults " << numPageFaults << "\n";
+    if (numProcesses > 0) {
+	cout << "Processes: started " << numProcesses;
+	cout << ", avg spawn latency " << spawnTicks / numProcesses
+	     << " ticks\n";
+    }
     cout << "Network I/O: packets received " << numPacketsRecvd;
 		cout << ", sent " << numPacketsSent << "\n";
+    if (countInstructions) {
+	double hostTime = WallTime() - hostStartTime;
+	long long total = 0;
+
+	for (int i = 0; i < NumInstrClasses; i++)
+	    total += numInstructions[i];
+	cout << "Instructions: ALU " << numInstructions[InstrALU];
+	cout << ", load " << numInstructions[InstrLoad];
+	cout << ", store " << numInstructions[InstrStore];
+	cout << ", branch " << numInstructions[InstrBranch];
+	cout << ", mult/div " << numInstructions[InstrMultDiv];
+	cout << ", syscall " << numInstructions[InstrSyscall];
+	cout << ", other " << numInstructions[InstrOther] << "\n";
+	cout << "Host time: " << hostTime << " seconds, "
+	     << total / hostTime / 1000000 << " MIPS\n";
+    }
 }
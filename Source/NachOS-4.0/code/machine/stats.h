@@ -13,6 +13,13 @@
 
 #include "copyright.h"
 
+// The kinds of user instruction that are counted separately, if
+// Statistics::countInstructions is set.
+
+enum InstructionClass { InstrALU, InstrLoad, InstrStore, InstrBranch,
+			InstrMultDiv, InstrSyscall, InstrOther,
+			NumInstrClasses };
+
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
 // many user instructions executed, etc.
@@ -30,11 +37,27 @@ class Statistics {
 
     int numDiskReads;		// number of disk read requests
     int numDiskWrites;		// number of disk write requests
+    int numDiskRequests;	// number of requests finished by SynchDisk
+    int diskSeekTracks;		// tracks the head moved for them
+    long long diskLatencyTicks;	// time they took, including waiting
+				// for the disk (64 bits, like
+				// numInstructions: the sum wraps)
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
+    int numProcesses;		// number of user processes started
+    long long spawnTicks;	// time from their Exec to their first
+				// instruction (64 bits too)
+
+    bool countInstructions;	// count user instructions by class?
+    long long numInstructions[NumInstrClasses];
+				// how many of each kind were executed
+				// (64 bits: 32 would wrap in minutes)
+				// (one that traps is counted again
+				// when it is restarted)
+    double hostStartTime;	// host time Nachos started, in seconds
 
     Statistics(); 		// initialize everything to zero
 
@@ -53,6 +76,8 @@ const int UserTick = 	   1;	// advance for each user-level instruction
 const int SystemTick =	  10; 	// advance each time interrupts are enabled
 const int RotationTime = 500; 	// time disk takes to rotate one sector
 const int SeekTime =	 500;  	// time disk takes to seek past one track
+const int SSDReadTime =	  50;	// time a flash disk takes to read a sector
+const int SSDWriteTime = 250;	// ... and to write one
 const int ConsoleTime =	 100;	// time to read or write one character
 const int NetworkTime =	 100;  	// time to send or receive one packet
 const int TimerTicks = 	 100;  	// (average) time between timer interrupts
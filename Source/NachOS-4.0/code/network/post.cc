@@ -50,6 +50,7 @@ Mail::Mail(PacketHeader pktH, MailHeader mailH, char *msgData)
 MailBox::MailBox()
 { 
     messages = new SynchList<Mail *>(); 
+    pollers = new WaitQueue();
 }
 
 //----------------------------------------------------------------------
@@ -63,6 +64,7 @@ MailBox::MailBox()
 MailBox::~MailBox()
 { 
     delete messages; 
+    delete pollers;
 }
 
 //----------------------------------------------------------------------
@@ -102,6 +104,7 @@ MailBox::Put(PacketHeader pktHdr, MailHeader mailHdr, char *data)
     messages->Append(mail);		// put on the end of the list of 
 					// arrived messages, and wake up 
 					// any waiters
+    pollers->Wake();			// and anybody polling
 }
 
 //----------------------------------------------------------------------
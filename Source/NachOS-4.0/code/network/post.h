@@ -89,6 +89,11 @@ class MailBox {
    				// Atomically get a message out of the 
 				// mailbox (and wait if there is no message 
 				// to get!)
+    bool IsEmpty() { return messages->IsEmpty(); }
+				// Would Get have to wait?
+
+    WaitQueue *pollers;		// Threads in Poll, woken by each message
+
   private:
     SynchList<Mail *> *messages; // A mailbox is just a list of arrived messages
 };
@@ -111,6 +116,9 @@ class PostOfficeInput : public CallBackObj {
 		MailHeader *mailHdr, char *data);
     				// Retrieve a message from "box".  Wait if
 				// there is no message in the box.
+    int NumBoxes() { return numBoxes; }
+    MailBox *Box(int box) { return &boxes[box]; }
+				// For Poll, to look at a box
 
     static void PostalDelivery(void* data);
 				// Wait for incoming messages, 
@@ -0,0 +1,81 @@
+/* aiobench.c
+ *    Benchmark for asynchronous I/O: read a file a block at a time,
+ *    and multiply each block, as a matrix, by itself (as in matmult).
+ *
+ *    This is built twice.  "aiobench" starts reading the next block
+ *    before it works on this one, so the disk and the CPU are busy
+ *    at once.  "syncbench" (built with -DSYNC) reads each block with
+ *    Read, and waits for the disk before it can go on.  Compare the
+ *    total ticks Nachos prints at the end; both exit with the same
+ *    checksum.
+ *
+ *    The file is written first, with AsyncWrite; it has to fit in a
+ *    Nachos file.
+ */
+
+#include "syscall.h"
+
+#define Dim	16		/* a block is a Dim x Dim matrix of bytes */
+#define BlockSize (Dim * Dim)
+#define Blocks	14
+
+char block[2][Dim][Dim];	/* one being read, one being worked on */
+int C[Dim][Dim];
+
+int
+Work(char m[Dim][Dim])
+{
+    int i, j, k, sum = 0;
+
+    for (i = 0; i < Dim; i++)
+	for (j = 0; j < Dim; j++) {
+	    C[i][j] = 0;
+	    for (k = 0; k < Dim; k++)
+		C[i][j] += m[i][k] * m[k][j];
+	    sum += C[i][j];
+	}
+    return sum;
+}
+
+int
+main()
+{
+    OpenFileId id;
+    char *p = block[0][0];
+    int b, i, sum = 0;
+#ifndef SYNC
+    IOHandle next;
+#endif
+
+    Create("aio.dat");
+    id = Open("aio.dat");
+    if (id < 0)
+	Exit(-1);
+    for (b = 0; b < Blocks; b++) {
+	for (i = 0; i < BlockSize; i++)
+	    p[i] = 1 + (b + i) % 7;	/* no zeroes: Read stops at one */
+	if (WaitIO(AsyncWrite(p, BlockSize, id, 0)) != BlockSize)
+	    Exit(-1);
+    }
+    Seek(0, id);
+
+#ifdef SYNC
+    for (b = 0; b < Blocks; b++) {
+	if (Read(block[0][0], BlockSize, id) != BlockSize)
+	    Exit(-1);
+	sum += Work(block[0]);
+    }
+#else
+    next = AsyncRead(block[0][0], BlockSize, id, 0);
+    for (b = 0; b < Blocks; b++) {
+	if (WaitIO(next) != BlockSize)
+	    Exit(-1);
+	if (b + 1 < Blocks)		/* read ahead while we work */
+	    next = AsyncRead(block[(b + 1) % 2][0], BlockSize, id, 0);
+	sum += Work(block[b % 2]);
+    }
+#endif
+
+    Close(id);
+    Exit(sum);
+}
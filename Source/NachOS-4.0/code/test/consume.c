@@ -0,0 +1,25 @@
+/* consume.c
+ *    Test program for pipes: read ConsoleInput until the end of it,
+ *    and print how many bytes and lines there were.
+ */
+
+#include "syscall.h"
+
+int
+main()
+{
+    char buffer[100];
+    int i, n, bytes = 0, lines = 0;
+
+    while ((n = Read(buffer, 100, ConsoleInput)) > 0) {
+	bytes += n;
+	for (i = 0; i < n; i++)
+	    if (buffer[i] == '\n')
+		lines++;
+    }
+    PrintNum(bytes);
+    PrintChar(' ');
+    PrintNum(lines);
+    PrintChar('\n');
+    Exit(bytes);
+}
@@ -0,0 +1,50 @@
+/* counter.c 
+ *    Test program for user locks: several threads add to a shared
+ *    counter, with a lock held.  The threads yield inside the
+ *    critical section now and then, to make the others wait for it.
+ *
+ *    Exits with the final count, which should be Workers * Adds.
+ */
+
+#include "syscall.h"
+#include "mutex.h"
+
+#define Workers	4
+#define Adds	500
+
+Mutex lock;
+int counter;
+
+int
+Add(int n)
+{
+    int i, tmp;
+
+    for (i = 0; i < n; i++) {
+	MutexLock(&lock);
+	tmp = counter;
+	if (i % 50 == 0)
+	    ThreadYield();	/* let the others find the lock held */
+	counter = tmp + 1;
+	MutexUnlock(&lock);
+    }
+    return 0;
+}
+
+int
+main()
+{
+    ThreadId workers[Workers];
+    int i;
+
+    MutexInit(&lock);
+    counter = 0;
+    for (i = 0; i < Workers; i++)
+	workers[i] = ThreadFork(Add, Adds);
+    for (i = 0; i < Workers; i++)
+	if (workers[i] >= 0)
+	    ThreadJoin(workers[i]);
+
+    PrintNum(counter);
+    Exit(counter);
+}
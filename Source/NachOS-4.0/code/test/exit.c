@@ -0,0 +1,13 @@
+/* exit.c
+ *	Simple program to test whether Exit works: it ends right away,
+ *	returning its status to whoever Joins it.
+ */
+
+#include "syscall.h"
+
+int
+main()
+{
+    Exit(3);
+    /* not reached */
+}
@@ -0,0 +1,49 @@
+/* mmap.c
+ *    Test program for memory-mapped files: write a file with Write,
+ *    change it through a mapping, and read it back with Read.
+ *
+ *    The file is more than a page, and not a whole number of them;
+ *    the mapping is bigger than the file, which must not grow.
+ *
+ *    Exits with the number of bytes that came back changed, which
+ *    should be Size.
+ */
+
+#include "syscall.h"
+
+#define Size	1000
+
+char buffer[Size];
+
+int
+main()
+{
+    OpenFileId id;
+    char *map;
+    int i, good = 0;
+
+    Create("mmap.dat");
+    id = Open("mmap.dat");
+    if (id < 0)
+	Exit(-1);
+    for (i = 0; i < Size; i++)
+	buffer[i] = 'a' + i % 26;
+    Write(buffer, Size, id);
+
+    map = Mmap(id, 0, Size + 100);
+    if (map == 0)
+	Exit(-1);
+    for (i = 0; i < Size + 100; i++)	/* each page is read in when */
+	map[i] = map[i] - 'a' + 'A';	/* it is first touched */
+    Munmap(map);
+
+    Seek(0, id);
+    if (Read(buffer, Size, id) != Size || Seek(-1, id) != Size)
+	Exit(-1);
+    for (i = 0; i < Size; i++) {
+	if (buffer[i] == 'A' + i % 26)
+	    good++;
+    }
+    Close(id);
+    Exit(good);
+}
@@ -0,0 +1,43 @@
+/* mutex.c
+ *    Locks built on Wait and Wake (see mutex.h).
+ *
+ *    The lock word says whether anyone might be asleep on it, so
+ *    that MutexUnlock only calls Wake when it has to.  A thread that
+ *    finds the lock held marks it 2 before waiting; since it can't
+ *    tell whether others are still waiting once it is woken, it
+ *    takes the lock as 2 as well.  At worst that costs one Wake
+ *    that finds nobody.
+ */
+
+#include "syscall.h"
+#include "mutex.h"
+
+void
+MutexInit(Mutex *m)
+{
+    m->state = 0;
+}
+
+void
+MutexLock(Mutex *m)
+{
+    int c;
+
+    c = CompareAndSwap(&m->state, 0, 1);
+    if (c == 0)
+	return;			/* it was free: no system call */
+
+    if (c != 2)
+	c = AtomicSwap(&m->state, 2);
+    while (c != 0) {
+	Wait(&m->state, 2);	/* returns at once if it changed */
+	c = AtomicSwap(&m->state, 2);
+    }
+}
+
+void
+MutexUnlock(Mutex *m)
+{
+    if (AtomicSwap(&m->state, 0) == 2)
+	Wake(&m->state, 1);
+}
@@ -0,0 +1,27 @@
+/* mutex.h
+ *    Locks for the threads of user programs, kept in user memory.
+ *
+ *    Taking a lock that is free, and releasing one that nobody is
+ *    waiting for, are done with an atomic instruction or two and
+ *    never enter the kernel; only a thread that has to wait for a
+ *    lock, or has to wake a waiter, makes a system call (Wait, Wake).
+ *
+ *    A program using them is linked with mutex.o.
+ */
+
+#ifndef MUTEX_H
+#define MUTEX_H
+
+typedef struct {
+    int state;		/* 0 free, 1 held, 2 held and maybe waited for */
+} Mutex;
+
+void MutexInit(Mutex *m);
+void MutexLock(Mutex *m);
+void MutexUnlock(Mutex *m);
+
+/* In start.S */
+int CompareAndSwap(int *addr, int old, int new);
+int AtomicSwap(int *addr, int value);
+
+#endif /* MUTEX_H */
@@ -0,0 +1,53 @@
+/* pmatmult.c 
+ *    Test program for user threads: matrix multiplication, with the
+ *    rows of the result split among several threads sharing the
+ *    address space.
+ *
+ *    Each thread returns the number of rows it did; returning from
+ *    the function a thread runs ends it, like calling ThreadExit.
+ */
+
+#include "syscall.h"
+
+#define Dim 	16
+#define Workers	4
+
+int A[Dim][Dim];
+int B[Dim][Dim];
+int C[Dim][Dim];
+
+int
+Multiply(int first)
+{
+    int i, j, k;
+
+    for (i = first; i < Dim; i += Workers)
+	for (j = 0; j < Dim; j++)
+            for (k = 0; k < Dim; k++)
+		 C[i][j] += A[i][k] * B[k][j];
+    return Dim / Workers;
+}
+
+int
+main()
+{
+    ThreadId workers[Workers];
+    int i, j, rows = 0;
+
+    for (i = 0; i < Dim; i++)		/* first initialize the matrices */
+	for (j = 0; j < Dim; j++) {
+	     A[i][j] = i;
+	     B[i][j] = j;
+	     C[i][j] = 0;
+	}
+
+    for (i = 0; i < Workers; i++)	/* then multiply them together */
+	workers[i] = ThreadFork(Multiply, i);
+    for (i = 0; i < Workers; i++)
+	if (workers[i] >= 0)
+	    rows += ThreadJoin(workers[i]);
+
+    if (rows != Dim)
+	Exit(-1);
+    Exit(C[Dim-1][Dim-1]);		/* and then we're done */
+}
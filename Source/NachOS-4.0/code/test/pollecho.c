@@ -0,0 +1,67 @@
+/* pollecho.c
+ *    Test program for Poll: an event loop over two sources at once.
+ *    A second thread computes for a while and writes a "tick" into a
+ *    pipe, a few times, then closes it; meanwhile, the main thread
+ *    echoes whatever is typed at the console.  It waits for both with
+ *    one Poll, so it takes no CPU time while neither has anything.
+ *
+ *    Exits, once the pipe is closed, with the number of ticks read.
+ */
+
+#include "syscall.h"
+
+#define Ticks	5
+
+OpenFileId fds[2];
+
+int
+Ticker(int arg)
+{
+    int i, j, k = 0;
+
+    for (i = 0; i < Ticks; i++) {
+	for (j = 0; j < 20000; j++)	/* some work */
+	    k += j;
+	Write("t", 1, fds[1]);
+    }
+    Close(fds[1]);
+    return k;
+}
+
+int
+main()
+{
+    PollFd poll[2];
+    char buffer[64];
+    int n, ticks = 0;
+
+    if (Pipe(fds) < 0)
+	Exit(-1);
+    poll[0].id = fds[0];
+    poll[0].events = PollIn;
+    poll[1].id = ConsoleInput;
+    poll[1].events = PollIn;
+    ThreadFork(Ticker, 0);
+
+    for (;;) {
+	if (Poll(poll, 2, -1) < 0)
+	    Exit(-1);
+	if (poll[0].revents & PollIn) {
+	    n = Read(buffer, sizeof(buffer), fds[0]);
+	    if (n <= 0)
+		break;			/* the ticker is done */
+	    ticks += n;
+	    PrintString("tick\n");
+	}
+	if (poll[1].revents & PollIn) {
+	    n = Read(buffer, sizeof(buffer) - 1, ConsoleInput);
+	    if (n <= 0)
+		poll[1].events = 0;	/* end of input: stop asking */
+	    else {
+		buffer[n] = '\0';
+		PrintString(buffer);
+	    }
+	}
+    }
+    Exit(ticks);
+}
@@ -0,0 +1,24 @@
+/* produce.c
+ *    Test program for pipes: write lines of text to ConsoleOutput,
+ *    for "produce | consume" at the shell.
+ */
+
+#include "syscall.h"
+
+#define Lines	100
+
+int
+main()
+{
+    char line[32];
+    int i, n;
+
+    for (i = 0; i < 26; i++)
+	line[i] = 'a' + i;
+    line[26] = '\n';
+
+    n = 0;
+    for (i = 0; i < Lines; i++)
+	n += Write(line, 27, ConsoleOutput);
+    Exit(n);
+}
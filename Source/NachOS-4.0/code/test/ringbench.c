@@ -0,0 +1,112 @@
+/* ringbench.c
+ *    Benchmark for batched system calls: write a file a few bytes at a
+ *    time, read it back the same way, and print a line of stars, one
+ *    PrintChar for each -- many small calls.
+ *
+ *    This is built twice.  "ringbench" puts the calls in the syscall
+ *    ring, and has the kernel do them RingEntries at a time, with one
+ *    Enter.  "trapbench" (built with -DSYNC) makes each call itself.
+ *    Both exit with the same checksum; compare the ticks Nachos prints
+ *    at the end, or the traps shown by "-d u".
+ */
+
+#include "syscall.h"
+
+#define Records	200
+#define RecordSize 4
+
+char record[RecordSize + 1] = "abc\n";	/* no zeroes: Write stops at one */
+char data[Records * RecordSize];
+int sum = 0;
+
+#ifdef SYNC
+
+void
+Call(int op, int a, int b, int c)
+{
+    switch (op) {
+      case SC_Write:
+	sum += Write((char *) a, b, c);
+	break;
+      case SC_Read:
+	sum += Read((char *) a, b, c);
+	break;
+      case SC_Seek:
+	sum += Seek(a, b);
+	break;
+      case SC_PrintChar:
+	PrintChar((char) a);
+	break;
+    }
+}
+
+void
+Flush()
+{
+}
+
+#else
+
+SyscallRing *ring;
+
+/* Have the kernel do the calls in the ring, and add up their results. */
+
+void
+Flush()
+{
+    Enter(RingEntries);
+    while (ring->cqHead != ring->cqTail) {
+	sum += ring->cq[ring->cqHead % RingEntries].result;
+	ring->cqHead++;
+    }
+}
+
+void
+Call(int op, int a, int b, int c)
+{
+    SubmitEntry *entry;
+
+    if (ring->sqTail - ring->sqHead == RingEntries)
+	Flush();
+    entry = &ring->sq[ring->sqTail % RingEntries];
+    entry->op = op;
+    entry->arg[0] = a;
+    entry->arg[1] = b;
+    entry->arg[2] = c;
+    entry->tag = ring->sqTail;
+    ring->sqTail++;
+}
+
+#endif
+
+int
+main()
+{
+    OpenFileId id;
+    int i;
+
+    Create("ring.dat");
+    id = Open("ring.dat");
+    if (id < 0)
+	Exit(-1);
+#ifndef SYNC
+    ring = RingSetup();
+    if (ring == 0)
+	Exit(-1);
+#endif
+
+    for (i = 0; i < Records; i++)
+	Call(SC_Write, (int) record, RecordSize, id);
+    Call(SC_Seek, 0, id, 0);
+    for (i = 0; i < Records; i++)
+	Call(SC_Read, (int) &data[i * RecordSize], RecordSize, id);
+    for (i = 0; i < Records; i++)
+	Call(SC_PrintChar, '*', 0, 0);
+    Call(SC_PrintChar, '\n', 0, 0);
+    Flush();
+
+    for (i = 0; i < Records * RecordSize; i++)
+	sum += data[i];
+    Close(id);
+    Exit(sum);
+}
@@ -1,12 +1,36 @@
 #include "syscall.h"
 
+/* Run "left | right": the output of the first program is the input
+ * of the second.  Both ends of the pipe are closed here once the
+ * programs have them, so that the second sees the end of its input
+ * when the first exits.
+ */
+void RunPipeline(char *left, char *right)
+{
+    OpenFileId fds[2];
+    SpaceId first, second;
+
+    if (Pipe(fds) < 0)
+        return;
+    first = ExecIO(left, ConsoleInput, fds[1]);
+    second = ExecIO(right, fds[0], ConsoleOutput);
+    Close(fds[0]);
+    Close(fds[1]);
+
+    if (first >= 0)
+        Join(first);
+    if (second >= 0)
+        Join(second);
+}
+
 int main()
 {
     SpaceId newProc;
     OpenFileId input = ConsoleInput;
     OpenFileId output = ConsoleOutput;
     char prompt[2], ch, buffer[60];
-    int i;
+    char *right;
+    int i, bar;
 
     prompt[0] = '-';
     prompt[1] = '-';
@@ -28,8 +52,24 @@ int main()
 
         if (i > 0)
         {
-            newProc = Exec(buffer);
-            Join(newProc);
+            for (bar = 0; buffer[bar] != '\0' && buffer[bar] != '|'; bar++)
+                ;
+
+            if (buffer[bar] == '|') // a | b
+            {
+                right = &buffer[bar + 1];
+                while (*right == ' ')
+                    right++;
+                buffer[bar] = '\0';
+                while (bar > 0 && buffer[bar - 1] == ' ')
+                    buffer[--bar] = '\0';
+                RunPipeline(buffer, right);
+            }
+            else
+            {
+                newProc = Exec(buffer);
+                Join(newProc);
+            }
         }
     }
 }
@@ -0,0 +1,26 @@
+/* shmcons.c
+ *    Test program for shared memory: take the words shmprod sends
+ *    through the ring, until the end marker.
+ *
+ *    Exits with how many came in order.
+ */
+
+#include "syscall.h"
+#include "shmring.h"
+
+int
+main()
+{
+    Ring *ring = (Ring *) 0x18000;	/* page 768, of the 1024 allowed */
+    int value, good = 0, n = 0;
+
+    if (ShmAttach(RingKey, (char *) ring) < 0)
+	Exit(-1);
+
+    while ((value = RingGet(ring)) != -1) {
+	if (value == n)
+	    good++;
+	n++;
+    }
+    Exit(good);
+}
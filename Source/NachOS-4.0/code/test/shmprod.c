@@ -0,0 +1,34 @@
+/* shmprod.c
+ *    Test program for shared memory: send a megabyte of words to a
+ *    child program (shmcons) through a ring in a shared segment.
+ *
+ *    Exits with the number of words the child got right, which
+ *    should be Words.
+ */
+
+#include "syscall.h"
+#include "shmring.h"
+
+#define Words	(1024 * 1024 / 4)
+
+int
+main()
+{
+    Ring *ring = (Ring *) 0x10000;	/* where we put it; shmcons */
+    SpaceId child;			/* uses another address */
+    int i;
+
+    if (ShmCreate(RingKey, sizeof(Ring)) < 0
+		|| ShmAttach(RingKey, (char *) ring) < 0)
+	Exit(-1);
+
+    child = Exec("shmcons");
+    if (child < 0)
+	Exit(-1);
+    for (i = 0; i < Words; i++)
+	RingPut(ring, i);
+    RingPut(ring, -1);			/* the end */
+
+    ShmDetach((char *) ring);
+    Exit(Join(child));
+}
@@ -0,0 +1,41 @@
+/* shmring.c
+ *    A ring of words in shared memory (see shmring.h).
+ *
+ *    There is one writer and one reader, so each index is only ever
+ *    changed by one side.  A side waits on the other's index, with
+ *    the value it saw, so a change between looking and waiting makes
+ *    Wait return at once.  After moving its own index, a side wakes
+ *    the other if the ring looks like the other might be waiting.
+ */
+
+#include "syscall.h"
+#include "shmring.h"
+
+void
+RingPut(Ring *r, int value)
+{
+    int head = r->head, tail;
+
+    while (head - (tail = r->tail) == RingSlots)
+	Wait(&r->tail, tail);		/* full */
+
+    r->data[head % RingSlots] = value;
+    r->head = head + 1;
+    if (r->tail == head)		/* it was empty */
+	Wake(&r->head, 1);
+}
+
+int
+RingGet(Ring *r)
+{
+    int tail = r->tail, head, value;
+
+    while ((head = r->head) == tail)
+	Wait(&r->head, head);		/* empty */
+
+    value = r->data[tail % RingSlots];
+    r->tail = tail + 1;
+    if (r->head - tail == RingSlots)	/* it was full */
+	Wake(&r->tail, 1);
+    return value;
+}
@@ -0,0 +1,24 @@
+/* shmring.h
+ *    A ring of words in shared memory, for one program to send to
+ *    another.  Neither side makes a system call unless it has to wait
+ *    (Wait), or the other side may be waiting (Wake).
+ *
+ *    A program using it is linked with shmring.o.
+ */
+
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#define RingKey		7	/* the shared memory segment it lives in */
+#define RingSlots	120
+
+typedef struct {
+    int head;			/* how many words have been put in */
+    int tail;			/* how many have been taken out */
+    int data[RingSlots];
+} Ring;
+
+void RingPut(Ring *r, int value);	/* wait while the ring is full */
+int RingGet(Ring *r);			/* wait while it is empty */
+
+#endif /* SHMRING_H */
@@ -0,0 +1,30 @@
+/* spawn.c
+ *	Test program for Exec and Join, and to measure how long it takes
+ *	to start a process: run the "exit" program many times over, one
+ *	after another, and check the status each run returns.
+ *
+ *	The average spawn latency is among the statistics printed when
+ *	Nachos halts.
+ */
+
+#include "syscall.h"
+
+#define Runs	50
+
+int
+main()
+{
+    SpaceId id;
+    int i, failed = 0;
+
+    for (i = 0; i < Runs; i++) {
+	id = Exec("exit");
+	if (id < 0 || Join(id) != 3)
+	    failed++;
+    }
+    PrintString("spawn: runs failed: ");
+    PrintNum(failed);
+    PrintString("\n");
+    Halt();
+    /* not reached */
+}
@@ -0,0 +1,71 @@
+/* vecio.c
+ *    Test program for vectored I/O: write a file of records, each put
+ *    together from three pieces -- a key, a name and a newline -- with
+ *    one WriteV, and read it back into the pieces with ReadV.
+ *
+ *    Exits with the number of records that came back as they went
+ *    out, or -1 if a call fails.
+ */
+
+#include "syscall.h"
+
+#define Records	20
+#define KeySize	4
+#define NameSize 8
+#define RecordSize (KeySize + NameSize + 1)
+
+char key[KeySize], name[NameSize], newline = '\n';
+char keyIn[KeySize], nameIn[NameSize], newlineIn;
+
+void
+Fill(int n)
+{
+    int i;
+
+    for (i = 0; i < KeySize; i++)
+	key[i] = '0' + (n >> (3 * (KeySize - 1 - i))) % 8;
+    for (i = 0; i < NameSize; i++)
+	name[i] = 'a' + (n + i) % 26;
+}
+
+int
+main()
+{
+    IOVec out[3], in[3];
+    OpenFileId id;
+    int n, i, same = 0;
+
+    out[0].base = key;		out[0].len = KeySize;
+    out[1].base = name;		out[1].len = NameSize;
+    out[2].base = &newline;	out[2].len = 1;
+    in[0].base = keyIn;		in[0].len = KeySize;
+    in[1].base = nameIn;	in[1].len = NameSize;
+    in[2].base = &newlineIn;	in[2].len = 1;
+
+    Create("vecio.dat");
+    id = Open("vecio.dat");
+    if (id < 0)
+	Exit(-1);
+    for (n = 0; n < Records; n++) {
+	Fill(n);
+	if (WriteV(out, 3, id) != RecordSize)
+	    Exit(-1);
+    }
+
+    Seek(0, id);
+    for (n = 0; n < Records; n++) {
+	if (ReadV(in, 3, id) != RecordSize)
+	    Exit(-1);
+	Fill(n);
+	for (i = 0; i < KeySize && keyIn[i] == key[i]; i++)
+	    ;
+	if (i < KeySize)
+	    continue;
+	for (i = 0; i < NameSize && nameIn[i] == name[i]; i++)
+	    ;
+	if (i == NameSize && newlineIn == '\n')
+	    same++;
+    }
+    Close(id);
+    Exit(same);
+}
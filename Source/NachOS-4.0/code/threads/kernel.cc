@@ -17,6 +17,16 @@
 #include "synchconsole.h"
 #include "synchdisk.h"
 #include "post.h"
+#include "bitmap.h"
+#include "ptable.h"
+#include "futex.h"
+#include "pipe.h"
+#include "shm.h"
+#include "mmap.h"
+#include "aio.h"
+#include "ring.h"
+#include "systrace.h"
+#include "profile.h"
 
 //----------------------------------------------------------------------
 // Kernel::Kernel
@@ -30,6 +40,15 @@ Kernel::Kernel(int argc, char **argv)
     debugUserProg = FALSE;
     consoleIn = NULL;  // default is stdin
     consoleOut = NULL; // default is stdout
+    diskSchedule = DiskCLOOK;
+    diskSync = DiskSyncNone;
+    diskArray = DiskStriped;
+    numDisks = 1;
+    diskTraceFile = NULL;
+    syscallTraceFile = NULL;
+    profileTicks = 0;
+    countInstructions = FALSE;
+    foldedFile = NULL;
 #ifndef FILESYS_STUB
     formatFlag = FALSE;
 #endif
@@ -68,6 +87,76 @@ Kernel::Kernel(int argc, char **argv)
             formatFlag = TRUE;
 #endif
         }
+        else if (strcmp(argv[i], "-ds") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is the policy
+            if (strcmp(argv[i + 1], "fcfs") == 0)
+                diskSchedule = DiskFCFS;
+            else if (strcmp(argv[i + 1], "scan") == 0)
+                diskSchedule = DiskSCAN;
+            else if (strcmp(argv[i + 1], "clook") == 0)
+                diskSchedule = DiskCLOOK;
+            else
+                cout << "Unknown disk schedule " << argv[i + 1] << "\n";
+            i++;
+        }
+        else if (strcmp(argv[i], "-dsync") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is the policy
+            if (strcmp(argv[i + 1], "none") == 0)
+                diskSync = DiskSyncNone;
+            else if (strcmp(argv[i + 1], "async") == 0)
+                diskSync = DiskSyncAsync;
+            else if (strcmp(argv[i + 1], "wait") == 0)
+                diskSync = DiskSyncWait;
+            else
+                cout << "Unknown disk sync policy " << argv[i + 1] << "\n";
+            i++;
+        }
+        else if (strcmp(argv[i], "-dm") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is the disk model
+            if (!diskModel.Parse(argv[i + 1]))
+                cout << "Unknown disk model " << argv[i + 1] << "\n";
+            i++;
+        }
+        else if (strcmp(argv[i], "-raid") == 0)
+        {
+            ASSERT(i + 2 < argc); // next arguments are level and disks
+            diskArray = (atoi(argv[i + 1]) == 1) ? DiskMirrored : DiskStriped;
+            numDisks = atoi(argv[i + 2]);
+            ASSERT(numDisks >= 1 && numDisks <= MaxDisks);
+            i += 2;
+        }
+        else if (strcmp(argv[i], "-dt") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is the trace file
+            diskTraceFile = argv[i + 1];
+            i++;
+        }
+        else if (strcmp(argv[i], "-st") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is the trace file
+            syscallTraceFile = argv[i + 1];
+            i++;
+        }
+        else if (strcmp(argv[i], "-prof") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is the sampling interval
+            profileTicks = atoi(argv[i + 1]);
+            ASSERT(profileTicks > 0);
+            i++;
+        }
+        else if (strcmp(argv[i], "-ic") == 0)
+        {
+            countInstructions = TRUE;
+        }
+        else if (strcmp(argv[i], "-fold") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is the folded stacks file
+            foldedFile = argv[i + 1];
+            i++;
+        }
         else if (strcmp(argv[i], "-n") == 0)
         {
             ASSERT(i + 1 < argc); // next argument is float
@@ -88,6 +177,15 @@ Kernel::Kernel(int argc, char **argv)
 #ifndef FILESYS_STUB
             cout << "Partial usage: nachos [-nf]\n";
 #endif
+            cout << "Partial usage: nachos [-ds fcfs|scan|clook]\n";
+            cout << "Partial usage: nachos [-dsync none|async|wait]\n";
+            cout << "Partial usage: nachos [-dm hdd[:spt,seek,rotation]]\n";
+            cout << "Partial usage: nachos [-dm ssd[:read,write,channels]]\n";
+            cout << "Partial usage: nachos [-raid 0|1 numDisks]\n";
+            cout << "Partial usage: nachos [-dt traceFile]\n";
+            cout << "Partial usage: nachos [-st traceFile]\n";
+            cout << "Partial usage: nachos [-prof ticks] [-fold foldedFile]\n";
+            cout << "Partial usage: nachos [-ic]\n";
             cout << "Partial usage: nachos [-n #] [-m #]\n";
         }
     }
@@ -109,13 +207,32 @@ void Kernel::Initialize()
     currentThread->setStatus(RUNNING);
 
     stats = new Statistics();       // collect statistics
+    stats->countInstructions = countInstructions;
     interrupt = new Interrupt;      // start up interrupt handling
     scheduler = new Scheduler();    // initialize the ready queue
     alarm = new Alarm(randomSlice); // start up time slicing
     machine = new Machine(debugUserProg);
+    frameMap = new Bitmap(NumPhysPages);
+    processTable = new ProcessTable();
+    futexes = new FutexTable();
+    pipes = new PipeTable();
+    shm = new ShmTable();
+    mappings = new MmapTable();
+    aio = new AioTable();
+    rings = new RingTable();
+    syscallTrace = NULL;
+    if (syscallTraceFile != NULL)
+        syscallTrace = new SyscallTrace(syscallTraceFile);
+    profiler = NULL;
+    if (profileTicks > 0)
+        profiler = new Profiler(profileTicks, foldedFile);
     synchConsoleIn = new SynchConsoleInput(consoleIn);    // input from stdin
     synchConsoleOut = new SynchConsoleOutput(consoleOut); // output to stdout
-    synchDisk = new SynchDisk();                          //
+    diskTrace = NULL;
+    if (diskTraceFile != NULL)
+        diskTrace = new DiskTrace(diskTraceFile);
+    synchDisk = new SynchDisk(diskSchedule, diskSync, &diskModel,
+                              diskArray, numDisks);
 #ifdef FILESYS_STUB
     fileSystem = new FileSystem();
 #else
@@ -138,10 +255,21 @@ Kernel::~Kernel()
     delete interrupt;
     delete scheduler;
     delete alarm;
+    delete profiler;
+    delete syscallTrace;
+    delete rings;
+    delete aio;
+    delete mappings;
+    delete shm;
+    delete pipes;
+    delete futexes;
+    delete processTable;
+    delete frameMap;
     delete machine;
     delete synchConsoleIn;
     delete synchConsoleOut;
     delete synchDisk;
+    delete diskTrace;
     delete fileSystem;
     delete postOfficeIn;
     delete postOfficeOut;
@@ -175,6 +303,36 @@ void Kernel::ThreadSelfTest()
     delete synchList;
 }
 
+//----------------------------------------------------------------------
+// Kernel::Benchmark
+//      Time the routines that sit on the kernel's hot paths, and
+//      print the results.
+//----------------------------------------------------------------------
+
+void Kernel::Benchmark()
+{
+    LibBenchmark(); // bitmaps used for disk and memory allocation
+    synchDisk->Benchmark(); // disk scheduling policies
+#ifndef FILESYS_STUB
+    fileSystem->Benchmark(); // creating small files
+#endif
+}
+
+//----------------------------------------------------------------------
+// Kernel::DiskReplay
+//      Replay a disk trace captured with -dt, and print how the disks
+//      cope with it.  Anything the file system has cached is written
+//      back first, so that the replay doesn't race with it.
+//----------------------------------------------------------------------
+
+void Kernel::DiskReplay(char *traceFile)
+{
+#ifndef FILESYS_STUB
+    fileSystem->Sync();
+#endif
+    synchDisk->Replay(traceFile);
+}
+
 //----------------------------------------------------------------------
 // Kernel::ConsoleTest
 //      Test the synchconsole
@@ -274,10 +432,13 @@ void Kernel::IncreasePC()
     return;
 }
 
+// Both copy through AddrSpace::Translate, which reads in a mapped file's
+// page; NULL (or -1) if the user's address is bad.
+
 char *Kernel::User2System(int virtAddr, int limit)
 {
     int i; // index
-    int oneChar;
+    unsigned int paddr;
     char *kernelBuf = NULL;
 
     kernelBuf = new char[limit + 1]; // need for terminal string
@@ -288,10 +449,14 @@ char *Kernel::User2System(int virtAddr, int limit)
     // printf("\n Filename u2s:");
     for (i = 0; i < limit; i++)
     {
-        kernel->machine->ReadMem(virtAddr + i, 1, &oneChar);
-        kernelBuf[i] = (char)oneChar;
+        if (currentThread->space->Translate(virtAddr + i, &paddr, FALSE) != NoException)
+        {
+            delete[] kernelBuf;
+            return NULL;
+        }
+        kernelBuf[i] = machine->mainMemory[paddr];
         // printf("%c",kernelBuf[i]);
-        if (oneChar == 0)
+        if (kernelBuf[i] == 0)
             break;
     }
     return kernelBuf;
@@ -304,13 +469,14 @@ int Kernel::System2User(int virtAddr, int len, char *buffer)
     if (len == 0)
         return len;
     int i = 0;
-    int oneChar = 0;
+    unsigned int paddr;
     do
     {
-        oneChar = (int)buffer[i];
-        kernel->machine->WriteMem(virtAddr + i, 1, oneChar);
+        if (currentThread->space->Translate(virtAddr + i, &paddr, TRUE) != NoException)
+            return -1;
+        machine->mainMemory[paddr] = buffer[i];
         i++;
-    } while (i < len && oneChar != 0);
+    } while (i < len && buffer[i - 1] != 0);
     return i;
 }
 
@@ -513,6 +679,12 @@ void Kernel::File_Open()
     //  Mình muốn mở file mình sẽ thư viện hỗ trợ của hệ điều hành Linux
     //  bảng chứa file , mình tìm ra vị trí còn trống để nó có thể mở file
 
+    if (fileName == NULL) // a bad address
+    {
+        kernel->machine->WriteRegister(2, -1);
+        return;
+    }
+
     for (int i = 2; i < 20; i++) //  kiểm tra 1 file đã có đang mở hay không
     {
         if (kernel->fileSystem->ListFile[i] != NULL)
@@ -564,6 +736,12 @@ void Kernel::File_Close()
 {
     int OpenFileID = kernel->machine->ReadRegister(4);
 
+    if (OpenFileID >= FirstPipeId && OpenFileID < FirstPipeId + MaxPipeEnds) // the pipe itself may live on
+    {
+        machine->WriteRegister(2, processTable->ClosePipeEnd(OpenFileID) ? 1 : -1);
+        return;
+    }
+
     if (OpenFileID < 2 || OpenFileID > 20) // kiểm tra file có nằm trong bảng mô tả hahy không
     {
         cout << "Error. Cannot open file" << endl;
@@ -582,6 +760,8 @@ void Kernel::File_Close()
     else
     {
         // delete[] kernel->fileSystem->ListFile[OpenFileID]->fileName;
+        aio->CloseFile(kernel->fileSystem->ListFile[OpenFileID]); // let its requests finish
+        mappings->CloseFile(kernel->fileSystem->ListFile[OpenFileID]); // write back its mapped pages first
         delete kernel->fileSystem->ListFile[OpenFileID];
         cout << "\nClose file sucessfully!!!" << endl;
         kernel->fileSystem->ListFile[OpenFileID] = NULL;
@@ -638,13 +818,31 @@ void Kernel::File_Read()
 
     int virtAdr = kernel->machine->ReadRegister(4);
     int bufferSize = kernel->machine->ReadRegister(5);
-    int fileID = kernel->machine->ReadRegister(6);
+    int fileID = processTable->Redirect(kernel->machine->ReadRegister(6));
 
     int n_buf = 0;
     char *buffer;
     char c;
     int i = 0;
 
+    if (pipes->IsPipe(fileID)) // copied straight to the user's pages
+    {
+        machine->WriteRegister(2, pipes->Read(fileID, virtAdr, bufferSize));
+        return;
+    }
+
+    if (fileID >= MailBoxId(0) && fileID < MailBoxId(postOfficeIn->NumBoxes())) // the data of the next message
+    {
+        PacketHeader pktHdr;
+        MailHeader mailHdr;
+        char data[MaxMailSize];
+
+        postOfficeIn->Receive(fileID - MailBoxId(0), &pktHdr, &mailHdr, data);
+        n_buf = max(0, min(bufferSize, (int)mailHdr.length));
+        machine->WriteRegister(2, currentThread->space->Copy(virtAdr, data, n_buf, TRUE) ? n_buf : EFAULT);
+        return;
+    }
+
     // Kiem tra id cua file truyen vao co nam ngoai bang mo ta file khong ?
     if (fileID < 0 || fileID > 20)
     {
@@ -662,34 +860,37 @@ void Kernel::File_Read()
 
     if (fileID == 0) // Nếu là file stdin thì tiến hành đọc từ màn hình //kernel->fileSystem->ListFile[fileID] == 0
     {
+        buffer = new char[bufferSize + 1];
         while (i < bufferSize)
         {
             c = kernel->synchConsoleIn->GetChar();
-            if (c == '\n' || c == '\001') // finish input
-            {
-                buffer[i] = '\0';
+            if (c == '\001' || c == (char)EOF) // finish input, or end of file
                 break;
-            }
             buffer[i++] = c;
+            if (c == '\n') // the end of a line is read too, as in UNIX
+                break;
         }
         buffer[i] = '\0';
 
-        kernel->System2User(virtAdr, i, buffer);
-        machine->WriteRegister(2, i);
+        machine->WriteRegister(2, kernel->System2User(virtAdr, i, buffer) < 0 ? EFAULT : i);
 
-        delete buffer;
+        delete [] buffer;
         return;
     }
 
     buffer = kernel->User2System(virtAdr, bufferSize); // truyền địa chỉ từ user space đến kernel
+    if (buffer == NULL) // a bad address
+    {
+        machine->WriteRegister(2, EFAULT);
+        return;
+    }
     
     n_buf = kernel->fileSystem->ListFile[fileID]->Read(buffer, bufferSize); // đọc file
 
     if (n_buf > 0) // nếu đọc được file với số byte lớn hơn 0
     {
         
-        System2User(virtAdr, n_buf, buffer);
-        machine->WriteRegister(2, n_buf);
+        machine->WriteRegister(2, System2User(virtAdr, n_buf, buffer) < 0 ? EFAULT : n_buf);
     }
     else
     {
@@ -704,11 +905,17 @@ void Kernel::File_Write()
 {
     int virAddr = machine->ReadRegister(4);
     int bufferSize = machine->ReadRegister(5);
-    int fileID = machine->ReadRegister(6);
+    int fileID = processTable->Redirect(machine->ReadRegister(6));
 
     int n_buf = 0;
     int i = 0;
-    char *buffer = new char[bufferSize];
+    char *buffer;
+
+    if (pipes->IsPipe(fileID)) // copied straight from the user's pages
+    {
+        machine->WriteRegister(2, pipes->Write(fileID, virAddr, bufferSize));
+        return;
+    }
 
     // Kiem tra id cua file truyen vao co nam ngoai bang mo ta file khong
     if (fileID < 0 || fileID > 20)
@@ -736,6 +943,11 @@ void Kernel::File_Write()
 
     // truyền user space xuống kernel
     buffer = kernel->User2System(virAddr, bufferSize);
+    if (buffer == NULL) // a bad address
+    {
+        machine->WriteRegister(2, EFAULT);
+        return;
+    }
 
     n_buf = kernel->fileSystem->ListFile[fileID]->Write(buffer, bufferSize); // bắt đầu ghi vô file
 
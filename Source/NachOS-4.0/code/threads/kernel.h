@@ -18,6 +18,7 @@
 #include "alarm.h"
 #include "filesys.h"
 #include "machine.h"
+#include "synchdisk.h"
 
 #define INT_MAX 2147483647
 #define INT_MIN -2147483648
@@ -28,6 +29,16 @@ class PostOfficeOutput;
 class SynchConsoleInput;
 class SynchConsoleOutput;
 class SynchDisk;
+class Bitmap;
+class ProcessTable;
+class FutexTable;
+class PipeTable;
+class ShmTable;
+class MmapTable;
+class AioTable;
+class RingTable;
+class SyscallTrace;
+class Profiler;
 
 class Kernel
 {
@@ -46,6 +57,10 @@ public:
 
   void NetworkTest(); // interactive 2-machine network test
 
+  void Benchmark(); // microbenchmarks of performance-critical code
+
+  void DiskReplay(char *traceFile); // replay a disk trace
+
 //------------------------------------------------------------
 //
 //------------------------------------------------------------
@@ -99,9 +114,20 @@ public:
   SynchConsoleInput *synchConsoleIn;
   SynchConsoleOutput *synchConsoleOut;
   SynchDisk *synchDisk;
+  DiskTrace *diskTrace; // where to record disk requests, or NULL
   FileSystem *fileSystem;
   PostOfficeInput *postOfficeIn;
   PostOfficeOutput *postOfficeOut;
+  Bitmap *frameMap;            // physical page frames in use
+  ProcessTable *processTable;  // the user processes
+  FutexTable *futexes;         // user threads in Wait
+  PipeTable *pipes;            // the open ends of pipes
+  ShmTable *shm;               // shared memory segments
+  MmapTable *mappings;         // files mapped into memory
+  AioTable *aio;               // asynchronous reads and writes
+  RingTable *rings;            // rings of batched system calls
+  SyscallTrace *syscallTrace;  // where to record system calls, or NULL
+  Profiler *profiler;          // samples of user PCs, or NULL
 
   int hostName; // machine identifier
 
@@ -111,6 +137,16 @@ private:
   double reliability; // likelihood messages are dropped
   char *consoleIn;    // file to read console input from
   char *consoleOut;   // file to send console output to
+  DiskSchedule diskSchedule; // order to serve disk requests in
+  DiskSync diskSync;         // when disk writes reach the UNIX file
+  DiskModel diskModel;       // how the simulated disk behaves
+  DiskArray diskArray;       // striped or mirrored, if several disks
+  int numDisks;              // how many simulated disks there are
+  char *diskTraceFile;       // file to record disk requests in
+  char *syscallTraceFile;    // file to record system calls in
+  int profileTicks;          // user ticks between profile samples, or 0
+  char *foldedFile;          // file to write folded profile stacks to
+  bool countInstructions;    // count user instructions by class
 #ifndef FILESYS_STUB
   bool formatFlag; // format the disk if this is true
 #endif
@@ -6,29 +6,65 @@
 //              -s -x <nachos file> -ci <consoleIn> -co <consoleOut>
 //              -f -cp <unix file> <nachos file>
 //              -p <nachos file> -r <nachos file> -l -D
+//              -mkdir <nachos directory> -ls <nachos directory>
+//              -ds <disk schedule> -dsync <disk sync policy>
+//              -dm <disk model> -raid <level> <number of disks>
+//              -dt <disk trace file> -dr <disk trace file>
+//              -st <syscall trace file> -sp <syscall trace file>
+//              -prof <ticks> -fold <folded stacks file> -ic
 //              -n <network reliability> -m <machine id>
-//              -z -K -C -N
+//              -z -K -C -N -B
 //
 //    -d causes certain debugging messages to be printed (see debug.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
 //    -z prints the copyright message
 //    -s causes user programs to be executed in single-step mode
-//    -x runs a user program
+//    -x runs a user program; if given more than once, the programs
+//        run at the same time, and Nachos halts when they have all exited
 //    -ci specify file for console input (stdin is the default)
 //    -co specify file for console output (stdout is the default)
+//    -ds sets the order disk requests are served in: fcfs, scan or
+//        clook (the default)
+//    -dsync sets when writes to the simulated disk reach its UNIX file:
+//        none (left to the host, the default), async, or wait
+//    -dm sets how the simulated disk behaves: hdd[:spt,seek,rotation]
+//        is a rotating disk (the default), with that many sectors per
+//        track and those seek and rotation times; ssd[:read,write,channels]
+//        is a flash disk, with those read and write times and channels
+//    -raid spreads the simulated disk over several: level 0 stripes
+//        sectors across them, level 1 keeps a copy on each.  Changing
+//        this needs a freshly formatted disk (-f)
+//    -dt records every disk request in a binary trace file
+//    -dr replays a disk trace recorded with -dt, under each disk
+//        scheduling policy (see SynchDisk::Replay)
+//    -st records every system call made by a user program in a binary
+//        trace file
+//    -sp prints a syscall trace recorded with -st, and a histogram of
+//        how long each kind of call took (see SyscallTrace::Print)
+//    -prof samples the PC of the running user program every so many
+//        ticks of user time, and prints a profile of each program at
+//        halt, using the symbols in its COFF file (see profile.h)
+//    -fold also writes the profile to a file as folded stacks, for
+//        flame graph tools
+//    -ic counts the user instructions executed of each kind (ALU, load,
+//        store, branch, mult/div, syscall), and prints them at halt,
+//        with the host time taken and the simulated MIPS it works out to
 //    -n sets the network reliability
 //    -m sets this machine's host id (needed for the network)
 //    -K run a simple self test of kernel threads and synchronization
 //    -C run an interactive console test
 //    -N run a two-machine network test (see Kernel::NetworkTest)
+//    -B run performance microbenchmarks (see Kernel::Benchmark)
 //
 //    Filesystem-related flags:
 //    -f forces the Nachos disk to be formatted
 //    -cp copies a file from UNIX to Nachos
 //    -p prints a Nachos file to stdout
 //    -r removes a Nachos file from the file system
-//    -l lists the contents of the Nachos directory
+//    -l lists the contents of the Nachos root directory
 //    -D prints the contents of the entire file system
+//    -mkdir creates a Nachos directory
+//    -ls lists the contents of a Nachos directory
 //
 //  Note: the file system flags are not used if the stub filesystem
 //        is being used
@@ -45,6 +81,9 @@
 #include "filesys.h"
 #include "openfile.h"
 #include "sysdep.h"
+#include "ptable.h"
+#include "syscall.h"
+#include "systrace.h"
 
 // global variables
 Kernel *kernel;
@@ -165,16 +204,21 @@ int main(int argc, char **argv)
 {
     int i;
     char *debugArg = "";
-    char *userProgName = NULL; // default is not to execute a user prog
+    char *userProgNames[MaxProcesses]; // user programs to run
+    int numUserProgs = 0;              // default is not to execute any
     bool threadTestFlag = false;
     bool consoleTestFlag = false;
     bool networkTestFlag = false;
+    bool benchmarkFlag = false;
+    char *replayFileName = NULL; // disk trace to replay
+    char *syscallTraceName = NULL; // syscall trace to print
 #ifndef FILESYS_STUB
     char *copyUnixFileName = NULL;   // UNIX file to be copied into Nachos
     char *copyNachosFileName = NULL; // name of copied file in Nachos
     char *printFileName = NULL;
     char *removeFileName = NULL;
-    bool dirListFlag = false;
+    char *listDirName = NULL;
+    char *makeDirName = NULL;
     bool dumpFlag = false;
 #endif // FILESYS_STUB
 
@@ -195,8 +239,8 @@ int main(int argc, char **argv)
         }
         else if (strcmp(argv[i], "-x") == 0)
         {
-            ASSERT(i + 1 < argc);
-            userProgName = argv[i + 1];
+            ASSERT(i + 1 < argc && numUserProgs < MaxProcesses);
+            userProgNames[numUserProgs++] = argv[i + 1];
             i++;
         }
         else if (strcmp(argv[i], "-K") == 0)
@@ -211,6 +255,22 @@ int main(int argc, char **argv)
         {
             networkTestFlag = TRUE;
         }
+        else if (strcmp(argv[i], "-B") == 0)
+        {
+            benchmarkFlag = TRUE;
+        }
+        else if (strcmp(argv[i], "-dr") == 0)
+        {
+            ASSERT(i + 1 < argc);
+            replayFileName = argv[i + 1];
+            i++;
+        }
+        else if (strcmp(argv[i], "-sp") == 0)
+        {
+            ASSERT(i + 1 < argc);
+            syscallTraceName = argv[i + 1];
+            i++;
+        }
 #ifndef FILESYS_STUB
         else if (strcmp(argv[i], "-cp") == 0)
         {
@@ -233,7 +293,19 @@ int main(int argc, char **argv)
         }
         else if (strcmp(argv[i], "-l") == 0)
         {
-            dirListFlag = true;
+            listDirName = "/";
+        }
+        else if (strcmp(argv[i], "-ls") == 0)
+        {
+            ASSERT(i + 1 < argc);
+            listDirName = argv[i + 1];
+            i++;
+        }
+        else if (strcmp(argv[i], "-mkdir") == 0)
+        {
+            ASSERT(i + 1 < argc);
+            makeDirName = argv[i + 1];
+            i++;
         }
         else if (strcmp(argv[i], "-D") == 0)
         {
@@ -243,12 +315,15 @@ int main(int argc, char **argv)
         else if (strcmp(argv[i], "-u") == 0)
         {
             cout << "Partial usage: nachos [-z -d debugFlags]\n";
-            cout << "Partial usage: nachos [-x programName]\n";
-            cout << "Partial usage: nachos [-K] [-C] [-N]\n";
+            cout << "Partial usage: nachos [-x programName]...\n";
+            cout << "Partial usage: nachos [-K] [-C] [-N] [-B]\n";
+            cout << "Partial usage: nachos [-dr traceFile]\n";
+            cout << "Partial usage: nachos [-sp traceFile]\n";
 #ifndef FILESYS_STUB
             cout << "Partial usage: nachos [-cp UnixFile NachosFile]\n";
             cout << "Partial usage: nachos [-p fileName] [-r fileName]\n";
             cout << "Partial usage: nachos [-l] [-D]\n";
+            cout << "Partial usage: nachos [-mkdir dirName] [-ls dirName]\n";
 #endif // FILESYS_STUB
         }
     }
@@ -276,12 +351,28 @@ int main(int argc, char **argv)
     {
         kernel->NetworkTest(); // two-machine test of the network
     }
+    if (benchmarkFlag)
+    {
+        kernel->Benchmark(); // time performance-critical routines
+    }
+    if (replayFileName != NULL)
+    {
+        kernel->DiskReplay(replayFileName); // replay a disk workload
+    }
+    if (syscallTraceName != NULL)
+    {
+        SyscallTrace::Print(syscallTraceName); // decode a syscall trace
+    }
 
 #ifndef FILESYS_STUB
     if (removeFileName != NULL)
     {
         kernel->fileSystem->Remove(removeFileName);
     }
+    if (makeDirName != NULL)
+    {
+        kernel->fileSystem->CreateDirectory(makeDirName);
+    }
     if (copyUnixFileName != NULL && copyNachosFileName != NULL)
     {
         Copy(copyUnixFileName, copyNachosFileName);
@@ -290,9 +381,9 @@ int main(int argc, char **argv)
     {
         kernel->fileSystem->Print();
     }
-    if (dirListFlag)
+    if (listDirName != NULL)
     {
-        kernel->fileSystem->List();
+        kernel->fileSystem->List(listDirName);
     }
     if (printFileName != NULL)
     {
@@ -300,16 +391,18 @@ int main(int argc, char **argv)
     }
 #endif // FILESYS_STUB
 
-    // finally, run an initial user program if requested to do so
-    if (userProgName != NULL)
+    // finally, run the initial user programs if requested to do so
+    bool started = FALSE;
+    for (i = 0; i < numUserProgs; i++)
     {
-        AddrSpace *space = new AddrSpace;
-        ASSERT(space != (AddrSpace *)NULL);
-        if (space->Load(userProgName))
-        {                       // load the program into the space
-            space->Execute();   // run the program
-            ASSERTNOTREACHED(); // Execute never returns
-        }
+        if (kernel->processTable->Exec(userProgNames[i],
+                                      ConsoleInput, ConsoleOutput) >= 0)
+            started = TRUE;
+    }
+    if (started)
+    {
+        kernel->currentThread->Finish(); // the last program to exit
+        ASSERTNOTREACHED();              // halts Nachos
     }
 
     // If we don't run a user program, we may get here.
@@ -295,3 +295,210 @@ void Condition::Broadcast(Lock* conditionLock)
         Signal(conditionLock);
     }
 }
+
+//----------------------------------------------------------------------
+// WaitQueue::WaitQueue
+// 	Initialize a wait queue, with nobody waiting on it.
+//----------------------------------------------------------------------
+
+WaitQueue::WaitQueue()
+{
+    pollers = new List<Poller *>;
+}
+
+//----------------------------------------------------------------------
+// WaitQueue::~WaitQueue
+// 	De-allocate a wait queue.  Nobody should be waiting on it (see
+//	Release), unless Nachos is halting.
+//----------------------------------------------------------------------
+
+WaitQueue::~WaitQueue()
+{
+    delete pollers;
+}
+
+//----------------------------------------------------------------------
+// WaitQueue::Add, WaitQueue::Remove
+// 	Add "poller" to the queue, or take it out.  Interrupts must be
+//	off.
+//----------------------------------------------------------------------
+
+void
+WaitQueue::Add(Poller *poller)
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    pollers->Append(poller);
+}
+
+void
+WaitQueue::Remove(Poller *poller)
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    pollers->Remove(poller);
+}
+
+//----------------------------------------------------------------------
+// WaitQueue::Wake
+// 	The object may be ready now: wake every thread polling it.  They
+//	take themselves off the queue when they run.
+//----------------------------------------------------------------------
+
+void
+WaitQueue::Wake()
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    ListIterator<Poller *> iter(pollers);
+
+    for (; !iter.IsDone(); iter.Next())
+	iter.Item()->Wake();
+    (void) kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// WaitQueue::Release
+// 	The object is going away -- a pipe closed by another thread,
+//	say.  Wake anybody still waiting on it, to find that out, and
+//	let them go, so it can be deleted.
+//----------------------------------------------------------------------
+
+void
+WaitQueue::Release()
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+    while (!pollers->IsEmpty()) {
+	Poller *poller = pollers->RemoveFront();
+
+	poller->Forget(this);
+	poller->Wake();
+    }
+    (void) kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Poller::Poller
+// 	Initialize a poller for the current thread, waiting on nothing.
+//----------------------------------------------------------------------
+
+Poller::Poller()
+{
+    thread = kernel->currentThread;
+    queues = new List<WaitQueue *>;
+    asleep = FALSE;
+    timing = FALSE;
+    timedOut = FALSE;
+}
+
+//----------------------------------------------------------------------
+// Poller::Add
+// 	Wait on "queue" too.  Interrupts must be off.
+//----------------------------------------------------------------------
+
+void
+Poller::Add(WaitQueue *queue)
+{
+    queue->Add(this);
+    queues->Append(queue);
+}
+
+//----------------------------------------------------------------------
+// Poller::Forget
+// 	Don't take the poller off "queue" when it wakes up; the queue is
+//	being deleted.  Interrupts must be off.
+//----------------------------------------------------------------------
+
+void
+Poller::Forget(WaitQueue *queue)
+{
+    queues->Remove(queue);
+}
+
+//----------------------------------------------------------------------
+// Poller::Sleep
+// 	Wait until one of the queues, or the timeout, wakes the thread,
+//	then stop waiting on all of the queues.  Interrupts must be off,
+//	and must have been since the caller looked at the objects.
+//----------------------------------------------------------------------
+
+void
+Poller::Sleep()
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    ASSERT(thread == kernel->currentThread);
+
+    asleep = TRUE;
+    thread->Sleep(FALSE);
+    while (!queues->IsEmpty())
+	queues->RemoveFront()->Remove(this);
+}
+
+//----------------------------------------------------------------------
+// Poller::Wake
+// 	Put the thread on the ready list, if it is asleep; it may be
+//	woken by several queues at once.  Interrupts must be off.
+//----------------------------------------------------------------------
+
+void
+Poller::Wake()
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+
+    if (asleep) {
+	asleep = FALSE;
+	kernel->scheduler->ReadyToRun(thread);
+    }
+}
+
+//----------------------------------------------------------------------
+// Poller::SetTimeout
+// 	Wake the thread "ticks" from now, unless something else does
+//	first.
+//----------------------------------------------------------------------
+
+void
+Poller::SetTimeout(int ticks)
+{
+    ASSERT(!timing && ticks > 0);
+    timing = TRUE;
+    kernel->interrupt->Schedule(this, ticks, TimerInt);
+}
+
+//----------------------------------------------------------------------
+// Poller::CallBack
+// 	The timeout is up: wake the thread, or, if it is done waiting,
+//	finish deleting the poller.  Called from an interrupt handler.
+//----------------------------------------------------------------------
+
+void
+Poller::CallBack()
+{
+    timing = FALSE;
+    if (thread == NULL) {
+	delete this;
+	return;
+    }
+    timedOut = TRUE;
+    Wake();
+}
+
+//----------------------------------------------------------------------
+// Poller::Done
+// 	The thread is done waiting.  Delete the poller now, or, if the
+//	timeout is still pending, when it goes off -- an interrupt can't
+//	be taken back.
+//----------------------------------------------------------------------
+
+void
+Poller::Done()
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+    ASSERT(queues->IsEmpty());
+    delete queues;
+    queues = NULL;
+    if (timing)
+	thread = NULL;
+    else
+	delete this;
+    (void) kernel->interrupt->SetLevel(oldLevel);
+}
@@ -21,6 +21,7 @@
 #include "thread.h"
 #include "list.h"
 #include "main.h"
+#include "callback.h"
 
 // The following class defines a "semaphore" whose value is a non-negative
 // integer.  The semaphore has only two operations P() and V():
@@ -141,4 +142,59 @@ class Condition {
     char* name;
     List<Semaphore *> *waitQueue;	// list of waiting threads
 };
+
+class Poller;
+
+// The following class defines a "wait queue": the threads polling an
+// object -- the console, a pipe, a mailbox -- until it is ready to be
+// read or written.  The object calls Wake whenever it may have become
+// ready, and every poller is woken to look again.  Unlike a condition
+// variable, a thread can wait on several queues at once.
+//
+// Interrupts must be off to add or remove a poller, so that no Wake
+// is missed between looking at the object and going to sleep.
+
+class WaitQueue {
+  public:
+    WaitQueue();
+    ~WaitQueue();
+
+    void Add(Poller *poller);		// Wait here too
+    void Remove(Poller *poller);	// Stop waiting here
+    void Wake();			// Wake all the pollers; may be
+					// called from an interrupt handler
+    void Release();			// Wake them, and let them go; the
+					// object is going away
+
+  private:
+    List<Poller *> *pollers;		// Who is waiting here
+};
+
+// The following class defines a thread waiting on several wait queues
+// at once, and perhaps for a timeout, until any of them wakes it.
+
+class Poller : public CallBackObj {
+  public:
+    Poller();				// For the current thread
+
+    void Add(WaitQueue *queue);		// Wait on it, at the next Sleep
+    void Forget(WaitQueue *queue);	// It is going away (see Release)
+    void Sleep();			// Wait; interrupts must be off
+    void Wake();			// Put the thread back on the ready
+					// list, unless it is already
+    void SetTimeout(int ticks);		// Wake it after "ticks", too
+    bool TimedOut() { return timedOut; }
+    void Done();			// Delete it, once the timeout, if
+					// any, is not pending
+
+    void CallBack();			// The timeout is up
+
+  private:
+    Thread *thread;			// Who is waiting; NULL once Done
+    List<WaitQueue *> *queues;		// What on
+    bool asleep;			// Is it in Sleep?
+    bool timing;			// Is the timeout pending,
+    bool timedOut;			// or has it gone off?
+};
+
 #endif // SYNCH_H
@@ -32,6 +32,10 @@ class SynchList {
     T RemoveFront();		// remove the first item from the front of
 				// the list, waiting if the list is empty
 
+    bool IsEmpty() { return list->IsEmpty(); }
+				// is the list empty?  (only a hint,
+				// unless interrupts are off)
+
     void Apply(void (*f)(T)); // apply function to all elements in list
 
     void SelfTest(T value);	// test the SynchList implementation
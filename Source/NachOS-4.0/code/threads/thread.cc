@@ -45,6 +45,8 @@ Thread::Thread(char* threadName)
 					// of machine registers
     }
     space = NULL;
+    processId = -1;
+    threadId = -1;
 }
 
 //----------------------------------------------------------------------
@@ -129,6 +129,9 @@ class Thread {
     void RestoreUserState();		// restore user-level register state
 
     AddrSpace *space;			// User code this thread is running.
+    int processId;			// Process it belongs to, or -1
+					// (see ptable.h)
+    int threadId;			// Which of the process's threads
 };
 
 // external function, dummy routine whose sole job is to call Thread::Print
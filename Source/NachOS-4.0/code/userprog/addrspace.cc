@@ -20,6 +20,8 @@
 #include "addrspace.h"
 #include "machine.h"
 #include "noff.h"
+#include "bitmap.h"
+#include "mmap.h"
 
 //----------------------------------------------------------------------
 // SwapHeader
@@ -60,35 +62,37 @@ SwapHeader (NoffHeader *noffH)
 //----------------------------------------------------------------------
 // AddrSpace::AddrSpace
 // 	Create an address space to run a user program.
-//	Set up the translation from program memory to physical 
-//	memory.  For now, this is really simple (1:1), since we are
-//	only uniprogramming, and we have a single unsegmented page table
+//	It is empty until a program is loaded into it; then it is given
+//	as many physical page frames as the program needs, wherever
+//	they are free, so several programs can be in memory at once.
 //----------------------------------------------------------------------
 
 AddrSpace::AddrSpace()
 {
-    pageTable = new TranslationEntry[NumPhysPages];
-    for (int i = 0; i < NumPhysPages; i++) {
-	pageTable[i].virtualPage = i;	// for now, virt page # = phys page #
-	pageTable[i].physicalPage = i;
-	pageTable[i].valid = TRUE;
-	pageTable[i].use = FALSE;
-	pageTable[i].dirty = FALSE;
-	pageTable[i].readOnly = FALSE;  
-    }
-    
-    // zero out the entire address space
-    bzero(kernel->machine->mainMemory, MemorySize);
+    pageTable = NULL;
+    numPages = 0;
+    freeStacks = new List<int>;
+    reserved = new Bitmap(MaxVirtualPages);
+    exiting = FALSE;
 }
 
 //----------------------------------------------------------------------
 // AddrSpace::~AddrSpace
-// 	Dealloate an address space.
+// 	Dealloate an address space, giving its page frames back.  Frames
+//	that were mapped into it must have been unmapped by now.
 //----------------------------------------------------------------------
 
 AddrSpace::~AddrSpace()
 {
-   delete pageTable;
+    for (unsigned int i = 0; i < numPages; i++) {
+	if (pageTable[i].valid)
+	    kernel->frameMap->Clear(pageTable[i].physicalPage);
+    }
+    delete [] pageTable;
+    while (!freeStacks->IsEmpty())
+	(void) freeStacks->RemoveFront();
+    delete freeStacks;
+    delete reserved;
 }
 
 
@@ -96,8 +100,9 @@ AddrSpace::~AddrSpace()
 // AddrSpace::Load
 // 	Load a user program into memory from a file.
 //
-//	Assumes that the page table has been initialized, and that
-//	the object code file is in NOFF format.
+//	Gives the address space its page frames, and fills them in.
+//	Returns FALSE, having given it none, if the object code file
+//	isn't in NOFF format or there isn't enough free memory for it.
 //
 //	"fileName" is the file containing the object code to load into memory
 //----------------------------------------------------------------------
@@ -118,44 +123,58 @@ AddrSpace::Load(char *fileName)
     if ((noffH.noffMagic != NOFFMAGIC) && 
 		(WordToHost(noffH.noffMagic) == NOFFMAGIC))
     	SwapHeader(&noffH);
-    ASSERT(noffH.noffMagic == NOFFMAGIC);
+    if (noffH.noffMagic != NOFFMAGIC) {
+	cerr << fileName << " is not a Nachos executable\n";
+	delete executable;
+	return FALSE;
+    }
 
 #ifdef RDATA
 // how big is address space?
     size = noffH.code.size + noffH.readonlyData.size + noffH.initData.size +
-           noffH.uninitData.size + UserStackSize;	
-                                                // we need to increase the size
-						// to leave room for the stack
+           noffH.uninitData.size;	// the stacks are added after it,
+					// one for each thread
 #else
 // how big is address space?
-    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size 
-			+ UserStackSize;	// we need to increase the size
-						// to leave room for the stack
+    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size;
 #endif
     numPages = divRoundUp(size, PageSize);
     size = numPages * PageSize;
 
-    ASSERT(numPages <= NumPhysPages);		// check we're not trying
-						// to run anything too big --
-						// at least until we have
-						// virtual memory
+    if (numPages + divRoundUp(UserStackSize, PageSize)
+		> (unsigned int) kernel->frameMap->NumClear()) {
+	cerr << "Not enough memory to run " << fileName << "\n";
+	numPages = 0;			// so the destructor frees nothing
+	delete executable;
+	return FALSE;
+    }
 
     DEBUG(dbgAddr, "Initializing address space: " << numPages << ", " << size);
 
+// find page frames for it, and zero them out
+    pageTable = new TranslationEntry[numPages];
+    for (unsigned int i = 0; i < numPages; i++) {
+	pageTable[i].virtualPage = i;
+	pageTable[i].physicalPage = kernel->frameMap->FindAndSet();
+	pageTable[i].valid = TRUE;
+	pageTable[i].use = FALSE;
+	pageTable[i].dirty = FALSE;
+	pageTable[i].readOnly = FALSE;
+	bzero(&(kernel->machine->mainMemory[pageTable[i].physicalPage
+						* PageSize]), PageSize);
+    }
+
 // then, copy in the code and data segments into memory
-// Note: this code assumes that virtual address = physical address
     if (noffH.code.size > 0) {
         DEBUG(dbgAddr, "Initializing code segment.");
 	DEBUG(dbgAddr, noffH.code.virtualAddr << ", " << noffH.code.size);
-        executable->ReadAt(
-		&(kernel->machine->mainMemory[noffH.code.virtualAddr]), 
-			noffH.code.size, noffH.code.inFileAddr);
+	LoadSegment(executable, noffH.code.virtualAddr, noffH.code.size,
+			noffH.code.inFileAddr);
     }
     if (noffH.initData.size > 0) {
         DEBUG(dbgAddr, "Initializing data segment.");
 	DEBUG(dbgAddr, noffH.initData.virtualAddr << ", " << noffH.initData.size);
-        executable->ReadAt(
-		&(kernel->machine->mainMemory[noffH.initData.virtualAddr]),
+	LoadSegment(executable, noffH.initData.virtualAddr,
 			noffH.initData.size, noffH.initData.inFileAddr);
     }
 
@@ -163,8 +182,7 @@ AddrSpace::Load(char *fileName)
     if (noffH.readonlyData.size > 0) {
         DEBUG(dbgAddr, "Initializing read only data segment.");
 	DEBUG(dbgAddr, noffH.readonlyData.virtualAddr << ", " << noffH.readonlyData.size);
-        executable->ReadAt(
-		&(kernel->machine->mainMemory[noffH.readonlyData.virtualAddr]),
+	LoadSegment(executable, noffH.readonlyData.virtualAddr,
 			noffH.readonlyData.size, noffH.readonlyData.inFileAddr);
     }
 #endif
@@ -173,6 +191,279 @@ AddrSpace::Load(char *fileName)
     return TRUE;			// success
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::LoadSegment
+// 	Copy a segment of a program from its object code file into the
+//	page frames that back it.  The segment is read with a single
+//	request, however many pages it is spread over.
+//
+//	"executable" is the object code file.
+//	"virtualAddr" is where the segment goes in the address space.
+//	"size" is how many bytes long it is.
+//	"inFileAddr" is where it is in the file.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::LoadSegment(OpenFile *executable, int virtualAddr, int size,
+		       int inFileAddr)
+{
+    char *buffer = new char[size];
+    int done, vaddr, offset, count;
+
+    executable->ReadAt(buffer, size, inFileAddr);
+    for (done = 0; done < size; done += count) {
+	vaddr = virtualAddr + done;
+	offset = vaddr % PageSize;
+	count = min(PageSize - offset, size - done);
+	ASSERT((unsigned int) vaddr / PageSize < numPages);
+	bcopy(buffer + done, &(kernel->machine->mainMemory[
+		pageTable[vaddr / PageSize].physicalPage * PageSize + offset]),
+	      count);
+    }
+    delete [] buffer;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::AllocateStack
+// 	Find a stack for a new thread in this address space.  A stack
+//	given back by a thread that has finished is used again; otherwise
+//	the address space is grown by UserStackSize, with new page frames.
+//
+//	Returns the initial stack pointer, or -1 if there isn't enough
+//	free memory.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::AllocateStack()
+{
+    int stackPages = divRoundUp(UserStackSize, PageSize);
+    unsigned int i;
+
+    if (!freeStacks->IsEmpty())
+	return freeStacks->RemoveFront();
+    if (stackPages > kernel->frameMap->NumClear())
+	return -1;
+
+    i = numPages;
+    if (!Grow(numPages + stackPages))
+	return -1;
+    for (; i < numPages; i++) {
+	pageTable[i].physicalPage = kernel->frameMap->FindAndSet();
+	pageTable[i].valid = TRUE;
+	bzero(&(kernel->machine->mainMemory[pageTable[i].physicalPage
+						* PageSize]), PageSize);
+    }
+
+   // Start the stack pointer at the end of the stack, but subtract off a
+   // bit, to make sure we don't accidentally reference off the end!
+    DEBUG(dbgAddr, "New stack, pointer at " << numPages * PageSize - 16);
+    return numPages * PageSize - 16;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::FreeStack
+// 	A thread has finished with its stack; keep it for the next one.
+//
+//	"stackTop" is what AllocateStack returned for it.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::FreeStack(int stackTop)
+{
+    freeStacks->Append(stackTop);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Grow
+// 	Make the page table "pages" entries long, copying the old one.
+//	The new entries are not valid; it is up to the caller to give
+//	them frames.  Return FALSE if "pages" is more than the address
+//	space may have.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::Grow(unsigned int pages)
+{
+    TranslationEntry *table;
+    unsigned int i;
+
+    if (pages > MaxVirtualPages)
+	return FALSE;
+    if (pages <= numPages)
+	return TRUE;
+
+    table = new TranslationEntry[pages];
+    for (i = 0; i < numPages; i++)
+	table[i] = pageTable[i];
+    for (; i < pages; i++) {
+	table[i].virtualPage = i;
+	table[i].physicalPage = -1;
+	table[i].valid = FALSE;
+	table[i].use = FALSE;
+	table[i].dirty = FALSE;
+	table[i].readOnly = FALSE;
+    }
+    delete [] pageTable;
+    pageTable = table;
+    numPages = pages;
+    if (kernel->currentThread->space == this)
+	RestoreState();			// the machine has the old table
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Map
+// 	Make the pages from "vaddr" on refer to page frames that belong
+//	to somebody else (shared memory), growing the address space if
+//	need be.  The frames are not given back when the address space
+//	is deleted; they have to be unmapped first.
+//
+//	Return FALSE, changing nothing, if "vaddr" is not on a page
+//	boundary, or any of the pages is already in use.  Pages that
+//	Reserve set aside count as in use, except to whoever reserved
+//	them (a mapped file, or a ring).
+//
+//	"frames" are the page frames, "count" of them.
+//	"isReserved" -- are the pages ones Reserve set aside?
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::Map(int vaddr, int *frames, int count, bool isReserved)
+{
+    unsigned int first = vaddr / PageSize;
+    unsigned int i;
+
+    if (vaddr < 0 || vaddr % PageSize != 0 || count <= 0
+		|| first + count > MaxVirtualPages)
+	return FALSE;
+    for (i = first; i < first + count; i++) {
+	if ((i < numPages && pageTable[i].valid)
+		|| reserved->Test(i) != isReserved)
+	    return FALSE;
+    }
+    if (!Grow(max(numPages, first + count)))
+	return FALSE;
+
+    for (i = 0; i < (unsigned int) count; i++) {
+	pageTable[first + i].physicalPage = frames[i];
+	pageTable[first + i].valid = TRUE;
+	pageTable[first + i].use = FALSE;
+	pageTable[first + i].dirty = FALSE;
+	pageTable[first + i].readOnly = FALSE;
+    }
+    DEBUG(dbgAddr, "Mapped " << count << " frames at " << vaddr);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Unmap
+// 	Forget the pages Map put at "vaddr", leaving a hole.  The page
+//	frames are not given back: they belong to somebody else.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::Unmap(int vaddr, int count)
+{
+    unsigned int first = vaddr / PageSize;
+
+    ASSERT(first + count <= numPages);
+    for (unsigned int i = first; i < first + count; i++) {
+	pageTable[i].valid = FALSE;
+	pageTable[i].physicalPage = -1;
+    }
+    DEBUG(dbgAddr, "Unmapped " << count << " frames at " << vaddr);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Reserve
+// 	Set aside "count" pages in a row, with no frames yet, for a
+//	mapped file or a system call ring: the first that are neither
+//	valid nor set aside already -- a hole left by Release or Unmap --
+//	or else pages past the end of the address space.  Return the
+//	address of the first, or -1 if the address space can't grow that
+//	much.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::Reserve(int count)
+{
+    unsigned int first = 0, i;
+
+    if (count <= 0)
+	return -1;
+    for (i = 0; i < numPages && i < first + count; i++) {
+	if (pageTable[i].valid || reserved->Test(i))
+	    first = i + 1;		// the run starts after this one
+    }
+    if (!Grow(max(numPages, first + count)))
+	return -1;
+    for (i = first; i < first + count; i++)
+	reserved->Mark(i);
+    return first * PageSize;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Release
+// 	Give back the pages from "vaddr" on that Reserve set aside, so
+//	they can be used again.  They must not be mapped any more.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::Release(int vaddr, int count)
+{
+    unsigned int first = vaddr / PageSize;
+
+    ASSERT(first + count <= numPages);
+    for (unsigned int i = first; i < first + count; i++) {
+	ASSERT(!pageTable[i].valid && reserved->Test(i));
+	reserved->Clear(i);
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::IsDirty
+// 	Return TRUE if the page "vaddr" is on has been written since it
+//	was mapped.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::IsDirty(int vaddr)
+{
+    unsigned int vpn = vaddr / PageSize;
+
+    ASSERT(vpn < numPages);
+    return pageTable[vpn].valid && pageTable[vpn].dirty;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Copy
+// 	Copy "size" bytes between "buffer" and this address space at
+//	"vaddr", a page at a time.  Unlike User2System, it copies every
+//	byte, zeroes too.  Return FALSE if some of the memory is not
+//	there (or, to write it, read-only).
+//
+//	"toUser" -- are we copying into the address space?
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::Copy(int vaddr, char *buffer, int size, bool toUser)
+{
+    unsigned int paddr;
+    int done = 0, n;
+
+    while (done < size) {
+	if (Translate(vaddr + done, &paddr, toUser) != NoException)
+	    return FALSE;
+	n = min(size - done, PageSize - (vaddr + done) % PageSize);
+	if (toUser)
+	    bcopy(buffer + done, &kernel->machine->mainMemory[paddr], n);
+	else
+	    bcopy(&kernel->machine->mainMemory[paddr], buffer + done, n);
+	done += n;
+    }
+    return TRUE;
+}
+
 //----------------------------------------------------------------------
 // AddrSpace::Execute
 // 	Run a user program using the current thread
@@ -180,15 +471,19 @@ AddrSpace::Load(char *fileName)
 //      The program is assumed to have already been loaded into
 //      the address space
 //
+//	"startPC" is where to start: 0 for the program itself, or the
+//	function a new thread is to run.
+//	"stackTop" is the stack pointer, from AllocateStack.
+//	"arg" is passed to the function.
 //----------------------------------------------------------------------
 
 void 
-AddrSpace::Execute() 
+AddrSpace::Execute(int startPC, int stackTop, int arg) 
 {
 
     kernel->currentThread->space = this;
 
-    this->InitRegisters();		// set the initial register values
+    this->InitRegisters(startPC, stackTop, arg); // set the initial register values
     this->RestoreState();		// load page table register
 
     kernel->machine->Run();		// jump to the user progam
@@ -207,10 +502,12 @@ AddrSpace::Execute()
 //	that we can immediately jump to user code.  Note that these
 //	will be saved/restored into the currentThread->userRegisters
 //	when this thread is context switched out.
+//
+//	"startPC", "stackTop" and "arg" are as for Execute.
 //----------------------------------------------------------------------
 
 void
-AddrSpace::InitRegisters()
+AddrSpace::InitRegisters(int startPC, int stackTop, int arg)
 {
     Machine *machine = kernel->machine;
     int i;
@@ -218,21 +515,23 @@ AddrSpace::InitRegisters()
     for (i = 0; i < NumTotalRegs; i++)
 	machine->WriteRegister(i, 0);
 
-    // Initial program counter -- must be location of "Start", which
-    //  is assumed to be virtual address zero
-    machine->WriteRegister(PCReg, 0);	
+    // Initial program counter -- for the program, must be location of
+    //  "Start", which is assumed to be virtual address zero
+    machine->WriteRegister(PCReg, startPC);	
 
     // Need to also tell MIPS where next instruction is, because
     // of branch delay possibility
     // Since instructions occupy four bytes each, the next instruction
     // after start will be at virtual address four.
-    machine->WriteRegister(NextPCReg, 4);
+    machine->WriteRegister(NextPCReg, startPC + 4);
 
-   // Set the stack register to the end of the address space, where we
-   // allocated the stack; but subtract off a bit, to make sure we don't
-   // accidentally reference off the end!
-    machine->WriteRegister(StackReg, numPages * PageSize - 16);
-    DEBUG(dbgAddr, "Initializing stack pointer: " << numPages * PageSize - 16);
+    // The function's argument, and where it returns to: if the function
+    // a thread runs returns, that ends the thread
+    machine->WriteRegister(4, arg);
+    machine->WriteRegister(RetAddrReg, UserThreadReturn);
+
+    machine->WriteRegister(StackReg, stackTop);
+    DEBUG(dbgAddr, "Initializing stack pointer: " << stackTop);
 }
 
 //----------------------------------------------------------------------
@@ -251,13 +550,16 @@ void AddrSpace::SaveState()
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//      For now, tell the machine where to find the page table, and
+//	break any LL the thread did before it was switched out: some
+//	other thread may have changed the word since.
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState() 
 {
     kernel->machine->pageTable = pageTable;
     kernel->machine->pageTableSize = numPages;
+    kernel->machine->ClearLink();
 }
 
 
@@ -267,6 +569,7 @@ void AddrSpace::RestoreState()
 //  and store the physical address in _paddr_.
 //  The flag _isReadWrite_ is false (0) for read-only access; true (1)
 //  for read-write access.
+//  A page of a mapped file that is not in memory is read in first.
 //  Return any exceptions caused by the address translation.
 //----------------------------------------------------------------------
 ExceptionType
@@ -283,6 +586,10 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
 
     pte = &pageTable[vpn];
 
+    if(!pte->valid && !kernel->mappings->PageIn(this, vaddr)) {
+        return PageFaultException;		// not a mapped file's page
+    }
+
     if(isReadWrite && pte->readOnly) {
         return ReadOnlyException;
     }
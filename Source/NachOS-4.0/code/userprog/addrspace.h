@@ -2,9 +2,10 @@
 //	Data structures to keep track of executing user programs 
 //	(address spaces).
 //
-//	For now, we don't keep any information about address spaces.
-//	The user level CPU state is saved and restored in the thread
-//	executing the user program (see thread.h).
+//	An address space is a page table, mapping the program's pages
+//	onto physical page frames; the frames in use are kept track of
+//	in kernel->frameMap.  The user level CPU state is saved and
+//	restored in the thread executing the user program (see thread.h).
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -15,8 +16,21 @@
 
 #include "copyright.h"
 #include "filesys.h"
+#include "list.h"
+
+class Bitmap;
 
 #define UserStackSize		1024 	// increase this as necessary!
+					// (each thread gets one)
+
+#define MaxVirtualPages		1024	// how far an address space can grow,
+					// with stacks and shared memory
+
+#define UserThreadReturn	0xfffffff0
+					// Where the function a thread runs
+					// returns to; there is nothing there,
+					// and fetching from it ends the thread
+					// (see exception.cc)
 
 class AddrSpace {
   public:
@@ -27,10 +41,33 @@ class AddrSpace {
                                         // a file
 					// return false if not found
 
-    void Execute();             	// Run a program
+    void Execute(int startPC, int stackTop, int arg = 0);
+					// Run a program, or a thread of it,
+					// starting at "startPC"
 					// assumes the program has already
                                         // been loaded
 
+    int AllocateStack();		// Make room for a thread's stack;
+					// return its stack pointer, or -1
+    void FreeStack(int stackTop);	// The thread is done with it
+
+    bool Map(int vaddr, int *frames, int count, bool isReserved = FALSE);
+					// Put "count" page frames, that belong
+					// to somebody else, at "vaddr"; FALSE
+					// if any of the pages is in use, or
+					// (unless "isReserved") is reserved
+    void Unmap(int vaddr, int count);	// Take them out again
+    int Reserve(int count);		// Set aside "count" unused pages,
+					// not valid yet, for a mapped file
+					// or a ring; return where, or -1
+					// if there is no room
+    void Release(int vaddr, int count);	// They can be used again
+    bool IsDirty(int vaddr);		// Has the page been written since
+					// it was mapped?
+    bool Copy(int vaddr, char *buffer, int size, bool toUser);
+					// Copy to or from its memory; FALSE
+					// if some of it isn't there
+
     void SaveState();			// Save/restore address space-specific
     void RestoreState();		// info on a context switch 
 
@@ -39,15 +76,30 @@ class AddrSpace {
     // is 0 for Read, 1 for Write.
     ExceptionType Translate(unsigned int vaddr, unsigned int *paddr, int mode);
 
+    bool exiting;			// Has one of the threads called Exit?
+					// If so, the others stop before
+					// their next instruction
+
   private:
     TranslationEntry *pageTable;	// Assume linear page table translation
 					// for now!
     unsigned int numPages;		// Number of pages in the virtual 
 					// address space
 
-    void InitRegisters();		// Initialize user-level CPU registers,
+    List<int> *freeStacks;		// Stacks no thread is using
+    Bitmap *reserved;			// Pages Reserve has set aside
+
+    bool Grow(unsigned int pages);	// Make the page table "pages" long;
+					// the new pages are not valid
+
+    void InitRegisters(int startPC, int stackTop, int arg);
+					// Initialize user-level CPU registers,
 					// before jumping to user code
 
+    void LoadSegment(OpenFile *executable, int virtualAddr, int size,
+		     int inFileAddr);	// Copy a segment of the program
+					// into its page frames
+
 };
 
 #endif // ADDRSPACE_H
@@ -0,0 +1,304 @@
+// aio.cc
+//	Routines to queue asynchronous reads and writes, and the kernel
+//	thread that does them.
+//
+//	The table is a monitor: the lock is held while the requests are
+//	looked at or changed, but not while the worker waits for the
+//	file system, so programs can make and wait for requests then.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "main.h"
+#include "aio.h"
+#include "addrspace.h"
+#include "synch.h"
+#include "syscall.h"
+
+//----------------------------------------------------------------------
+// IORequest::IORequest
+// 	Initialize a request, with room in the kernel for its bytes.
+//----------------------------------------------------------------------
+
+IORequest::IORequest(int id, AddrSpace *s, OpenFile *f, bool write, int pos,
+		     int addr, int count, int status)
+{
+    handle = id;
+    space = s;
+    file = f;
+    writing = write;
+    position = pos;
+    vaddr = addr;
+    size = count;
+    statusAddr = status;
+    buffer = new char[count];
+    result = 0;
+    done = FALSE;
+}
+
+IORequest::~IORequest()
+{
+    delete [] buffer;
+}
+
+//----------------------------------------------------------------------
+// IOWorker
+// 	The procedure the I/O worker thread runs.
+//----------------------------------------------------------------------
+
+static void
+IOWorker(AioTable *table)
+{
+    table->Work();
+}
+
+//----------------------------------------------------------------------
+// AioTable::AioTable
+// 	Initialize the table; there are no requests.  The worker is not
+//	started until there is one, so programs that don't use it don't
+//	have another thread to schedule.
+//----------------------------------------------------------------------
+
+AioTable::AioTable()
+{
+    for (int i = 0; i < MaxIORequests; i++)
+	requests[i] = NULL;
+    queue = new List<IORequest *>;
+    current = NULL;
+    worker = NULL;
+    lock = new Lock("aio");
+    queued = new Condition("aio queued");
+    finished = new Condition("aio finished");
+}
+
+//----------------------------------------------------------------------
+// AioTable::~AioTable
+// 	Nachos is halting; throw away the requests that are left.
+//----------------------------------------------------------------------
+
+AioTable::~AioTable()
+{
+    for (int i = 0; i < MaxIORequests; i++)
+	delete requests[i];
+    delete queue;
+    delete lock;
+    delete queued;
+    delete finished;
+}
+
+//----------------------------------------------------------------------
+// AioTable::Free
+// 	Forget about a request.  The lock must be held.
+//----------------------------------------------------------------------
+
+void
+AioTable::Free(IORequest *request)
+{
+    requests[request->handle] = NULL;
+    delete request;
+}
+
+//----------------------------------------------------------------------
+// AioTable::Submit
+// 	Queue a read or write of "size" bytes of "file", at its current
+//	position, for the current program, and move the position on.
+//	The bytes to write are copied now.  If "statusAddr" is not 0,
+//	the word there is set to EBUSY, until the request is done.
+//
+//	Return the handle of the request, or EINVAL if "size" is
+//	negative or more than an address space can hold (the kernel
+//	buffers the whole request), EFAULT for a bad address, or EAGAIN if there are
+//	too many requests already.
+//----------------------------------------------------------------------
+
+int
+AioTable::Submit(OpenFile *file, bool writing, int vaddr, int size,
+		 int statusAddr)
+{
+    AddrSpace *space = kernel->currentThread->space;
+    int busy = WordToMachine((unsigned int) EBUSY);
+    IORequest *request;
+    int handle, position;
+
+    if (size < 0 || size > MaxVirtualPages * PageSize)
+	return EINVAL;
+    if ((statusAddr & 0x3) != 0)
+	return EFAULT;
+
+    lock->Acquire();
+    for (handle = 0; handle < MaxIORequests; handle++) {
+	if (requests[handle] == NULL)
+	    break;
+    }
+    if (handle == MaxIORequests) {
+	lock->Release();
+	return EAGAIN;
+    }
+
+    position = file->GetCurrentPos();
+    request = new IORequest(handle, space, file, writing, position,
+			    vaddr, size, statusAddr);
+    if ((writing && !space->Copy(vaddr, request->buffer, size, FALSE))
+		|| (statusAddr != 0
+		    && !space->Copy(statusAddr, (char *) &busy, 4, TRUE))) {
+	delete request;
+	lock->Release();
+	return EFAULT;
+    }
+    file->Seek(position + size);
+
+    requests[handle] = request;
+    queue->Append(request);
+    queued->Signal(lock);
+    if (worker == NULL) {
+	worker = new Thread("I/O worker");
+	worker->Fork((VoidFunctionPtr) IOWorker, (void *) this);
+    }
+    lock->Release();
+
+    DEBUG(dbgSys, "Async " << (writing ? "write " : "read ") << handle
+		    << ": " << size << " bytes at " << position);
+    return handle;
+}
+
+//----------------------------------------------------------------------
+// AioTable::Work
+// 	Do the requests in the order they were made, waiting for more
+//	when there are none.  Each is done without the lock, since the
+//	file system may put the worker to sleep.  The result goes in
+//	the program's status word; if the program has gone away in the
+//	meantime, nobody will wait for the request, so it is freed here.
+//----------------------------------------------------------------------
+
+void
+AioTable::Work()
+{
+    IORequest *request;
+    int word;
+
+    for (;;) {
+	lock->Acquire();
+	while (queue->IsEmpty())
+	    queued->Wait(lock);
+	request = queue->RemoveFront();
+	current = request;
+	lock->Release();
+
+	if (request->writing)
+	    request->result = request->file->WriteAt(request->buffer,
+				request->size, request->position);
+	else
+	    request->result = request->file->ReadAt(request->buffer,
+				request->size, request->position);
+
+	lock->Acquire();
+	current = NULL;
+	if (request->space == NULL) {
+	    Free(request);
+	    finished->Broadcast(lock);	// CloseFile may be waiting for it
+	    lock->Release();
+	    continue;
+	}
+	if (!request->writing && request->result > 0
+		&& !request->space->Copy(request->vaddr, request->buffer,
+					 request->result, TRUE))
+	    request->result = EFAULT;
+	if (request->statusAddr != 0) {
+	    word = WordToMachine((unsigned int) request->result);
+	    (void) request->space->Copy(request->statusAddr, (char *) &word,
+					4, TRUE);
+	}
+	DEBUG(dbgSys, "Async request " << request->handle << " done: "
+			<< request->result);
+	request->done = TRUE;
+	finished->Broadcast(lock);
+	lock->Release();
+    }
+}
+
+//----------------------------------------------------------------------
+// AioTable::Wait
+// 	Wait for the current program's request "handle" to be done,
+//	unless it is already, and free it.  Return its result: the
+//	number of bytes read or written, or a negative error code; or
+//	EBADF if "handle" is not one of the program's requests.
+//----------------------------------------------------------------------
+
+int
+AioTable::Wait(int handle)
+{
+    IORequest *request;
+    int result;
+
+    lock->Acquire();
+    if (handle < 0 || handle >= MaxIORequests || requests[handle] == NULL
+		|| requests[handle]->space != kernel->currentThread->space) {
+	lock->Release();
+	return EBADF;
+    }
+
+    request = requests[handle];
+    while (requests[handle] == request && !request->done)
+	finished->Wait(lock);
+    if (requests[handle] != request) {	// another thread waited for it
+	lock->Release();
+	return EBADF;
+    }
+    result = request->result;
+    Free(request);
+    lock->Release();
+    return result;
+}
+
+//----------------------------------------------------------------------
+// AioTable::CloseFile
+// 	Wait until no request that is not done uses "file", which is
+//	about to be closed.
+//----------------------------------------------------------------------
+
+void
+AioTable::CloseFile(OpenFile *file)
+{
+    bool busy = TRUE;
+
+    lock->Acquire();
+    while (busy) {
+	busy = FALSE;
+	for (int i = 0; i < MaxIORequests; i++) {
+	    if (requests[i] != NULL && requests[i]->file == file
+			&& !requests[i]->done)
+		busy = TRUE;
+	}
+	if (busy)
+	    finished->Wait(lock);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// AioTable::Forget
+// 	Drop the requests of "space", which is about to be deleted.  The
+//	one the worker is doing, if any, is left for it to free.
+//----------------------------------------------------------------------
+
+void
+AioTable::Forget(AddrSpace *space)
+{
+    lock->Acquire();
+    for (int i = 0; i < MaxIORequests; i++) {
+	IORequest *request = requests[i];
+
+	if (request == NULL || request->space != space)
+	    continue;
+	if (request == current) {
+	    request->space = NULL;
+	} else {
+	    if (!request->done)
+		queue->Remove(request);
+	    Free(request);
+	}
+    }
+    lock->Release();
+}
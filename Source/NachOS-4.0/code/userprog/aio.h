@@ -0,0 +1,93 @@
+// aio.h
+//	Data structures for asynchronous I/O: reads and writes of open
+//	files that a user program starts, and goes on computing while
+//	they are done, instead of waiting for the disk.
+//
+//	AsyncRead and AsyncWrite queue a request, and return a handle
+//	for it right away.  A kernel thread, the I/O worker, does the
+//	requests one at a time, in order; it is the one that waits for
+//	the disk.  When a request is done, its result -- what Read or
+//	Write would have returned -- is put in the program's status
+//	word, which holds EBUSY until then.  WaitIO(handle) waits for
+//	the request, unless it is done already, and frees the handle.
+//
+//	A request uses the file position when it is made, and moves it
+//	on as if all of it will be done, so that several requests in a
+//	row read (or write) one piece of the file after another.  The
+//	bytes of a write are copied out of the program when the request
+//	is made; those of a read are copied in when it is done.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef AIO_H
+#define AIO_H
+
+#include "copyright.h"
+#include "list.h"
+
+class AddrSpace;
+class OpenFile;
+class Thread;
+class Lock;
+class Condition;
+
+#define MaxIORequests	16		// requests not yet waited for
+
+// A read or a write, from the time it is made to the WaitIO for it.
+
+class IORequest {
+  public:
+    IORequest(int id, AddrSpace *s, OpenFile *f, bool write, int pos,
+	      int addr, int count, int status);
+    ~IORequest();
+
+    int handle;				// What the program calls it
+    AddrSpace *space;			// Whose it is; NULL once the
+					// program has gone away
+    OpenFile *file;
+    bool writing;			// A write, or a read?
+    int position;			// Where in the file,
+    int vaddr;				// and where in the program's
+    int size;				// memory, and how many bytes
+    int statusAddr;			// The status word, or 0 if none
+    char *buffer;			// The bytes, in the kernel
+    int result;				// Bytes read or written, or -1
+    bool done;
+};
+
+// The following class defines the requests, and the worker that
+// does them.
+
+class AioTable {
+  public:
+    AioTable();
+    ~AioTable();
+
+    int Submit(OpenFile *file, bool writing, int vaddr, int size,
+	       int statusAddr);		// Queue a request from the current
+					// program; return its handle, or a
+					// negative error code
+    int Wait(int handle);		// Wait for it to be done, and free
+					// it; return its result, or EBADF
+    void CloseFile(OpenFile *file);	// Wait until no request uses it
+    void Forget(AddrSpace *space);	// It is going away; drop its
+					// requests
+
+    void Work();			// The I/O worker: do the requests,
+					// forever
+
+  private:
+    void Free(IORequest *request);	// Throw away a request
+
+    IORequest *requests[MaxIORequests];	// By handle, or NULL
+    List<IORequest *> *queue;		// The ones to do, in order
+    IORequest *current;			// The one being done, or NULL
+    Thread *worker;			// Started at the first request
+    Lock *lock;				// Held while using the above
+    Condition *queued;			// Signalled when one is queued,
+    Condition *finished;		// and when one is done
+};
+
+#endif // AIO_H
@@ -25,6 +25,7 @@
 #include "main.h"
 #include "syscall.h"
 #include "ksyscall.h"
+#include "systrace.h"
 
 //----
 #define MaxFileLength 33 // Max filename length: 32 + null terminator
@@ -84,6 +85,9 @@ void ExceptionHandler(ExceptionType which)
 		return;
 	case PageFaultException: // No valid translation found
 	{
+		if (kernel->mappings->PageIn(kernel->currentThread->space, kernel->machine->ReadRegister(BadVAddrReg)))
+			return; // a page of a mapped file, read in: the instruction is tried again
+
 		DEBUG(dbgAddr, "No valid translation found\n"); // If flag is enabled, print a message, address spaces
 		printf("\n\nNo valid translation found\n");		// ham nay la cua linus hay cua nachos
 		SysHalt();
@@ -105,6 +109,13 @@ void ExceptionHandler(ExceptionType which)
 	}
 	case AddressErrorException: // Unaligned reference or one that was beyond the end of the address space
 	{
+		if ((unsigned int)kernel->machine->ReadRegister(BadVAddrReg) == UserThreadReturn)
+		{
+			// a thread returned from its function: end it, with the function's result
+			DEBUG(dbgSys, "Thread returned " << kernel->machine->ReadRegister(2) << "\n");
+			SysThreadExit((int)kernel->machine->ReadRegister(2));
+			ASSERTNOTREACHED();
+		}
 		DEBUG(dbgAddr, "Unaligned reference or one that was beyond the end of the address space\n");
 		printf("\n\nUnaligned reference or one that was beyond the end of the address space\n");
 		SysHalt();
@@ -132,6 +143,9 @@ void ExceptionHandler(ExceptionType which)
 		return;
 	}
 	case SyscallException: // A program executed a system call
+		if (kernel->syscallTrace != NULL)
+			kernel->syscallTrace->Enter(type);
+
 		switch (type)
 		{
 		case SC_Halt:
@@ -144,6 +158,267 @@ void ExceptionHandler(ExceptionType which)
 			break;
 		}
 
+		case SC_Exit:
+		{
+			DEBUG(dbgSys, "Exit " << kernel->machine->ReadRegister(4) << "\n");
+
+			SysExit((int)kernel->machine->ReadRegister(4));
+
+			ASSERTNOTREACHED();
+			break;
+		}
+
+		case SC_Exec:
+		{
+			int virtAddr = kernel->machine->ReadRegister(4);			// read register 4(argument 1)
+			char *name = kernel->User2System(virtAddr, MAX_FILE_LENGTH); // copy file name from User memory space to System memory space
+
+			if (name == NULL) // a bad address
+			{
+				kernel->machine->WriteRegister(2, -1);
+				kernel->IncreasePC();
+				break;
+			}
+			DEBUG(dbgSys, "Exec " << name << "\n");
+			kernel->machine->WriteRegister(2, SysExec(name));
+
+			delete[] name;
+			kernel->IncreasePC();
+			break;
+		}
+
+		case SC_ExecIO:
+		{
+			int virtAddr = kernel->machine->ReadRegister(4);
+			char *name = kernel->User2System(virtAddr, MAX_FILE_LENGTH);
+
+			if (name == NULL) // a bad address
+			{
+				kernel->machine->WriteRegister(2, -1);
+				kernel->IncreasePC();
+				break;
+			}
+			DEBUG(dbgSys, "ExecIO " << name << "\n");
+			kernel->machine->WriteRegister(2, SysExecIO(name,
+									/* int input */ (int)kernel->machine->ReadRegister(5),
+									/* int output */ (int)kernel->machine->ReadRegister(6)));
+
+			delete[] name;
+			kernel->IncreasePC();
+			break;
+		}
+
+		case SC_Join:
+		{
+			DEBUG(dbgSys, "Join " << kernel->machine->ReadRegister(4) << "\n");
+
+			int status = SysJoin((int)kernel->machine->ReadRegister(4));
+			kernel->machine->WriteRegister(2, status);
+
+			kernel->IncreasePC();
+			break;
+		}
+
+		case SC_ThreadFork:
+		{
+			DEBUG(dbgSys, "ThreadFork " << kernel->machine->ReadRegister(4) << "\n");
+
+			int tid = SysThreadFork((int)kernel->machine->ReadRegister(4),
+									/* int arg */ (int)kernel->machine->ReadRegister(5));
+			kernel->machine->WriteRegister(2, tid);
+
+			kernel->IncreasePC();
+			break;
+		}
+
+		case SC_ThreadYield:
+		{
+			kernel->IncreasePC();
+			kernel->currentThread->Yield();
+			break;
+		}
+
+		case SC_ThreadJoin:
+		{
+			DEBUG(dbgSys, "ThreadJoin " << kernel->machine->ReadRegister(4) << "\n");
+
+			int exitCode = SysThreadJoin((int)kernel->machine->ReadRegister(4));
+			kernel->machine->WriteRegister(2, exitCode);
+
+			kernel->IncreasePC();
+			break;
+		}
+
+		case SC_ThreadExit:
+		{
+			DEBUG(dbgSys, "ThreadExit " << kernel->machine->ReadRegister(4) << "\n");
+
+			SysThreadExit((int)kernel->machine->ReadRegister(4));
+
+			ASSERTNOTREACHED();
+			break;
+		}
+
+		case SC_Wait:
+		{
+			DEBUG(dbgSys, "Wait " << kernel->machine->ReadRegister(4) << ", " << kernel->machine->ReadRegister(5) << "\n");
+
+			int result = SysWait((int)kernel->machine->ReadRegister(4),
+								 /* int expected */ (int)kernel->machine->ReadRegister(5));
+			kernel->machine->WriteRegister(2, result);
+
+			kernel->IncreasePC();
+			break;
+		}
+
+		case SC_Wake:
+		{
+			DEBUG(dbgSys, "Wake " << kernel->machine->ReadRegister(4) << ", " << kernel->machine->ReadRegister(5) << "\n");
+
+			int woken = SysWake((int)kernel->machine->ReadRegister(4),
+								/* int count */ (int)kernel->machine->ReadRegister(5));
+			kernel->machine->WriteRegister(2, woken);
+
+			kernel->IncreasePC();
+			break;
+		}
+
+		case SC_ShmCreate:
+		{
+			DEBUG(dbgSys, "ShmCreate " << kernel->machine->ReadRegister(4) << ", " << kernel->machine->ReadRegister(5) << "\n");
+
+			int result = SysShmCreate((int)kernel->machine->ReadRegister(4),
+									  /* int size */ (int)kernel->machine->ReadRegister(5));
+			kernel->machine->WriteRegister(2, result);
+
+			kernel->IncreasePC();
+			break;
+		}
+
+		case SC_ShmAttach:
+		{
+			DEBUG(dbgSys, "ShmAttach " << kernel->machine->ReadRegister(4) << ", " << kernel->machine->ReadRegister(5) << "\n");
+
+			int result = SysShmAttach((int)kernel->machine->ReadRegister(4),
+									  /* int addr */ (int)kernel->machine->ReadRegister(5));
+			kernel->machine->WriteRegister(2, result);
+
+			kernel->IncreasePC();
+			break;
+		}
+
+		case SC_ShmDetach:
+		{
+			DEBUG(dbgSys, "ShmDetach " << kernel->machine->ReadRegister(4) << "\n");
+
+			int result = SysShmDetach((int)kernel->machine->ReadRegister(4));
+			kernel->machine->WriteRegister(2, result);
+
+			kernel->IncreasePC();
+			break;
+		}
+
+		case SC_Mmap:
+		{
+			DEBUG(dbgSys, "Mmap " << kernel->machine->ReadRegister(4) << ", " << kernel->machine->ReadRegister(5) << ", " << kernel->machine->ReadRegister(6) << "\n");
+
+			int result = SysMmap((int)kernel->machine->ReadRegister(4),
+								 /* int offset */ (int)kernel->machine->ReadRegister(5),
+								 /* int length */ (int)kernel->machine->ReadRegister(6));
+			kernel->machine->WriteRegister(2, result);
+
+			kernel->IncreasePC();
+			break;
+		}
+
+		case SC_Munmap:
+		{
+			DEBUG(dbgSys, "Munmap " << kernel->machine->ReadRegister(4) << "\n");
+
+			int result = SysMunmap((int)kernel->machine->ReadRegister(4));
+			kernel->machine->WriteRegister(2, result);
+
+			kernel->IncreasePC();
+			break;
+		}
+
+		case SC_AsyncRead:
+		case SC_AsyncWrite:
+		{
+			DEBUG(dbgSys, (type == SC_AsyncRead ? "AsyncRead " : "AsyncWrite ") << kernel->machine->ReadRegister(4) << ", " << kernel->machine->ReadRegister(5) << ", " << kernel->machine->ReadRegister(6) << "\n");
+
+			int result = SysAsyncIO((int)kernel->machine->ReadRegister(4),
+									/* int size */ (int)kernel->machine->ReadRegister(5),
+									/* OpenFileId id */ (int)kernel->machine->ReadRegister(6),
+									/* int *status */ (int)kernel->machine->ReadRegister(7),
+									type == SC_AsyncWrite);
+			kernel->machine->WriteRegister(2, result);
+
+			kernel->IncreasePC();
+			break;
+		}
+
+		case SC_WaitIO:
+		{
+			DEBUG(dbgSys, "WaitIO " << kernel->machine->ReadRegister(4) << "\n");
+
+			int result = SysWaitIO((int)kernel->machine->ReadRegister(4));
+			kernel->machine->WriteRegister(2, result);
+
+			kernel->IncreasePC();
+			break;
+		}
+
+		case SC_ReadV:
+		case SC_WriteV:
+		{
+			DEBUG(dbgSys, (type == SC_ReadV ? "ReadV " : "WriteV ") << kernel->machine->ReadRegister(4) << ", " << kernel->machine->ReadRegister(5) << ", " << kernel->machine->ReadRegister(6) << "\n");
+
+			int result = SysVectorIO((int)kernel->machine->ReadRegister(4),
+									 /* int count */ (int)kernel->machine->ReadRegister(5),
+									 /* OpenFileId id */ (int)kernel->machine->ReadRegister(6),
+									 type == SC_WriteV);
+			kernel->machine->WriteRegister(2, result);
+
+			kernel->IncreasePC();
+			break;
+		}
+
+		case SC_Poll:
+		{
+			DEBUG(dbgSys, "Poll " << kernel->machine->ReadRegister(4) << ", " << kernel->machine->ReadRegister(5) << ", " << kernel->machine->ReadRegister(6) << "\n");
+
+			int result = SysPoll((int)kernel->machine->ReadRegister(4),
+								 /* int count */ (int)kernel->machine->ReadRegister(5),
+								 /* int timeout */ (int)kernel->machine->ReadRegister(6));
+			kernel->machine->WriteRegister(2, result);
+
+			kernel->IncreasePC();
+			break;
+		}
+
+		case SC_RingSetup:
+		{
+			DEBUG(dbgSys, "RingSetup\n");
+
+			int result = SysRingSetup();
+			kernel->machine->WriteRegister(2, result);
+
+			kernel->IncreasePC();
+			break;
+		}
+
+		case SC_Enter:
+		{
+			DEBUG(dbgSys, "Enter " << kernel->machine->ReadRegister(4) << "\n");
+
+			int result = SysEnter((int)kernel->machine->ReadRegister(4));
+			kernel->machine->WriteRegister(2, result);
+
+			kernel->IncreasePC();
+			break;
+		}
+
 		case SC_Add:
 		{
 			DEBUG(dbgSys, "Add " << kernel->machine->ReadRegister(4) << " + " << kernel->machine->ReadRegister(5) << "\n");
@@ -169,10 +444,6 @@ void ExceptionHandler(ExceptionType which)
 				kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
 			}
 
-			return;
-
-			ASSERTNOTREACHED();
-
 			break;
 		}
 
@@ -199,10 +470,6 @@ void ExceptionHandler(ExceptionType which)
 			// 	/* set next programm counter for brach execution */
 			// 	kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
 			// }
-			return;
-
-			ASSERTNOTREACHED();
-
 			break;
 		}
 
@@ -250,13 +517,18 @@ void ExceptionHandler(ExceptionType which)
 			int len = kernel->machine->ReadRegister(5);		// read register 5(argument 2)
 			char *str = kernel->User2System(virAddr, len);	// copy buffer from User memory space to System memory space
 
+			if (str == NULL) // a bad address
+			{
+				kernel->IncreasePC();
+				break;
+			}
 			kernel->ReadString2KeyBoard(virAddr, str, len);
 
 			// cout << str << endl;
 
 			kernel->IncreasePC();
 			delete[] str;
-			return;
+			break;
 		}
 
 		case SC_PrintString:
@@ -270,7 +542,7 @@ void ExceptionHandler(ExceptionType which)
 				printf("\n Memory is invalid\n");
 				DEBUG(dbgSys, "\n Memory is invalid\n");
 				kernel->IncreasePC();
-				return;
+				break;
 			}
 
 			kernel->PrintString2Console(str_buffer);
@@ -278,7 +550,7 @@ void ExceptionHandler(ExceptionType which)
 			delete[] str_buffer;
 			kernel->IncreasePC();
 
-			return;
+			break;
 		}
 
 		case SC_Create:
@@ -331,15 +603,95 @@ void ExceptionHandler(ExceptionType which)
 			break;
 		}
 
+		case SC_Pipe:
+		{
+			DEBUG(dbgSys, "Pipe " << kernel->machine->ReadRegister(4) << "\n");
+
+			kernel->machine->WriteRegister(2, SysPipe((int)kernel->machine->ReadRegister(4)));
+
+			kernel->IncreasePC();
+			break;
+		}
+
 		default:
 		{
 			cerr << "Unexpected system call " << type << "\n";
 			break;
 		}
 		}
+
+		if (kernel->syscallTrace != NULL)
+			kernel->syscallTrace->Return(type);
 		break;
 	default:
 		cerr << "Unexpected user mode exception" << (int)which << "\n";
 		break;
 	}
 }
+
+//----------------------------------------------------------------------
+// RingSyscall
+// 	Do one request from a program's ring of batched system calls
+//	(see ring.h), by handing ExceptionHandler the registers it would
+//	have seen had the program trapped for it: "op" in r2, and "arg"
+//	in r4-r6.  The handler moves the PC on, so it is put back after,
+//	along with the program's own r4-r6.
+//
+//	Only calls that return to the program right away, and don't
+//	need r7, can be batched; the rest get EINVAL.  So do reads and
+//	writes of the console input, pipes and mailboxes, which can
+//	wait for another program indefinitely -- holding the ring, so
+//	the other threads of the program couldn't Enter either.  Calls
+//	that return nothing give 0.
+//----------------------------------------------------------------------
+
+int RingSyscall(int op, int *arg)
+{
+	int pc = kernel->machine->ReadRegister(PCReg);
+	int nextPC = kernel->machine->ReadRegister(NextPCReg);
+	int prevPC = kernel->machine->ReadRegister(PrevPCReg);
+	bool returnsValue = TRUE;
+	int saved[3], result, id;
+
+	switch (op)
+	{
+	case SC_PrintString:
+	case SC_PrintChar:
+	case SC_PrintNum:
+		returnsValue = FALSE;
+		break;
+	case SC_Read:
+	case SC_Write:
+	case SC_ReadV:
+	case SC_WriteV:
+		id = kernel->processTable->Redirect(arg[2]);
+		if (id == ConsoleInput || kernel->pipes->IsPipe(id) || id >= MailBoxId(0))
+			return EINVAL;
+		break;
+	case SC_Seek:
+	case SC_Create:
+	case SC_Open:
+	case SC_Close:
+	case SC_Add:
+	case SC_Sub:
+		break;
+	default:
+		return EINVAL;
+	}
+
+	kernel->machine->WriteRegister(2, op);
+	for (int i = 0; i < 3; i++)
+	{
+		saved[i] = kernel->machine->ReadRegister(4 + i);
+		kernel->machine->WriteRegister(4 + i, arg[i]);
+	}
+	ExceptionHandler(SyscallException);
+	result = returnsValue ? kernel->machine->ReadRegister(2) : 0;
+
+	kernel->machine->WriteRegister(PCReg, pc);
+	kernel->machine->WriteRegister(NextPCReg, nextPC);
+	kernel->machine->WriteRegister(PrevPCReg, prevPC);
+	for (int i = 0; i < 3; i++)
+		kernel->machine->WriteRegister(4 + i, saved[i]);
+	return result;
+}
@@ -0,0 +1,233 @@
+// futex.cc
+//	Routines to put user threads to sleep on a word of their memory,
+//	and to wake them up again.
+//
+//	Wait checks the word and goes to sleep with interrupts off.
+//	The word can only be changed by a user instruction, and so by a
+//	thread that gets the CPU; with interrupts off none can, so no
+//	Wake can slip in between the check and the sleep and be lost.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "main.h"
+#include "futex.h"
+#include "errno.h"
+
+//----------------------------------------------------------------------
+// FutexQueue::FutexQueue
+// 	Initialize an empty queue of threads waiting on a word.
+//
+//	"addr" is the physical address of the word.
+//----------------------------------------------------------------------
+
+FutexQueue::FutexQueue(int addr)
+{
+    paddr = addr;
+    waiters = new List<Thread *>;
+}
+
+//----------------------------------------------------------------------
+// FutexQueue::~FutexQueue
+// 	De-allocate a queue; nobody may be waiting on it.
+//----------------------------------------------------------------------
+
+FutexQueue::~FutexQueue()
+{
+    ASSERT(waiters->IsEmpty());
+    delete waiters;
+}
+
+//----------------------------------------------------------------------
+// FutexKey, HashAddress
+//	The functions the table of queues needs: they are keyed by
+//	the physical address of the word.  Words are aligned, so the
+//	low bits say nothing.
+//----------------------------------------------------------------------
+
+static int
+FutexKey(FutexQueue *queue)
+{
+    return queue->paddr;
+}
+
+static unsigned
+HashAddress(int paddr)
+{
+    return (unsigned)paddr >> 2;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::FutexTable
+// 	Initialize the table; nobody is waiting yet.
+//----------------------------------------------------------------------
+
+FutexTable::FutexTable()
+{
+    queues = new HashTable<int, FutexQueue *>(FutexKey, HashAddress);
+}
+
+//----------------------------------------------------------------------
+// FutexTable::~FutexTable
+// 	De-allocate the table.  Any threads still waiting are left
+//	asleep; this only happens when Nachos is halting.
+//----------------------------------------------------------------------
+
+FutexTable::~FutexTable()
+{
+    HashIterator<int, FutexQueue *> iter(queues);
+    List<FutexQueue *> queueList;
+
+    for (; !iter.IsDone(); iter.Next())
+	queueList.Append(iter.Item());
+    while (!queueList.IsEmpty()) {
+	FutexQueue *queue = queueList.RemoveFront();
+
+	while (!queue->waiters->IsEmpty())
+	    (void) queue->waiters->RemoveFront();
+	Release(queue);
+    }
+    delete queues;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Physical
+// 	Translate a user address in the current address space to the
+//	physical address of the word.  Return FALSE if it isn't an
+//	aligned address of a valid page.
+//----------------------------------------------------------------------
+
+bool
+FutexTable::Physical(int vaddr, int *paddr)
+{
+    AddrSpace *space = kernel->currentThread->space;
+    unsigned int addr;
+
+    if ((vaddr & 0x3) != 0 || space == NULL)
+	return FALSE;
+    if (space->Translate(vaddr, &addr, FALSE) != NoException)
+	return FALSE;
+    *paddr = (int) addr;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Release
+// 	Take a queue that nobody is waiting on out of the table.
+//----------------------------------------------------------------------
+
+void
+FutexTable::Release(FutexQueue *queue)
+{
+    (void) queues->Remove(queue->paddr);
+    delete queue;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Wait
+// 	Put the current thread to sleep, if the word at "vaddr" still
+//	holds "expected", until a Wake on the same word.  A thread of
+//	a process that is exiting doesn't sleep; it is about to be
+//	stopped.
+//
+//	Return 0 if we slept, EAGAIN if the word had changed, EFAULT if
+//	"vaddr" is not a word we can read.
+//----------------------------------------------------------------------
+
+int
+FutexTable::Wait(int vaddr, int expected)
+{
+    Thread *thread = kernel->currentThread;
+    FutexQueue *queue;
+    IntStatus oldLevel;
+    int paddr, value;
+
+    if (!Physical(vaddr, &paddr))
+	return EFAULT;
+
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    value = WordToHost(*(unsigned int *) &kernel->machine->mainMemory[paddr]);
+    if (value != expected || thread->space->exiting) {
+	(void) kernel->interrupt->SetLevel(oldLevel);
+	return EAGAIN;
+    }
+
+    if (!queues->Find(paddr, &queue)) {
+	queue = new FutexQueue(paddr);
+	queues->Insert(queue);
+    }
+    DEBUG(dbgSynch, "Futex wait at " << paddr << " by " << thread->getName());
+    queue->waiters->Append(thread);
+    thread->Sleep(FALSE);
+
+    (void) kernel->interrupt->SetLevel(oldLevel);
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Wake
+// 	Wake up to "count" of the threads waiting on the word at "vaddr",
+//	the ones that have waited longest first.  Return how many there
+//	were, or EFAULT if "vaddr" is not a word we can read.
+//----------------------------------------------------------------------
+
+int
+FutexTable::Wake(int vaddr, int count)
+{
+    FutexQueue *queue;
+    IntStatus oldLevel;
+    int paddr, woken = 0;
+
+    if (!Physical(vaddr, &paddr))
+	return EFAULT;
+
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    if (queues->Find(paddr, &queue)) {
+	while (woken < count && !queue->waiters->IsEmpty()) {
+	    kernel->scheduler->ReadyToRun(queue->waiters->RemoveFront());
+	    woken++;
+	}
+	if (queue->waiters->IsEmpty())
+	    Release(queue);
+    }
+    (void) kernel->interrupt->SetLevel(oldLevel);
+
+    DEBUG(dbgSynch, "Futex wake at " << paddr << ": " << woken);
+    return woken;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::WakeProcess
+// 	Wake every thread of process "pid" that is waiting on any word,
+//	so that it notices the process is exiting.
+//----------------------------------------------------------------------
+
+void
+FutexTable::WakeProcess(int pid)
+{
+    HashIterator<int, FutexQueue *> iter(queues);
+    List<FutexQueue *> emptied;
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+    for (; !iter.IsDone(); iter.Next()) {
+	FutexQueue *queue = iter.Item();
+	int n = queue->waiters->NumInList();
+
+	for (int i = 0; i < n; i++) {	// keep the others in order
+	    Thread *thread = queue->waiters->RemoveFront();
+
+	    if (thread->processId == pid)
+		kernel->scheduler->ReadyToRun(thread);
+	    else
+		queue->waiters->Append(thread);
+	}
+	if (queue->waiters->IsEmpty())
+	    emptied.Append(queue);
+    }
+    while (!emptied.IsEmpty())
+	Release(emptied.RemoveFront());
+
+    (void) kernel->interrupt->SetLevel(oldLevel);
+}
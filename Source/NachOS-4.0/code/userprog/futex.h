@@ -0,0 +1,69 @@
+// futex.h
+//	Data structures for the Wait and Wake system calls, which let
+//	user programs build locks that only enter the kernel when
+//	there is contention ("fast user-space mutexes", or futexes).
+//
+//	A thread calls Wait(addr, expected) to sleep until woken, but
+//	only if the word at "addr" still holds "expected"; the check
+//	and the sleep can't be separated by another thread changing
+//	the word.  Wake(addr, n) wakes up to n of the threads waiting
+//	on "addr".
+//
+//	The threads waiting on each word are kept in a queue, found
+//	through a hash table.  Queues are keyed by the word's physical
+//	address, not its virtual one, so that threads in different
+//	address spaces can wait on a word they share.  A queue only
+//	exists while someone is waiting on it.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include "copyright.h"
+#include "list.h"
+#include "hash.h"
+#include "thread.h"
+
+// The threads waiting on one word of memory, in the order they
+// called Wait.
+
+class FutexQueue {
+  public:
+    FutexQueue(int addr);
+    ~FutexQueue();
+
+    int paddr;				// Physical address of the word
+    List<Thread *> *waiters;		// Threads asleep on it
+};
+
+// The following class defines the table of all the words that
+// threads are waiting on.
+
+class FutexTable {
+  public:
+    FutexTable();
+    ~FutexTable();
+
+    int Wait(int vaddr, int expected);	// Sleep until woken, if the word at
+					// "vaddr" holds "expected"; 0 when
+					// woken, EAGAIN if it didn't hold
+					// it, EFAULT if "vaddr" is bad
+    int Wake(int vaddr, int count);	// Wake up to "count" threads waiting
+					// on "vaddr"; return how many were,
+					// or EFAULT if "vaddr" is bad
+    void WakeProcess(int pid);		// Wake all the threads of process
+					// "pid", which is exiting
+
+  private:
+    bool Physical(int vaddr, int *paddr);
+					// Find the word "vaddr" names in
+					// the current address space
+    void Release(FutexQueue *queue);	// Forget a queue nobody waits on
+
+    HashTable<int, FutexQueue *> *queues;  // The queues, by physical address
+};
+
+#endif // FUTEX_H
@@ -12,6 +12,15 @@
 #define __USERPROG_KSYSCALL_H__
 
 #include "kernel.h"
+#include "ptable.h"
+#include "futex.h"
+#include "pipe.h"
+#include "shm.h"
+#include "mmap.h"
+#include "aio.h"
+#include "ring.h"
+#include "poll.h"
+#include "vecio.h"
 
 
 void SysHalt()
@@ -29,4 +38,128 @@ int SysSub(int op1, int op2)
   return op1 - op2;
 }
 
+int SysExec(char *name)
+{
+  return kernel->processTable->Exec(name, ConsoleInput, ConsoleOutput);
+}
+
+int SysExecIO(char *name, int input, int output)
+{
+  return kernel->processTable->Exec(name, input, output);
+}
+
+int SysJoin(int id)
+{
+  return kernel->processTable->Join(id);
+}
+
+void SysExit(int status)
+{
+  kernel->processTable->Exit(status);
+}
+
+int SysThreadFork(int func, int arg)
+{
+  return kernel->processTable->ThreadFork(func, arg);
+}
+
+int SysThreadJoin(int id)
+{
+  return kernel->processTable->ThreadJoin(id);
+}
+
+void SysThreadExit(int exitCode)
+{
+  kernel->processTable->ThreadExit(exitCode);
+}
+
+int SysPipe(int fdsAddr)
+{
+  int readId, writeId;
+
+  if (!kernel->pipes->Create(&readId, &writeId))
+    return -1;
+  if (!kernel->machine->WriteMem(fdsAddr, 4, readId)
+      || !kernel->machine->WriteMem(fdsAddr + 4, 4, writeId))
+  {
+    kernel->pipes->Close(readId);
+    kernel->pipes->Close(writeId);
+    return -1;
+  }
+  kernel->processTable->AddPipeEnd(readId);
+  kernel->processTable->AddPipeEnd(writeId);
+  return 0;
+}
+
+int SysWait(int addr, int expected)
+{
+  return kernel->futexes->Wait(addr, expected);
+}
+
+int SysWake(int addr, int count)
+{
+  return kernel->futexes->Wake(addr, count);
+}
+
+int SysShmCreate(int key, int size)
+{
+  return kernel->shm->Create(key, size);
+}
+
+int SysShmAttach(int key, int addr)
+{
+  return kernel->shm->Attach(key, addr);
+}
+
+int SysShmDetach(int addr)
+{
+  return kernel->shm->Detach(addr);
+}
+
+int SysMmap(int fileId, int offset, int length)
+{
+  if (fileId < 2 || fileId >= 20 || kernel->fileSystem->ListFile[fileId] == NULL)
+    return 0;   /* not an open file: the console and pipes can't be mapped */
+  return kernel->mappings->Map(kernel->fileSystem->ListFile[fileId],
+                               offset, length);
+}
+
+int SysMunmap(int addr)
+{
+  return kernel->mappings->Unmap(addr);
+}
+
+int SysAsyncIO(int bufferAddr, int size, int fileId, int statusAddr, bool writing)
+{
+  if (fileId < 2 || fileId >= 20 || kernel->fileSystem->ListFile[fileId] == NULL)
+    return EBADF;   /* the console and pipes are not done this way */
+  return kernel->aio->Submit(kernel->fileSystem->ListFile[fileId], writing,
+                             bufferAddr, size, statusAddr);
+}
+
+int SysWaitIO(int handle)
+{
+  return kernel->aio->Wait(handle);
+}
+
+int SysVectorIO(int vecAddr, int count, int fileId, bool writing)
+{
+  return VectorIO(vecAddr, count, fileId, writing);
+}
+
+int SysPoll(int fdsAddr, int count, int timeout)
+{
+  return PollFiles(fdsAddr, count, timeout);
+}
+
+int SysRingSetup()
+{
+  return kernel->rings->Setup();
+}
+
+int SysEnter(int count)
+{
+  return kernel->rings->Enter(count);
+}
+
 #endif /* ! __USERPROG_KSYSCALL_H__ */
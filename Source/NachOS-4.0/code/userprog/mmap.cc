@@ -0,0 +1,337 @@
+// mmap.cc
+//	Routines to map open files into address spaces, and to move
+//	their pages between the file and memory on demand.
+//
+//	A page of a mapping that is not in memory has an invalid entry
+//	in the page table, so touching it raises a PageFaultException;
+//	the exception handler calls PageIn, and the instruction is tried
+//	again.  The kernel's own accesses to user memory go through
+//	AddrSpace::Translate, which calls PageIn itself.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "main.h"
+#include "mmap.h"
+#include "addrspace.h"
+#include "bitmap.h"
+#include "synch.h"
+
+//----------------------------------------------------------------------
+// FileMapping::FileMapping
+// 	Initialize a mapping of "len" bytes of "f", from byte "off" on,
+//	at "addr" in "s".  None of its pages are in memory yet.
+//----------------------------------------------------------------------
+
+FileMapping::FileMapping(AddrSpace *s, int addr, OpenFile *f, int off, int len)
+{
+    space = s;
+    vaddr = addr;
+    numPages = divRoundUp(len, PageSize);
+    file = f;
+    offset = off;
+    length = len;
+    frames = new int[numPages];
+    for (int i = 0; i < numPages; i++)
+	frames[i] = -1;
+    hand = 0;
+}
+
+//----------------------------------------------------------------------
+// FileMapping::~FileMapping
+// 	De-allocate a mapping; its pages must have been paged out.
+//----------------------------------------------------------------------
+
+FileMapping::~FileMapping()
+{
+    delete [] frames;
+}
+
+//----------------------------------------------------------------------
+// MmapTable::MmapTable
+// 	Initialize the table; nothing is mapped.
+//----------------------------------------------------------------------
+
+MmapTable::MmapTable()
+{
+    mappings = new List<FileMapping *>;
+    lock = new Lock("mmap");
+}
+
+//----------------------------------------------------------------------
+// MmapTable::~MmapTable
+// 	Nachos is halting; give back the frames without writing them,
+//	since the disk may be gone.
+//----------------------------------------------------------------------
+
+MmapTable::~MmapTable()
+{
+    while (!mappings->IsEmpty()) {
+	FileMapping *mapping = mappings->RemoveFront();
+
+	for (int i = 0; i < mapping->numPages; i++) {
+	    if (mapping->frames[i] >= 0) {
+		mapping->space->Unmap(mapping->vaddr + i * PageSize, 1);
+		kernel->frameMap->Clear(mapping->frames[i]);
+	    }
+	}
+	delete mapping;
+    }
+    delete mappings;
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// MmapTable::Find
+// 	Return the mapping in "space" that "vaddr" is in, or NULL if
+//	there isn't one.
+//----------------------------------------------------------------------
+
+FileMapping *
+MmapTable::Find(AddrSpace *space, int vaddr)
+{
+    ListIterator<FileMapping *> iter(mappings);
+
+    for (; !iter.IsDone(); iter.Next()) {
+	FileMapping *mapping = iter.Item();
+
+	if (mapping->space == space && vaddr >= mapping->vaddr
+		&& vaddr < mapping->vaddr + mapping->numPages * PageSize)
+	    return mapping;
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// MmapTable::FileBytes
+// 	Return how many bytes of the file page "page" of "mapping" holds
+//	-- a whole page, except maybe for the last one -- and put where
+//	they start in "*position".
+//----------------------------------------------------------------------
+
+int
+MmapTable::FileBytes(FileMapping *mapping, int page, int *position)
+{
+    *position = mapping->offset + page * PageSize;
+    return min(PageSize, mapping->length - page * PageSize);
+}
+
+//----------------------------------------------------------------------
+// MmapTable::Map
+// 	Map "length" bytes of "file", starting at byte "offset", into
+//	the current address space, at pages it isn't using.
+//	Return the address of the first byte, or 0 if the arguments
+//	are bad, or the address space can't grow that much.
+//----------------------------------------------------------------------
+
+int
+MmapTable::Map(OpenFile *file, int offset, int length)
+{
+    AddrSpace *space = kernel->currentThread->space;
+    int vaddr;
+
+    if (offset < 0 || length <= 0)
+	return 0;
+    vaddr = space->Reserve(divRoundUp(length, PageSize));
+    if (vaddr < 0)
+	return 0;
+
+    mappings->Append(new FileMapping(space, vaddr, file, offset, length));
+    DEBUG(dbgAddr, "Mapped " << length << " bytes of a file at " << vaddr);
+    return vaddr;
+}
+
+//----------------------------------------------------------------------
+// MmapTable::PageOut
+// 	Take page "page" of "mapping" out of memory, writing it back to
+//	the file if it was written.  The lock must be held.
+//
+//	The page is unmapped before it is written, so that anyone who
+//	touches it in the meantime waits for the lock to read it in.
+//----------------------------------------------------------------------
+
+void
+MmapTable::PageOut(FileMapping *mapping, int page)
+{
+    int frame = mapping->frames[page];
+    int vaddr = mapping->vaddr + page * PageSize;
+    bool dirty = mapping->space->IsDirty(vaddr);
+    int position, size;
+
+    mapping->space->Unmap(vaddr, 1);
+    mapping->frames[page] = -1;
+
+    if (dirty) {
+	size = FileBytes(mapping, page, &position);
+	size = min(size, mapping->file->Length() - position);
+	if (size > 0)			// never past the end of the file
+	    (void) mapping->file->WriteAt(
+		&(kernel->machine->mainMemory[frame * PageSize]),
+		size, position);
+	DEBUG(dbgAddr, "Wrote back page " << vaddr << ": " << size << " bytes");
+    }
+    kernel->frameMap->Clear(frame);
+}
+
+//----------------------------------------------------------------------
+// MmapTable::Evict
+// 	Free a frame by paging out some page of some mapping: the next
+//	one in memory after the last taken out of the first mapping
+//	that has any.  That mapping goes to the back of the line.
+//	Return FALSE if no mapping has a page in memory.
+//----------------------------------------------------------------------
+
+bool
+MmapTable::Evict()
+{
+    ListIterator<FileMapping *> iter(mappings);
+
+    for (; !iter.IsDone(); iter.Next()) {
+	FileMapping *mapping = iter.Item();
+
+	for (int i = 0; i < mapping->numPages; i++) {
+	    int page = (mapping->hand + i) % mapping->numPages;
+
+	    if (mapping->frames[page] >= 0) {
+		mapping->hand = (page + 1) % mapping->numPages;
+		PageOut(mapping, page);
+		mappings->Remove(mapping);
+		mappings->Append(mapping);
+		return TRUE;
+	    }
+	}
+    }
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// MmapTable::PageIn
+// 	Read the page of "space" that "vaddr" is on in from its file,
+//	into a frame of its own; bytes past the end of the file are
+//	zero.  Return FALSE if "vaddr" is not in a mapping, or there is
+//	no frame to be had.
+//----------------------------------------------------------------------
+
+bool
+MmapTable::PageIn(AddrSpace *space, int vaddr)
+{
+    FileMapping *mapping;
+    int page, frame, position, size;
+
+    lock->Acquire();
+    mapping = Find(space, vaddr);
+    if (mapping == NULL) {
+	lock->Release();
+	return FALSE;
+    }
+
+    page = (vaddr - mapping->vaddr) / PageSize;
+    if (mapping->frames[page] < 0) {	// nobody read it in while we
+					// waited for the lock
+	frame = kernel->frameMap->FindAndSet();
+	if (frame < 0 && Evict())
+	    frame = kernel->frameMap->FindAndSet();
+	if (frame < 0) {
+	    lock->Release();
+	    return FALSE;
+	}
+
+	bzero(&(kernel->machine->mainMemory[frame * PageSize]), PageSize);
+	size = FileBytes(mapping, page, &position);
+	(void) mapping->file->ReadAt(
+		&(kernel->machine->mainMemory[frame * PageSize]),
+		size, position);
+	if (!space->Map(mapping->vaddr + page * PageSize, &frame, 1, TRUE)) {
+	    kernel->frameMap->Clear(frame);
+	    lock->Release();
+	    return FALSE;
+	}
+	mapping->frames[page] = frame;
+	DEBUG(dbgAddr, "Read in page " << mapping->vaddr + page * PageSize
+			<< " of a file, from byte " << position);
+    }
+    lock->Release();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// MmapTable::Remove
+// 	Write back the pages of "mapping" that were written, give back
+//	its frames and its pages of the address space, and forget about
+//	it.  The lock must be held.
+//----------------------------------------------------------------------
+
+void
+MmapTable::Remove(FileMapping *mapping)
+{
+    for (int i = 0; i < mapping->numPages; i++) {
+	if (mapping->frames[i] >= 0)
+	    PageOut(mapping, i);
+    }
+    mapping->space->Release(mapping->vaddr, mapping->numPages);
+    mappings->Remove(mapping);
+    DEBUG(dbgAddr, "Unmapped the file at " << mapping->vaddr);
+    delete mapping;
+}
+
+//----------------------------------------------------------------------
+// MmapTable::Unmap
+// 	Unmap the mapping at "vaddr" in the current address space.
+//	Return 0, or -1 if there isn't one starting there.
+//----------------------------------------------------------------------
+
+int
+MmapTable::Unmap(int vaddr)
+{
+    FileMapping *mapping;
+
+    lock->Acquire();
+    mapping = Find(kernel->currentThread->space, vaddr);
+    if (mapping == NULL || mapping->vaddr != vaddr) {
+	lock->Release();
+	return -1;
+    }
+    Remove(mapping);
+    lock->Release();
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// MmapTable::CloseFile, MmapTable::UnmapAll
+// 	Unmap every mapping of "file", which is about to be closed, or
+//	every mapping in "space", which is about to be deleted.
+//----------------------------------------------------------------------
+
+void
+MmapTable::CloseFile(OpenFile *file)
+{
+    List<FileMapping *> doomed;		// Remove changes the list
+
+    lock->Acquire();
+    ListIterator<FileMapping *> iter(mappings);
+    for (; !iter.IsDone(); iter.Next()) {
+	if (iter.Item()->file == file)
+	    doomed.Append(iter.Item());
+    }
+    while (!doomed.IsEmpty())
+	Remove(doomed.RemoveFront());
+    lock->Release();
+}
+
+void
+MmapTable::UnmapAll(AddrSpace *space)
+{
+    List<FileMapping *> doomed;
+
+    lock->Acquire();
+    ListIterator<FileMapping *> iter(mappings);
+    for (; !iter.IsDone(); iter.Next()) {
+	if (iter.Item()->space == space)
+	    doomed.Append(iter.Item());
+    }
+    while (!doomed.IsEmpty())
+	Remove(doomed.RemoveFront());
+    lock->Release();
+}
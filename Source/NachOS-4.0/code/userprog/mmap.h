@@ -0,0 +1,89 @@
+// mmap.h
+//	Data structures for memory-mapped files: a range of pages in a
+//	user program's address space that holds the bytes of an open
+//	file, so the program can use them without Read and Write.
+//
+//	Mmap only reserves the pages.  Each is read from the file the
+//	first time it is touched (a page fault), into a page frame that
+//	belongs to the mapping; if there are no free frames, a page of
+//	some mapping is taken out to make room.  A page that has been
+//	written is written back to the file when it is taken out, and
+//	when the mapping goes away: on Munmap, when the file is closed,
+//	or when the program exits.  (Not when Nachos halts.)
+//
+//	The pages of a mapping are the first run of unused ones in the
+//	address space, or else new ones at the top; they are set aside
+//	so ShmAttach can't use them, and given back on Munmap.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef MMAP_H
+#define MMAP_H
+
+#include "copyright.h"
+#include "list.h"
+
+class AddrSpace;
+class OpenFile;
+class Lock;
+
+// A file mapped into an address space.
+
+class FileMapping {
+  public:
+    FileMapping(AddrSpace *s, int addr, OpenFile *f, int off, int len);
+    ~FileMapping();
+
+    AddrSpace *space;			// Where it is mapped,
+    int vaddr;				// and at what address
+    int numPages;			// How many pages it takes
+    OpenFile *file;			// The file, from byte
+    int offset;				// "offset" on,
+    int length;				// "length" bytes of it
+    int *frames;			// The frame of each page, or -1 if
+					// it hasn't been read in
+    int hand;				// The next page to take out, if
+					// the frame is needed
+};
+
+// The following class defines the table of all the mapped files.
+
+class MmapTable {
+  public:
+    MmapTable();
+    ~MmapTable();
+
+    int Map(OpenFile *file, int offset, int length);
+					// Map "length" bytes of "file" into
+					// the current address space; return
+					// where, or 0 if there isn't room
+    int Unmap(int vaddr);		// Write back and unmap the mapping
+					// at "vaddr"; 0, or -1 if none
+    bool PageIn(AddrSpace *space, int vaddr);
+					// Read in the page "vaddr" is on;
+					// FALSE if it isn't mapped, or
+					// there is no frame for it
+    void CloseFile(OpenFile *file);	// It is being closed; unmap it
+					// wherever it is mapped
+    void UnmapAll(AddrSpace *space);	// It is going away; unmap them all
+
+  private:
+    FileMapping *Find(AddrSpace *space, int vaddr);
+					// The mapping "vaddr" is in, or NULL
+    void Remove(FileMapping *mapping);	// Write it back, and forget it
+    void PageOut(FileMapping *mapping, int page);
+					// Write back a page, if it was
+					// written, and free its frame
+    bool Evict();			// Page out some page; FALSE if no
+					// mapping has one in memory
+    int FileBytes(FileMapping *mapping, int page, int *position);
+					// Which bytes of the file a page holds
+
+    List<FileMapping *> *mappings;
+    Lock *lock;				// Held while paging, so a page is
+					// never read while it is written
+};
+
+#endif // MMAP_H
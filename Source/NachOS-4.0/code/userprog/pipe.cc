@@ -0,0 +1,417 @@
+// pipe.cc
+//	Routines to move bytes through pipes, and to keep track of the
+//	open ends.
+//
+//	PipeBuffer::Read and PipeBuffer::Write are a monitor: the lock
+//	is held while the buffer is used, and the conditions are waited
+//	on when there is nothing to read, or no room to write.  The
+//	user's pages are found with AddrSpace::Translate, once per run
+//	of bytes.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "main.h"
+#include "pipe.h"
+#include "synch.h"
+
+//----------------------------------------------------------------------
+// PipeBuffer::PipeBuffer
+// 	Initialize an empty pipe, with no ends open yet.
+//----------------------------------------------------------------------
+
+PipeBuffer::PipeBuffer()
+{
+    buffer = new char[PipeSize];
+    head = 0;
+    count = 0;
+    readers = 0;
+    writers = 0;
+    lock = new Lock("pipe");
+    notEmpty = new Condition("pipe not empty");
+    notFull = new Condition("pipe not full");
+    pollers = new WaitQueue();
+    users = 0;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::~PipeBuffer
+// 	De-allocate a pipe; nobody may be using it.
+//----------------------------------------------------------------------
+
+PipeBuffer::~PipeBuffer()
+{
+    delete [] buffer;
+    delete lock;
+    delete notEmpty;
+    delete notFull;
+    delete pollers;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Open, PipeBuffer::Close
+// 	Count the ends open for reading and writing.  Closing one wakes
+//	everybody, so that a reader can see end of file and a writer
+//	that nobody will read what it writes.
+//
+//	"writeEnd" -- is it the writing end?
+//----------------------------------------------------------------------
+
+void
+PipeBuffer::Open(bool writeEnd)
+{
+    lock->Acquire();
+    if (writeEnd)
+	writers++;
+    else
+	readers++;
+    lock->Release();
+}
+
+void
+PipeBuffer::Close(bool writeEnd)
+{
+    lock->Acquire();
+    if (writeEnd)
+	writers--;
+    else
+	readers--;
+    notEmpty->Broadcast(lock);
+    notFull->Broadcast(lock);
+    pollers->Wake();
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::CopyRun
+// 	Copy bytes between the pipe and the current user program's
+//	memory at "vaddr": as many as are contiguous both in the ring
+//	buffer and in the page "vaddr" is on, up to "size".  Return how
+//	many were copied, or -1 if "vaddr" is not a valid address.
+//
+//	The lock must be held, and there must be data (to read) or room
+//	(to write).
+//
+//	"toPipe" -- are we writing into the pipe?
+//----------------------------------------------------------------------
+
+int
+PipeBuffer::CopyRun(int vaddr, int size, bool toPipe)
+{
+    AddrSpace *space = kernel->currentThread->space;
+    unsigned int paddr;
+    int pos, n;
+
+    if (space->Translate(vaddr, &paddr, !toPipe) != NoException)
+	return -1;
+    n = min(size, PageSize - vaddr % PageSize);
+    if (toPipe) {
+	pos = (head + count) % PipeSize;
+	n = min(n, min(PipeSize - count, PipeSize - pos));
+	bcopy(&kernel->machine->mainMemory[paddr], &buffer[pos], n);
+	count += n;
+    } else {
+	n = min(n, min(count, PipeSize - head));
+	bcopy(&buffer[head], &kernel->machine->mainMemory[paddr], n);
+	head = (head + n) % PipeSize;
+	count -= n;
+    }
+    return n;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Read
+// 	Read up to "size" bytes into the user's buffer at "vaddr".  If
+//	the pipe is empty, wait until there is something in it, and
+//	return what there is then -- a short read, as from the console.
+//
+//	Return how many bytes were read: 0 if the pipe is empty and no
+//	one has it open for writing, -1 if "vaddr" is bad.
+//----------------------------------------------------------------------
+
+int
+PipeBuffer::Read(int vaddr, int size)
+{
+    int done = 0, n;
+
+    lock->Acquire();
+    while (count == 0 && writers > 0)
+	notEmpty->Wait(lock);
+    while (done < size && count > 0) {
+	n = CopyRun(vaddr + done, size - done, FALSE);
+	if (n < 0) {
+	    if (done == 0)
+		done = -1;
+	    break;
+	}
+	done += n;
+    }
+    if (done > 0) {
+	notFull->Broadcast(lock);
+	pollers->Wake();
+    }
+    lock->Release();
+
+    DEBUG(dbgSys, "Pipe read " << done << " of " << size);
+    return done;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Write
+// 	Write "size" bytes from the user's buffer at "vaddr", waiting
+//	for room whenever the pipe is full.
+//
+//	Return how many were written: fewer than "size" only if the last
+//	reader went away, or "vaddr" is bad.  -1 if nothing could be.
+//----------------------------------------------------------------------
+
+int
+PipeBuffer::Write(int vaddr, int size)
+{
+    int done = 0, n;
+
+    lock->Acquire();
+    while (done < size) {
+	while (count == PipeSize && readers > 0)
+	    notFull->Wait(lock);
+	if (readers == 0)
+	    break;
+	n = CopyRun(vaddr + done, size - done, TRUE);
+	if (n < 0)
+	    break;
+	done += n;
+	notEmpty->Broadcast(lock);
+	pollers->Wake();
+    }
+    lock->Release();
+
+    DEBUG(dbgSys, "Pipe wrote " << done << " of " << size);
+    if (done == 0 && size > 0)
+	return -1;
+    return done;
+}
+
+//----------------------------------------------------------------------
+// PipeTable::PipeTable
+// 	Initialize the table of pipe ends; none are open.
+//----------------------------------------------------------------------
+
+PipeTable::PipeTable()
+{
+    for (int i = 0; i < MaxPipeEnds; i++) {
+	pipes[i] = NULL;
+	isWrite[i] = FALSE;
+	refs[i] = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// PipeTable::~PipeTable
+// 	Nachos is halting; throw away the pipes that are left.
+//----------------------------------------------------------------------
+
+PipeTable::~PipeTable()
+{
+    for (int i = 0; i < MaxPipeEnds; i++) {
+	PipeBuffer *pipe = pipes[i];
+
+	if (pipe == NULL)
+	    continue;
+	for (int j = i; j < MaxPipeEnds; j++) {	// its other end, too
+	    if (pipes[j] == pipe)
+		pipes[j] = NULL;
+	}
+	delete pipe;
+    }
+}
+
+//----------------------------------------------------------------------
+// PipeTable::Allocate
+// 	Put an end of "pipe" in a free slot, open by one process.
+//	Return the slot, or -1 if there is none.
+//----------------------------------------------------------------------
+
+int
+PipeTable::Allocate(PipeBuffer *pipe, bool writeEnd)
+{
+    for (int i = 0; i < MaxPipeEnds; i++) {
+	if (pipes[i] == NULL) {
+	    pipes[i] = pipe;
+	    isWrite[i] = writeEnd;
+	    refs[i] = 1;
+	    pipe->Open(writeEnd);
+	    return i;
+	}
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// PipeTable::Create
+// 	Make a new pipe, open at both ends by the current process.
+//	Return FALSE if there aren't two free ends.
+//
+//	"readId", "writeId" -- where to put the open file ids of the ends
+//----------------------------------------------------------------------
+
+bool
+PipeTable::Create(int *readId, int *writeId)
+{
+    PipeBuffer *pipe = new PipeBuffer();
+    int readEnd, writeEnd;
+
+    readEnd = Allocate(pipe, FALSE);
+    if (readEnd < 0) {
+	delete pipe;
+	return FALSE;
+    }
+    writeEnd = Allocate(pipe, TRUE);
+    if (writeEnd < 0) {
+	(void) Close(FirstPipeId + readEnd);
+	return FALSE;
+    }
+
+    *readId = FirstPipeId + readEnd;
+    *writeId = FirstPipeId + writeEnd;
+    DEBUG(dbgSys, "Pipe " << *readId << " <- " << *writeId);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// PipeTable::IsPipe
+// 	Return TRUE if "id" names an open pipe end.
+//----------------------------------------------------------------------
+
+bool
+PipeTable::IsPipe(int id)
+{
+    return id >= FirstPipeId && id < FirstPipeId + MaxPipeEnds
+		&& pipes[id - FirstPipeId] != NULL;
+}
+
+//----------------------------------------------------------------------
+// PipeTable::Read, PipeTable::Write
+// 	Read from, or write to, the pipe end "id".  Return -1 if it is
+//	not the right end, otherwise as PipeBuffer::Read and
+//	PipeBuffer::Write.
+//
+//	The thread may wait in the pipe while another one closes the
+//	ends, so the pipe is only deleted once it has left.
+//----------------------------------------------------------------------
+
+int
+PipeTable::Read(int id, int vaddr, int size)
+{
+    PipeBuffer *pipe;
+    int n;
+
+    if (!IsReadEnd(id))
+	return -1;
+    pipe = pipes[id - FirstPipeId];
+    pipe->users++;
+    n = pipe->Read(vaddr, size);
+    Leave(pipe);
+    return n;
+}
+
+int
+PipeTable::Write(int id, int vaddr, int size)
+{
+    PipeBuffer *pipe;
+    int n;
+
+    if (!IsWriteEnd(id))
+	return -1;
+    pipe = pipes[id - FirstPipeId];
+    pipe->users++;
+    n = pipe->Write(vaddr, size);
+    Leave(pipe);
+    return n;
+}
+
+//----------------------------------------------------------------------
+// PipeTable::IsReady
+// 	Return TRUE if the pipe end "id" can be read (or, for a write
+//	end, written) without waiting.  Interrupts should be off, or the
+//	answer may be out of date.
+//----------------------------------------------------------------------
+
+bool
+PipeTable::IsReady(int id)
+{
+    ASSERT(IsPipe(id));
+    if (isWrite[id - FirstPipeId])
+	return pipes[id - FirstPipeId]->CanWrite();
+    return pipes[id - FirstPipeId]->CanRead();
+}
+
+//----------------------------------------------------------------------
+// PipeTable::Pollers
+// 	Return the wait queue of the pipe of end "id".
+//----------------------------------------------------------------------
+
+WaitQueue *
+PipeTable::Pollers(int id)
+{
+    ASSERT(IsPipe(id));
+    return pipes[id - FirstPipeId]->pollers;
+}
+
+//----------------------------------------------------------------------
+// PipeTable::Dup
+// 	Note that one more process has the end "id" open, one that
+//	Exec gave it to.
+//----------------------------------------------------------------------
+
+void
+PipeTable::Dup(int id)
+{
+    ASSERT(IsPipe(id));
+    refs[id - FirstPipeId]++;
+}
+
+//----------------------------------------------------------------------
+// PipeTable::Close
+// 	One process is done with the end "id".  When none has it open,
+//	the end is closed; when both ends are, and no thread is still
+//	reading or writing, the pipe goes away.
+//
+//	Return FALSE if "id" is not an open pipe end.
+//----------------------------------------------------------------------
+
+bool
+PipeTable::Close(int id)
+{
+    int i = id - FirstPipeId;
+    PipeBuffer *pipe;
+
+    if (!IsPipe(id))
+	return FALSE;
+    if (--refs[i] > 0)
+	return TRUE;
+
+    pipe = pipes[i];
+    pipes[i] = NULL;
+    pipe->users++;			// Close may wait for the lock
+    pipe->Close(isWrite[i]);
+    Leave(pipe);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// PipeTable::Leave
+// 	A thread is done with "pipe".  If it was the last one in it, and
+//	both ends are closed, delete the pipe.
+//----------------------------------------------------------------------
+
+void
+PipeTable::Leave(PipeBuffer *pipe)
+{
+    pipe->users--;
+    if (pipe->Unused()) {
+	pipe->pollers->Release();	// another thread may be polling an
+	delete pipe;			// end that was closed
+    }
+}
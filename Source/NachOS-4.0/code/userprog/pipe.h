@@ -0,0 +1,119 @@
+// pipe.h
+//	Data structures for pipes: one-way channels that let one user
+//	program stream bytes to another, as in "a | b" at the shell.
+//
+//	A pipe is a bounded ring buffer in the kernel.  A writer that
+//	finds it full waits for a reader to make room, and a reader that
+//	finds it empty waits for a writer, or for the last writer to
+//	close its end (end of file).  Bytes are copied straight between
+//	the buffer and the user's pages, a run of contiguous bytes at a
+//	time, rather than one byte per ReadMem/WriteMem.
+//
+//	The two ends of a pipe are open file ids, like the ones Open
+//	returns, but taken from a range past the file table.  An end
+//	belongs to the process that made the pipe, and is shared with
+//	every process it was given to by Exec; no other process can use
+//	it (see ProcessTable::Redirect).  The pipe sees end of file once
+//	all of them have closed the write end, or exited.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PIPE_H
+#define PIPE_H
+
+#include "copyright.h"
+#include "machine.h"
+
+class Lock;
+class Condition;
+class WaitQueue;
+
+#define PipeSize	(4 * PageSize)	// bytes a pipe can hold
+#define MaxPipeEnds	32		// pipe ends open at once
+#define FirstPipeId	32		// the open file id of pipe end 0
+
+// The following class defines a pipe: the buffer, and the readers
+// and writers that may still use it.  (The Pipe system call has
+// the shorter name.)
+
+class PipeBuffer {
+  public:
+    PipeBuffer();
+    ~PipeBuffer();
+
+    int Read(int vaddr, int size);	// Copy up to "size" bytes to user
+					// memory at "vaddr"; 0 at end of
+					// file, -1 for a bad address
+    int Write(int vaddr, int size);	// Copy "size" bytes from user
+					// memory; -1 if nobody can read
+					// them, or for a bad address
+
+    void Open(bool writeEnd);		// Another end has been opened
+    void Close(bool writeEnd);		// An end has been closed
+    bool Unused() { return readers == 0 && writers == 0 && users == 0; }
+
+    bool CanRead() { return count > 0 || writers == 0; }
+    bool CanWrite() { return count < PipeSize || readers == 0; }
+					// Would Read or Write return right
+					// away?  (A hint, unless interrupts
+					// are off)
+    WaitQueue *pollers;			// Threads in Poll; woken whenever
+					// bytes go in or out, or an end
+					// closes
+    int users;				// Threads in Read, Write or Close;
+					// it can't go away under them
+
+  private:
+    int CopyRun(int vaddr, int size, bool toPipe);
+					// Copy as much as is contiguous in
+					// both the buffer and the user page
+
+    char *buffer;			// The bytes in the pipe, from
+    int head;				// buffer[head], wrapping around
+    int count;				// How many there are
+    int readers, writers;		// Ends open for reading, writing
+    Lock *lock;				// Held while using the above
+    Condition *notEmpty;		// Signalled when bytes come in,
+    Condition *notFull;			// or go out, or an end closes
+};
+
+// The open pipe ends.  End "i" has the open file id FirstPipeId + i.
+
+class PipeTable {
+  public:
+    PipeTable();
+    ~PipeTable();
+
+    bool Create(int *readId, int *writeId);
+					// Make a pipe, and return the ids
+					// of its ends; FALSE if there is
+					// no room
+    bool IsPipe(int id);		// Is "id" an open pipe end?
+    bool IsReadEnd(int id) { return IsPipe(id) && !isWrite[id - FirstPipeId]; }
+    bool IsWriteEnd(int id) { return IsPipe(id) && isWrite[id - FirstPipeId]; }
+
+    int Read(int id, int vaddr, int size);
+    int Write(int id, int vaddr, int size);
+					// As PipeBuffer::Read and ::Write;
+					// -1 if "id" is the wrong end
+    bool IsReady(int id);		// Could the end be read (or written)
+					// without waiting?
+    WaitQueue *Pollers(int id);		// Who is polling its pipe
+    void Dup(int id);			// Another process has the end "id"
+    bool Close(int id);			// One fewer has it; FALSE if it
+					// wasn't open
+
+  private:
+    int Allocate(PipeBuffer *pipe, bool writeEnd);
+					// Find a free end; -1 if none
+    void Leave(PipeBuffer *pipe);	// A thread is done using "pipe";
+					// delete it, if it was the last
+
+    PipeBuffer *pipes[MaxPipeEnds];	// The pipe of each end, or NULL
+    bool isWrite[MaxPipeEnds];		// Is it the writing end?
+    int refs[MaxPipeEnds];		// How many processes have it open
+};
+
+#endif // PIPE_H
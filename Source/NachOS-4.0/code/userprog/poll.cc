@@ -0,0 +1,127 @@
+// poll.cc
+//	Routines to find out whether open files are ready, and to wait
+//	until one of them is.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "main.h"
+#include "synchconsole.h"
+#include "post.h"
+#include "poll.h"
+#include "addrspace.h"
+#include "ptable.h"
+#include "pipe.h"
+#include "syscall.h"	// after console.h: it #defines ConsoleInput
+			// and ConsoleOutput, which are classes there
+
+//----------------------------------------------------------------------
+// Ready
+// 	Return what can be done with the open file "id" without waiting
+//	-- PollIn, PollOut -- or PollInvalid if it is not open.
+//	Interrupts must be off, or the answer may be out of date.
+//----------------------------------------------------------------------
+
+static int
+Ready(int id)
+{
+    if (kernel->pipes->IsPipe(id)) {
+	if (!kernel->pipes->IsReady(id))
+	    return 0;
+	return kernel->pipes->IsWriteEnd(id) ? PollOut : PollIn;
+    }
+    if (id == ConsoleInput)
+	return kernel->synchConsoleIn->CanRead() ? PollIn : 0;
+    if (id == ConsoleOutput)
+	return PollOut;
+    if (id >= MailBoxId(0) && id < MailBoxId(kernel->postOfficeIn->NumBoxes()))
+	return kernel->postOfficeIn->Box(id - MailBoxId(0))->IsEmpty()
+							? 0 : PollIn;
+    if (id >= 2 && id < 20 && kernel->fileSystem->ListFile[id] != NULL)
+	return PollIn | PollOut;
+    return PollInvalid;
+}
+
+//----------------------------------------------------------------------
+// Pollers
+// 	Return the wait queue of the open file "id", or NULL if it never
+//	makes anybody wait (or is not open).
+//----------------------------------------------------------------------
+
+static WaitQueue *
+Pollers(int id)
+{
+    if (kernel->pipes->IsPipe(id))
+	return kernel->pipes->Pollers(id);
+    if (id == ConsoleInput)
+	return kernel->synchConsoleIn->pollers;
+    if (id >= MailBoxId(0) && id < MailBoxId(kernel->postOfficeIn->NumBoxes()))
+	return kernel->postOfficeIn->Box(id - MailBoxId(0))->pollers;
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// PollFiles
+// 	Wait until one of the "count" open files in the PollFd array at
+//	"fdsAddr" is ready for what its "events" asks, or "timeout"
+//	ticks have gone by; set the "revents" of each to what it is
+//	ready for.  The ids are the current program's: ConsoleInput may
+//	be a pipe end (see ProcessTable::Redirect).
+//
+//	Return how many are ready, 0 if the timeout is up, EINVAL for a
+//	bad count or timeout, or EFAULT for a bad address.
+//----------------------------------------------------------------------
+
+int
+PollFiles(int fdsAddr, int count, int timeout)
+{
+    AddrSpace *space = kernel->currentThread->space;
+    int fds[3 * MaxPollFds];		// as the program has them
+    int ids[MaxPollFds], events[MaxPollFds], revents[MaxPollFds];
+    Poller *poller;
+    IntStatus oldLevel;
+    int ready;
+
+    if (count < 0 || count > MaxPollFds || timeout < -1)
+	return EINVAL;
+    if (!space->Copy(fdsAddr, (char *) fds, count * sizeof(PollFd), FALSE))
+	return EFAULT;
+    for (int i = 0; i < count; i++) {
+	ids[i] = kernel->processTable->Redirect(WordToHost(fds[3 * i]));
+	events[i] = WordToHost(fds[3 * i + 1]);
+    }
+
+    poller = new Poller();
+    if (timeout > 0)
+	poller->SetTimeout(timeout);
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    for (;;) {
+	ready = 0;
+	for (int i = 0; i < count; i++) {
+	    revents[i] = Ready(ids[i]) & (events[i] | PollInvalid);
+	    if (revents[i] != 0)
+		ready++;
+	}
+	if (ready > 0 || timeout == 0 || poller->TimedOut())
+	    break;
+
+	for (int i = 0; i < count; i++) {
+	    WaitQueue *queue = Pollers(ids[i]);
+
+	    if (queue != NULL)
+		poller->Add(queue);
+	}
+	poller->Sleep();
+    }
+    (void) kernel->interrupt->SetLevel(oldLevel);
+    poller->Done();
+
+    DEBUG(dbgSys, "Poll: " << ready << " of " << count << " ready");
+    for (int i = 0; i < count; i++)
+	fds[3 * i + 2] = WordToMachine((unsigned int) revents[i]);
+    if (!space->Copy(fdsAddr, (char *) fds, count * sizeof(PollFd), TRUE))
+	return EFAULT;
+    return ready;
+}
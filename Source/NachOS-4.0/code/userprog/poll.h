@@ -0,0 +1,27 @@
+// poll.h
+//	The Poll system call: waiting for any of several open files --
+//	the console, pipe ends, mailboxes -- to be ready to read or
+//	write.
+//
+//	Each of those objects has a wait queue (see synch.h), that it
+//	wakes whenever it may have become ready.  Poll looks at the
+//	objects with interrupts off; if none is ready, it sleeps on all
+//	of their queues at once, and looks again when woken.  So a
+//	program waiting for input from several places doesn't have to
+//	spin, or pick one to block on.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef POLL_H
+#define POLL_H
+
+#include "copyright.h"
+
+// Poll the "count" open files described at "fdsAddr" in the current
+// program, for up to "timeout" ticks (see Poll in syscall.h).
+
+extern int PollFiles(int fdsAddr, int count, int timeout);
+
+#endif // POLL_H
@@ -0,0 +1,459 @@
+// profile.cc
+//	Routines to sample where user programs are, and to print where
+//	they spent their time.
+//
+//	The symbol tables are read from MIPS ECOFF files, as made by the
+//	cross-compiler: the "symbolic header" the file header points to
+//	gives where the file descriptors, symbols and strings are.  The
+//	functions are the symbols of type stProc or stStaticProc, both
+//	the local ones (whose names are in the strings of the source
+//	file they came from) and the external ones.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "main.h"
+#include "profile.h"
+#include "ptable.h"
+
+#define ECOFFMagic	0x0162		// A little-endian MIPS executable
+#define SymbolicMagic	0x7009		// The symbolic header
+
+#define stProc		6		// Symbol types of functions
+#define stStaticProc	14
+
+// Words of the symbolic header, after its magic number and version.
+
+#define HdrSymOffset	8		// Where the local symbols are
+#define HdrSsOffset	14		// Where their strings are
+#define HdrSsExtOffset	16		// Where the external symbols' strings are
+#define HdrFdMax	17		// How many file descriptors there are,
+#define HdrFdOffset	18		// and where
+#define HdrExtMax	21		// How many external symbols there are,
+#define HdrExtOffset	22		// and where
+
+#define FdSize		72		// Bytes in a file descriptor,
+#define SymSize		12		// a local symbol,
+#define ExtSize		16		// and an external one
+
+//----------------------------------------------------------------------
+// GetWord
+// 	Set "value" to the word "offset" bytes into a COFF file of "size"
+//	bytes, in "contents".  Return FALSE if it is past the end.
+//----------------------------------------------------------------------
+
+static bool
+GetWord(char *contents, int size, int offset, int *value)
+{
+    unsigned int word;
+
+    if (offset < 0 || offset > size - 4)
+	return FALSE;
+    bcopy(&contents[offset], (char *) &word, 4);
+    *value = WordToHost(word);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// GetName
+// 	Return the string "offset" bytes into a COFF file, or NULL if
+//	it isn't all in the file.
+//----------------------------------------------------------------------
+
+static char *
+GetName(char *contents, int size, int offset)
+{
+    if (offset < 0 || offset >= size
+	    || memchr(&contents[offset], '\0', size - offset) == NULL)
+	return NULL;
+    return &contents[offset];
+}
+
+//----------------------------------------------------------------------
+// CompareSymbols
+// 	Order two functions by address, for qsort.
+//----------------------------------------------------------------------
+
+static int
+CompareSymbols(const void *a, const void *b)
+{
+    unsigned int x = ((ProfileSymbol *) a)->addr;
+    unsigned int y = ((ProfileSymbol *) b)->addr;
+
+    return (x < y) ? -1 : (x > y);
+}
+
+//----------------------------------------------------------------------
+// SymbolTable::SymbolTable
+// 	Read the functions of a program from its COFF file.  If the
+//	file can't be read, or isn't a MIPS COFF file, the table is
+//	left empty.
+//
+//	"coffFileName" -- the UNIX file to read
+//----------------------------------------------------------------------
+
+SymbolTable::SymbolTable(char *coffFileName)
+{
+    int fd = OpenForReadWrite(coffFileName, FALSE);
+    int size, symPtr, hdr[HdrExtOffset + 1];
+    int issBase, isymBase, csym, iss, value, bits;
+    unsigned short magic;
+    char *name;
+
+    contents = NULL;
+    symbols = NULL;
+    numSymbols = maxSymbols = 0;
+    if (fd < 0)
+	return;
+    Lseek(fd, 0, 2);
+    size = Tell(fd);
+    Lseek(fd, 0, 0);
+    contents = new char[size + 1];
+    Read(fd, contents, size);
+    Close(fd);
+
+    if (size < 2)
+	return;
+    bcopy(contents, (char *) &magic, 2);
+    if (ShortToHost(magic) != ECOFFMagic || !GetWord(contents, size, 8, &symPtr)
+	    || symPtr < 0 || symPtr > size - 2)
+	return;
+    bcopy(&contents[symPtr], (char *) &magic, 2);
+    if (ShortToHost(magic) != SymbolicMagic)
+	return;
+    for (int i = 0; i <= HdrExtOffset; i++) {
+	if (!GetWord(contents, size, symPtr + 4 + 4 * i, &hdr[i]))
+	    return;
+    }
+
+    for (int f = 0; f < hdr[HdrFdMax]; f++) {
+	int fdr = hdr[HdrFdOffset] + f * FdSize;
+
+	if (!GetWord(contents, size, fdr + 8, &issBase)
+		|| !GetWord(contents, size, fdr + 16, &isymBase)
+		|| !GetWord(contents, size, fdr + 20, &csym))
+	    break;
+	for (int s = 0; s < csym; s++) {
+	    int sym = hdr[HdrSymOffset] + (isymBase + s) * SymSize;
+
+	    if (!GetWord(contents, size, sym, &iss)
+		    || !GetWord(contents, size, sym + 4, &value)
+		    || !GetWord(contents, size, sym + 8, &bits))
+		break;
+	    if ((bits & 0x3f) != stProc && (bits & 0x3f) != stStaticProc)
+		continue;
+	    name = GetName(contents, size, hdr[HdrSsOffset] + issBase + iss);
+	    if (name != NULL)
+		Add(value, name);
+	}
+    }
+    for (int e = 0; e < hdr[HdrExtMax]; e++) {
+	int ext = hdr[HdrExtOffset] + e * ExtSize;
+
+	if (!GetWord(contents, size, ext + 4, &iss)
+		|| !GetWord(contents, size, ext + 8, &value)
+		|| !GetWord(contents, size, ext + 12, &bits))
+	    break;
+	if ((bits & 0x3f) != stProc)
+	    continue;
+	name = GetName(contents, size, hdr[HdrSsExtOffset] + iss);
+	if (name != NULL)
+	    Add(value, name);
+    }
+
+    // sort by address, and keep one name for each function
+    qsort(symbols, numSymbols, sizeof(ProfileSymbol), CompareSymbols);
+    int kept = 0;
+    for (int i = 0; i < numSymbols; i++) {
+	if (kept == 0 || symbols[kept - 1].addr != symbols[i].addr)
+	    symbols[kept++] = symbols[i];
+    }
+    numSymbols = kept;
+}
+
+//----------------------------------------------------------------------
+// SymbolTable::~SymbolTable
+//----------------------------------------------------------------------
+
+SymbolTable::~SymbolTable()
+{
+    delete [] symbols;
+    delete [] contents;
+}
+
+//----------------------------------------------------------------------
+// SymbolTable::Add
+// 	Add a function to the table, making room if need be.
+//----------------------------------------------------------------------
+
+void
+SymbolTable::Add(int addr, char *name)
+{
+    if (numSymbols == maxSymbols) {
+	ProfileSymbol *bigger;
+
+	maxSymbols = (maxSymbols == 0) ? 64 : 2 * maxSymbols;
+	bigger = new ProfileSymbol[maxSymbols];
+	for (int i = 0; i < numSymbols; i++)
+	    bigger[i] = symbols[i];
+	delete [] symbols;
+	symbols = bigger;
+    }
+    symbols[numSymbols].addr = addr;
+    symbols[numSymbols].name = name;
+    numSymbols++;
+}
+
+//----------------------------------------------------------------------
+// SymbolTable::Find
+// 	Return the index of the function holding "addr": the last one
+//	that starts at or before it.  Return -1 if there is none.
+//----------------------------------------------------------------------
+
+int
+SymbolTable::Find(int addr)
+{
+    int low = 0, high = numSymbols - 1, found = -1;
+
+    while (low <= high) {
+	int mid = (low + high) / 2;
+
+	if ((unsigned int) symbols[mid].addr <= (unsigned int) addr) {
+	    found = mid;
+	    low = mid + 1;
+	} else
+	    high = mid - 1;
+    }
+    return found;
+}
+
+//----------------------------------------------------------------------
+// SymbolTable::Name
+// 	Return the name of function "index", or "??" if it is -1.
+//----------------------------------------------------------------------
+
+char *
+SymbolTable::Name(int index)
+{
+    return (index < 0) ? (char *) "??" : symbols[index].name;
+}
+
+//----------------------------------------------------------------------
+// Profiler::Profiler
+// 	Start profiling the user programs.
+//
+//	"ticks" -- how many ticks of user time between samples
+//	"foldedFileName" -- the UNIX file to write folded stacks to at
+//		halt, or NULL
+//----------------------------------------------------------------------
+
+Profiler::Profiler(int ticks, char *foldedFileName)
+{
+    interval = ticks;
+    nextSample = ticks;
+    foldedFile = foldedFileName;
+    maxSamples = 1024;
+    samples = new ProfileSample[maxSamples];
+    numSamples = numDropped = numPrograms = 0;
+    lastPid = lastProgram = -1;
+}
+
+//----------------------------------------------------------------------
+// Profiler::~Profiler
+//----------------------------------------------------------------------
+
+Profiler::~Profiler()
+{
+    delete [] samples;
+    for (int i = 0; i < numPrograms; i++)
+	delete [] programs[i];
+}
+
+//----------------------------------------------------------------------
+// Profiler::Tick
+// 	Called after each user instruction.  If "interval" ticks of user
+//	time have gone by since the last sample, note the PC and r31 of
+//	the current thread.
+//----------------------------------------------------------------------
+
+void
+Profiler::Tick()
+{
+    ProfileSample *s;
+    int program;
+
+    if (kernel->stats->userTicks < nextSample)
+	return;
+    nextSample = kernel->stats->userTicks + interval;
+
+    program = Program();
+    if (program < 0) {
+	numDropped++;
+	return;
+    }
+    if (numSamples == maxSamples) {
+	ProfileSample *bigger = new ProfileSample[2 * maxSamples];
+
+	for (int i = 0; i < numSamples; i++)
+	    bigger[i] = samples[i];
+	delete [] samples;
+	samples = bigger;
+	maxSamples *= 2;
+    }
+    s = &samples[numSamples++];
+    s->pc = kernel->machine->ReadRegister(PCReg);
+    s->returnAddr = kernel->machine->ReadRegister(RetAddrReg);
+    s->program = program;
+}
+
+//----------------------------------------------------------------------
+// Profiler::Program
+// 	Return which of "programs" the current process is running,
+//	adding it if it is new.  Return -1 if there is no room for it.
+//----------------------------------------------------------------------
+
+int
+Profiler::Program()
+{
+    int pid = kernel->currentThread->processId;
+    PCB *pcb;
+    char *name;
+
+    if (pid == lastPid)
+	return lastProgram;
+    pcb = kernel->processTable->Lookup(pid);
+    name = (pcb == NULL) ? (char *) "??" : pcb->name;
+
+    lastPid = pid;
+    for (lastProgram = 0; lastProgram < numPrograms; lastProgram++) {
+	if (strcmp(programs[lastProgram], name) == 0)
+	    return lastProgram;
+    }
+    if (numPrograms == MaxProfiledPrograms) {
+	lastProgram = -1;
+	return -1;
+    }
+    programs[numPrograms] = new char[strlen(name) + 1];
+    strcpy(programs[numPrograms], name);
+    return numPrograms++;
+}
+
+//----------------------------------------------------------------------
+// Profiler::Print
+// 	Print, for each program that was sampled, how many samples were
+//	in each of its functions, most first, and who those functions
+//	were called from.
+//
+//	The caller of a function is taken to be the function r31 points
+//	into.  That is only right until the function calls another, so
+//	a sample where r31 points back into the function itself -- it
+//	has made a call, and returned -- doesn't say who called it.
+//
+//	If a UNIX file was given for them, the same counts are written
+//	to it as folded stacks: "program;caller;function count", or
+//	"program;function count" when the caller isn't known.
+//----------------------------------------------------------------------
+
+void
+Profiler::Print()
+{
+    int fd = (foldedFile == NULL) ? -1 : OpenForWrite(foldedFile);
+    char line[200];
+
+    cout << "\nProfile: " << numSamples << " samples, one every "
+	 << interval << " user ticks";
+    if (numDropped > 0)
+	cout << ", " << numDropped << " dropped";
+    cout << "\n";
+
+    for (int p = 0; p < numPrograms; p++) {
+	char *coffName = new char[strlen(programs[p]) + 6];
+	int n, total = 0, *flat, *calls;
+	bool *printed;
+	SymbolTable *symbols;
+
+	sprintf(coffName, "%s.coff", programs[p]);
+	symbols = new SymbolTable(coffName);
+
+	// function i is counted in slot i + 1; slot 0 is for unknown PCs
+	n = symbols->NumSymbols() + 1;
+	flat = new int[n];
+	calls = new int[n * n];
+	printed = new bool[n];
+	bzero(flat, n * sizeof(int));
+	bzero(calls, n * n * sizeof(int));
+	for (int i = 0; i < numSamples; i++) {
+	    if (samples[i].program != p)
+		continue;
+	    int f = symbols->Find(samples[i].pc) + 1;
+	    int c = symbols->Find(samples[i].returnAddr) + 1;
+
+	    flat[f]++;
+	    calls[c * n + f]++;
+	    total++;
+	}
+
+	cout << "\n" << programs[p] << ": " << total << " samples";
+	if (symbols->IsEmpty())
+	    cout << " (no symbols in " << coffName << ")";
+	cout << "\n  %  samples  function\n";
+	for (int i = 0; i < n; i++)
+	    printed[i] = (flat[i] == 0);
+	for (;;) {
+	    int f = -1;
+
+	    for (int i = 0; i < n; i++) {
+		if (!printed[i] && (f < 0 || flat[i] > flat[f]))
+		    f = i;
+	    }
+	    if (f < 0)
+		break;
+	    printed[f] = TRUE;
+	    cout << "  " << flat[f] * 100 / total << "%  " << flat[f] << "  "
+		 << symbols->Name(f - 1) << "\n";
+	}
+
+	cout << "Called from:\n";
+	for (int f = 1; f < n; f++) {
+	    bool any = FALSE;
+
+	    for (int c = 1; c < n; c++) {
+		if (c == f || calls[c * n + f] == 0)
+		    continue;
+		if (!any)
+		    cout << "  " << symbols->Name(f - 1) << ":\n";
+		any = TRUE;
+		cout << "    " << calls[c * n + f] << " from "
+		     << symbols->Name(c - 1) << "\n";
+	    }
+	}
+
+	for (int f = 0; fd >= 0 && f < n; f++) {
+	    int unknown = calls[f] + ((f == 0) ? 0 : calls[f * n + f]);
+
+	    if (unknown > 0) {
+		sprintf(line, "%.60s;%.60s %d\n", programs[p],
+			symbols->Name(f - 1), unknown);
+		WriteFile(fd, line, strlen(line));
+	    }
+	    for (int c = 1; c < n; c++) {
+		if (c == f || calls[c * n + f] == 0)
+		    continue;
+		sprintf(line, "%.60s;%.60s;%.60s %d\n", programs[p],
+			symbols->Name(c - 1), symbols->Name(f - 1),
+			calls[c * n + f]);
+		WriteFile(fd, line, strlen(line));
+	    }
+	}
+
+	delete [] printed;
+	delete [] calls;
+	delete [] flat;
+	delete symbols;
+	delete [] coffName;
+    }
+    if (fd >= 0)
+	Close(fd);
+}
@@ -0,0 +1,94 @@
+// profile.h
+//	Data structures for a sampling profiler of user programs.
+//
+//	Every so many ticks of user time, Machine::Run notes the PC of
+//	the running program, and its return address register (r31),
+//	which -- in a function that hasn't called another yet -- says
+//	who called it.  At halt the samples are mapped back to functions,
+//	using the symbol table in the program's COFF file (the one
+//	coff2noff made its NOFF file from, with ".coff" after its name),
+//	and printed as a flat profile and a call graph.  They can also
+//	be written out as "folded" stacks, one "program;caller;function
+//	count" per line, which flame graph tools take as they are.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "copyright.h"
+
+#define MaxProfiledPrograms	32	// Different programs samples are
+					// kept for; the rest are dropped
+
+// One sample: where a program was, and the address it would return to.
+
+class ProfileSample {
+  public:
+    int pc;				// The PC
+    int returnAddr;			// r31
+    int program;			// Which program, in Profiler::programs
+};
+
+// A function in a program's symbol table.
+
+class ProfileSymbol {
+  public:
+    int addr;				// Where it starts
+    char *name;
+};
+
+// The functions of a program, read from its COFF file.
+
+class SymbolTable {
+  public:
+    SymbolTable(char *coffFileName);	// Read the symbols of a COFF file
+    ~SymbolTable();
+
+    bool IsEmpty() { return numSymbols == 0; }
+					// Couldn't the file be read?
+    int Find(int addr);			// Which function "addr" is in; -1 if
+					// it is before the first
+    char *Name(int index);		// The name of function "index"
+    int NumSymbols() { return numSymbols; }
+
+  private:
+    void Add(int addr, char *name);	// Add a function, if it is new
+
+    char *contents;			// The COFF file, which holds the names
+    ProfileSymbol *symbols;		// Sorted by address
+    int numSymbols, maxSymbols;
+};
+
+// The profiler.  If kernel->profiler is set, Machine::Run calls
+// Tick after each user instruction.
+
+class Profiler {
+  public:
+    Profiler(int ticks, char *foldedFileName);
+					// Sample every "ticks" user ticks;
+					// write folded stacks to the UNIX
+					// file "foldedFileName", if not NULL
+    ~Profiler();
+
+    void Tick();			// Take a sample, if it is time
+    void Print();			// Print the profiles
+
+  private:
+    int Program();			// Which program is running
+
+    int interval;			// User ticks between samples
+    int nextSample;			// When to take the next one
+    char *foldedFile;
+    ProfileSample *samples;
+    int numSamples, maxSamples;
+    int numDropped;			// Samples of programs not kept
+    char *programs[MaxProfiledPrograms];// The programs that were sampled,
+    int numPrograms;			// by file name
+    int lastPid, lastProgram;		// The process last sampled, and
+					// its program
+};
+
+#endif // PROFILE_H
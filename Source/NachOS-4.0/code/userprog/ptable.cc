@@ -0,0 +1,612 @@
+// ptable.cc
+//	Routines to start, wait for and end user processes.
+//
+//	Exec loads the program into a new address space while still
+//	running as the caller, so that a program that can't be loaded
+//	is reported back to it, and then forks a kernel thread to run it.
+//	The time from the Exec to the new program's first instruction
+//	is kept in the statistics, as the spawn latency.
+//
+//	ThreadFork starts another kernel thread in the same address
+//	space, with a stack of its own.  A thread ends by calling
+//	ThreadExit, or by returning from its function; the process ends
+//	when its last thread does.  Exit, from any thread, sets the exit
+//	status and stops all the threads of the process.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "main.h"
+#include "ptable.h"
+#include "synch.h"
+#include "futex.h"
+#include "pipe.h"
+#include "shm.h"
+#include "mmap.h"
+#include "aio.h"
+#include "ring.h"
+#include "systrace.h"
+#include "syscall.h"
+
+//----------------------------------------------------------------------
+// UserThread::UserThread
+// 	Initialize the record of a thread of a user process.
+//
+//	"id" is the thread's id.
+//	"stack" is its stack pointer, from AddrSpace::AllocateStack.
+//----------------------------------------------------------------------
+
+UserThread::UserThread(int id, int stack)
+{
+    tid = id;
+    thread = NULL;
+    startPC = 0;
+    arg = 0;
+    stackTop = stack;
+    exitCode = 0;
+    joined = FALSE;
+    joinSem = new Semaphore("thread join", 0);
+}
+
+//----------------------------------------------------------------------
+// UserThread::~UserThread
+// 	De-allocate the record of a thread.
+//----------------------------------------------------------------------
+
+UserThread::~UserThread()
+{
+    delete joinSem;
+}
+
+//----------------------------------------------------------------------
+// PCB::PCB
+// 	Initialize a process control block, for a process that has not
+//	been given an address space yet.
+//
+//	"id" is the new process's id.
+//	"parentId" is the process that may Join it, or -1.
+//	"fileName" is the program it is going to run.
+//----------------------------------------------------------------------
+
+PCB::PCB(int id, int parentId, char *fileName)
+{
+    pid = id;
+    parent = parentId;
+    strncpy(name, fileName, MAX_FILE_LENGTH);
+    name[MAX_FILE_LENGTH] = '\0';
+    space = NULL;
+    exited = FALSE;
+    exitStatus = 0;
+    joined = FALSE;
+    for (int i = 0; i < MaxUserThreads; i++)
+	threads[i] = NULL;
+    nextTid = 0;
+    numThreads = 0;
+    joinSem = new Semaphore("join", 0);
+    spawnTime = kernel->stats->totalTicks;
+    input = ConsoleInput;
+    output = ConsoleOutput;
+    for (int i = 0; i < MaxPipeEnds; i++)
+	pipeEnds[i] = FALSE;
+}
+
+//----------------------------------------------------------------------
+// PCB::~PCB
+// 	De-allocate a process control block, and the address space, if
+//	the process never got to run.
+//----------------------------------------------------------------------
+
+PCB::~PCB()
+{
+    delete space;
+    for (int i = 0; i < MaxUserThreads; i++)
+	delete threads[i];
+    delete joinSem;
+}
+
+//----------------------------------------------------------------------
+// PCB::AddThread
+// 	Make a record for a new thread of the process, and return it;
+//	NULL if every slot is taken.  An empty slot is used if there is
+//	one; failing that, an exited thread nobody is waiting for is
+//	forgotten, to make room.
+//
+//	"stack" is the new thread's stack pointer.
+//----------------------------------------------------------------------
+
+UserThread *
+PCB::AddThread(int stack)
+{
+    int slot, tries;
+
+    for (tries = 0; tries < 2 * MaxUserThreads; tries++, nextTid++) {
+	slot = nextTid % MaxUserThreads;
+	if (tries >= MaxUserThreads && threads[slot]->thread == NULL
+				    && !threads[slot]->joined)
+	    RemoveThread(threads[slot]);
+	if (threads[slot] == NULL) {
+	    threads[slot] = new UserThread(nextTid, stack);
+	    nextTid++;
+	    return threads[slot];
+	}
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// PCB::FindThread
+// 	Return the thread of the process with id "tid", or NULL.
+//----------------------------------------------------------------------
+
+UserThread *
+PCB::FindThread(int tid)
+{
+    UserThread *ut;
+
+    if (tid < 0)
+	return NULL;
+    ut = threads[tid % MaxUserThreads];
+    if (ut == NULL || ut->tid != tid)
+	return NULL;
+    return ut;
+}
+
+//----------------------------------------------------------------------
+// PCB::RemoveThread
+// 	Forget about a thread that has exited.
+//----------------------------------------------------------------------
+
+void
+PCB::RemoveThread(UserThread *ut)
+{
+    threads[ut->tid % MaxUserThreads] = NULL;
+    delete ut;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::ProcessTable
+// 	Initialize an empty process table.
+//----------------------------------------------------------------------
+
+ProcessTable::ProcessTable()
+{
+    for (int i = 0; i < MaxProcesses; i++)
+	table[i] = NULL;
+    nextPid = 0;
+    numRunning = 0;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::~ProcessTable
+// 	Nachos is halting; throw away whatever processes are left.
+//----------------------------------------------------------------------
+
+ProcessTable::~ProcessTable()
+{
+    for (int i = 0; i < MaxProcesses; i++)
+	delete table[i];
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Lookup
+// 	Return the process with id "pid", or NULL if there isn't one.
+//----------------------------------------------------------------------
+
+PCB *
+ProcessTable::Lookup(int pid)
+{
+    PCB *pcb;
+
+    if (pid < 0)
+	return NULL;
+    pcb = table[pid % MaxProcesses];
+    if (pcb == NULL || pcb->pid != pid)
+	return NULL;
+    return pcb;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Redirect
+// 	Return the open file id that "id" stands for in the current
+//	process: ConsoleInput and ConsoleOutput may have been given to
+//	it as the ends of pipes.  Any other id stands for itself, except
+//	that a pipe end the process doesn't have open stands for
+//	nothing (-1), so that it can't be read or written.
+//----------------------------------------------------------------------
+
+int
+ProcessTable::Redirect(int id)
+{
+    PCB *pcb = Lookup(kernel->currentThread->processId);
+
+    if (pcb == NULL)
+	return id;
+    if (id == ConsoleInput)
+	id = pcb->input;
+    else if (id == ConsoleOutput)
+	id = pcb->output;
+    if (id >= FirstPipeId && id < FirstPipeId + MaxPipeEnds
+		&& !pcb->pipeEnds[id - FirstPipeId])
+	return -1;
+    return id;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::AddPipeEnd
+// 	Note that the current process has the pipe end "id" open: Pipe
+//	has just made it.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::AddPipeEnd(int id)
+{
+    PCB *pcb = Lookup(kernel->currentThread->processId);
+
+    ASSERT(kernel->pipes->IsPipe(id));
+    if (pcb != NULL)
+	pcb->pipeEnds[id - FirstPipeId] = TRUE;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::ClosePipeEnd
+// 	Close the pipe end "id" of the current process.  Once it is
+//	closed, ConsoleInput or ConsoleOutput no longer stand for it
+//	either.
+//
+//	Return FALSE if the process doesn't have it open.
+//----------------------------------------------------------------------
+
+bool
+ProcessTable::ClosePipeEnd(int id)
+{
+    PCB *pcb = Lookup(kernel->currentThread->processId);
+
+    if (!kernel->pipes->IsPipe(id))
+	return FALSE;
+    if (pcb != NULL) {
+	if (!pcb->pipeEnds[id - FirstPipeId])
+	    return FALSE;
+	pcb->pipeEnds[id - FirstPipeId] = FALSE;
+    }
+    return kernel->pipes->Close(id);
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Allocate
+// 	Make a PCB for a new process, and put it in the table.  Return
+//	NULL if every slot is taken.
+//
+//	Slots are tried in the order of the ids they would give; an
+//	exited process that nobody can Join is thrown away to make room.
+//----------------------------------------------------------------------
+
+PCB *
+ProcessTable::Allocate(char *fileName, int parentId)
+{
+    for (int tries = 0; tries < MaxProcesses; tries++, nextPid++) {
+	int slot = nextPid % MaxProcesses;
+
+	if (table[slot] != NULL && table[slot]->exited
+				&& table[slot]->parent < 0)
+	    Free(table[slot]);
+	if (table[slot] == NULL) {
+	    table[slot] = new PCB(nextPid, parentId, fileName);
+	    nextPid++;
+	    return table[slot];
+	}
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Free
+// 	Take a process out of the table, and de-allocate it.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Free(PCB *pcb)
+{
+    table[pcb->pid % MaxProcesses] = NULL;
+    delete pcb;
+}
+
+//----------------------------------------------------------------------
+// StartProcess
+// 	The first thing the kernel thread of a new process does: note
+//	how long it took to get here, and jump to the user program.
+//
+//	"pcb" is the new process.
+//----------------------------------------------------------------------
+
+static void
+StartProcess(PCB *pcb)
+{
+    UserThread *ut = pcb->FindThread(kernel->currentThread->threadId);
+
+    kernel->stats->numProcesses++;
+    kernel->stats->spawnTicks += kernel->stats->totalTicks - pcb->spawnTime;
+
+    pcb->space->Execute(0, ut->stackTop);
+    ASSERTNOTREACHED();
+}
+
+//----------------------------------------------------------------------
+// StartUserThread
+// 	The first thing a thread made by ThreadFork does: jump to the
+//	function it is to run.
+//
+//	"ut" is the new thread.
+//----------------------------------------------------------------------
+
+static void
+StartUserThread(UserThread *ut)
+{
+    PCB *pcb = kernel->processTable->Lookup(kernel->currentThread->processId);
+
+    pcb->space->Execute(ut->startPC, ut->stackTop, ut->arg);
+    ASSERTNOTREACHED();
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Exec
+// 	Start a new process running the program in "fileName", as a
+//	child of the current process.  Return its id, or -1 if the
+//	table is full, the program can't be loaded, or "input" or
+//	"output" can't be used for what they are asked to be.
+//
+//	"input", "output" -- what ConsoleInput and ConsoleOutput are to
+//		stand for in the new process, as the current one names
+//		them: the console, or the read and write ends of pipes
+//----------------------------------------------------------------------
+
+int
+ProcessTable::Exec(char *fileName, int input, int output)
+{
+    PCB *pcb;
+    UserThread *ut;
+    int stack;
+
+    input = Redirect(input);
+    output = Redirect(output);
+    if ((input != ConsoleInput && !kernel->pipes->IsReadEnd(input))
+	    || (output != ConsoleOutput && !kernel->pipes->IsWriteEnd(output)))
+	return -1;
+
+    pcb = Allocate(fileName, kernel->currentThread->processId);
+    if (pcb == NULL) {
+	DEBUG(dbgAddr, "Process table full, can't run " << fileName);
+	return -1;
+    }
+    pcb->space = new AddrSpace();
+    if (!pcb->space->Load(fileName)
+		|| (stack = pcb->space->AllocateStack()) < 0) {
+	Free(pcb);
+	return -1;
+    }
+
+    pcb->input = input;
+    pcb->output = output;
+    if (kernel->pipes->IsPipe(input)) {
+	kernel->pipes->Dup(input);
+	pcb->pipeEnds[input - FirstPipeId] = TRUE;
+    }
+    if (kernel->pipes->IsPipe(output)) {
+	kernel->pipes->Dup(output);
+	pcb->pipeEnds[output - FirstPipeId] = TRUE;
+    }
+
+    ut = pcb->AddThread(stack);
+    ut->thread = new Thread(pcb->name);
+    ut->thread->processId = pcb->pid;
+    ut->thread->threadId = ut->tid;
+    pcb->numThreads = 1;
+    numRunning++;
+    ut->thread->Fork((VoidFunctionPtr) StartProcess, (void *) pcb);
+
+    DEBUG(dbgAddr, "Started process " << pcb->pid << ": " << pcb->name);
+    return pcb->pid;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Join
+// 	Wait until the child process "pid" exits, and return its exit
+//	status.  Return -1 if there is no such child.
+//
+//	Once it has been joined, the child is gone from the table.
+//----------------------------------------------------------------------
+
+int
+ProcessTable::Join(int pid)
+{
+    PCB *pcb = Lookup(pid);
+    int status;
+
+    if (pcb == NULL || pcb->parent < 0 || pcb->joined
+		    || pcb->parent != kernel->currentThread->processId)
+	return -1;
+
+    pcb->joined = TRUE;
+    pcb->joinSem->P();
+    status = pcb->exitStatus;
+    Free(pcb);
+    return status;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Exit
+// 	End the current process.  The calling thread ends right away;
+//	the other threads of the process end before they run another
+//	user instruction (see Machine::Run); those asleep in Wait are
+//	woken up to do so.  The process is gone once they all have.
+//
+//	"status" is the exit status.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Exit(int status)
+{
+    PCB *pcb = Lookup(kernel->currentThread->processId);
+
+    ASSERT(pcb != NULL);
+    DEBUG(dbgAddr, "Process " << pcb->pid << " exiting with " << status);
+
+    pcb->exitStatus = status;
+    pcb->space->exiting = TRUE;
+    kernel->futexes->WakeProcess(pcb->pid);
+    ThreadExit(status);
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::EndProcess
+// 	The last thread of a process has finished.  Its memory, I/O
+//	requests, mapped files, shared memory segments, syscall ring and
+//	pipe ends are given back right away (mapped pages written back to their files,
+//	requests being done left to finish on their own); its PCB is
+//	kept, to give the exit status to the parent.  Its children can
+//	no longer be joined by anyone.  If system calls are being traced,
+//	the records of its calls are written out.
+//
+//	Interrupts must be off, so the parent doesn't free the PCB
+//	before the caller is done with it.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::EndProcess(PCB *pcb)
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    DEBUG(dbgAddr, "Process " << pcb->pid << " done, status " << pcb->exitStatus);
+
+    kernel->aio->Forget(pcb->space);
+    kernel->mappings->UnmapAll(pcb->space);	// may wait for the disk,
+						// so before it is "exited"
+    pcb->exited = TRUE;
+    kernel->shm->DetachAll(pcb->space);
+    kernel->rings->Release(pcb->space);
+    if (kernel->syscallTrace != NULL)
+	kernel->syscallTrace->Release(pcb->pid);
+    delete pcb->space;
+    pcb->space = NULL;
+    for (int i = 0; i < MaxPipeEnds; i++) {	// so readers see end of
+	if (pcb->pipeEnds[i]) {			// file, and writers that
+	    pcb->pipeEnds[i] = FALSE;		// nobody is reading
+	    (void) kernel->pipes->Close(FirstPipeId + i);
+	}
+    }
+
+    for (int i = 0; i < MaxProcesses; i++) {
+	if (table[i] != NULL && table[i]->parent == pcb->pid)
+	    table[i]->parent = -1;
+    }
+
+    numRunning--;
+    pcb->joinSem->V();
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::ThreadFork
+// 	Start a new thread in the current process, running the function
+//	at "func", on a stack of its own, with "arg" as its argument.
+//	Return its id, or -1 if there isn't the memory or the room for
+//	another thread.
+//----------------------------------------------------------------------
+
+int
+ProcessTable::ThreadFork(int func, int arg)
+{
+    PCB *pcb = Lookup(kernel->currentThread->processId);
+    UserThread *ut;
+    int stack;
+
+    ASSERT(pcb != NULL);
+    stack = pcb->space->AllocateStack();
+    if (stack < 0)
+	return -1;
+    ut = pcb->AddThread(stack);
+    if (ut == NULL) {
+	pcb->space->FreeStack(stack);
+	return -1;
+    }
+
+    ut->startPC = func;
+    ut->arg = arg;
+    ut->thread = new Thread(pcb->name);
+    ut->thread->processId = pcb->pid;
+    ut->thread->threadId = ut->tid;
+    pcb->numThreads++;
+    ut->thread->Fork((VoidFunctionPtr) StartUserThread, (void *) ut);
+
+    DEBUG(dbgAddr, "Process " << pcb->pid << " started thread " << ut->tid);
+    return ut->tid;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::ThreadJoin
+// 	Wait until the thread "tid" of the current process finishes, and
+//	return its exit code.  Return -1 if there is no such thread, it
+//	is the current one, or another thread is already waiting for it.
+//----------------------------------------------------------------------
+
+int
+ProcessTable::ThreadJoin(int tid)
+{
+    PCB *pcb = Lookup(kernel->currentThread->processId);
+    UserThread *ut;
+    int exitCode;
+
+    ASSERT(pcb != NULL);
+    ut = pcb->FindThread(tid);
+    if (ut == NULL || ut->joined || ut->thread == kernel->currentThread)
+	return -1;
+
+    ut->joined = TRUE;
+    ut->joinSem->P();
+    exitCode = ut->exitCode;
+    pcb->RemoveThread(ut);
+    return exitCode;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::ThreadExit
+// 	End the current thread, giving its stack back to the address
+//	space.  If it is the last thread of its process, the process
+//	ends too; if that was the last process, Nachos halts.
+//
+//	"exitCode" is what ThreadJoin returns for it.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::ThreadExit(int exitCode)
+{
+    Thread *thread = kernel->currentThread;
+    PCB *pcb = Lookup(thread->processId);
+    UserThread *ut;
+
+    ASSERT(pcb != NULL);
+    ut = pcb->FindThread(thread->threadId);
+    ASSERT(ut != NULL);
+    DEBUG(dbgAddr, "Thread " << ut->tid << " of process " << pcb->pid
+		    << " exiting with " << exitCode);
+
+    ut->exitCode = exitCode;
+    ut->thread = NULL;
+    pcb->space->FreeStack(ut->stackTop);
+    thread->space = NULL;		// nothing to save at the next
+					// context switch
+    pcb->numThreads--;
+
+    (void) kernel->interrupt->SetLevel(IntOff);	// no one may free the
+						// records before we finish
+    if (pcb->numThreads == 0) {
+	if (!pcb->space->exiting)
+	    pcb->exitStatus = exitCode;
+	EndProcess(pcb);
+    }
+    ut->joinSem->V();
+    if (numRunning == 0)
+	kernel->interrupt->Halt();
+
+    thread->Finish();
+    ASSERTNOTREACHED();
+}
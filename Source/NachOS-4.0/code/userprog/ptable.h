@@ -0,0 +1,145 @@
+// ptable.h
+//	Data structures to keep track of the user processes in the
+//	system: a process control block (PCB) for each, and the table
+//	of them that Exec, Join and Exit work on.
+//
+//	A process is an address space, plus the kernel threads running
+//	the program in it: the one it started with, and any more it makes
+//	with ThreadFork.  It is named by a process id (its SpaceId, to
+//	user programs), which is never reused, so a stale id can be told
+//	apart from the live process that happens to share its slot.
+//	Threads are numbered the same way within their process.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PTABLE_H
+#define PTABLE_H
+
+#include "copyright.h"
+#include "addrspace.h"
+#include "kernel.h"
+#include "pipe.h"
+
+class Semaphore;
+
+#define MaxProcesses		32	// processes that can exist at once,
+					// including exited ones not yet
+					// joined
+#define MaxUserThreads		16	// the same, for the threads of
+					// one process
+
+// The following class defines what the kernel knows about one of the
+// threads of a user process, beyond its Thread: what it gives back
+// to ThreadJoin.
+
+class UserThread {
+  public:
+    UserThread(int id, int stack);
+    ~UserThread();
+
+    int tid;				// Thread id, within the process
+    Thread *thread;			// Running it; NULL once it exits
+    int startPC;			// The function it runs,
+    int arg;				// and what is passed to it
+    int stackTop;			// Its stack, from AllocateStack
+    int exitCode;			// What it passed to ThreadExit
+    bool joined;			// Is a thread waiting for it?
+    Semaphore *joinSem;			// Signalled when it exits
+};
+
+// The following class defines a "process control block" -- what
+// the kernel knows about one user process.
+
+class PCB {
+  public:
+    PCB(int id, int parentId, char *fileName);
+    ~PCB();
+
+    UserThread *AddThread(int stack);	// Make a record for a new thread;
+					// NULL if there's no room.  One
+					// that has exited, and that nobody
+					// is waiting for, is forgotten
+					// to make room
+    UserThread *FindThread(int tid);	// The thread with id "tid", or NULL
+    void RemoveThread(UserThread *ut);	// Forget about a thread
+
+    int pid;				// Process id
+    int parent;				// Who may Join it; -1 for nobody
+    char name[MAX_FILE_LENGTH + 1];	// The program it runs
+    AddrSpace *space;			// Its memory; NULL once it exits
+    bool exited;			// Have all its threads finished?
+    int exitStatus;			// What it passed to Exit, or what
+					// its last thread passed to ThreadExit
+    bool joined;			// Is its parent waiting for it?
+    UserThread *threads[MaxUserThreads];// Thread "tid" is in slot
+					// tid % MaxUserThreads
+    int nextTid;			// The next thread id to try
+    int numThreads;			// Threads that haven't finished
+    Semaphore *joinSem;			// Signalled when it exits
+    int spawnTime;			// When Exec was called for it
+    int input, output;			// What ConsoleInput and ConsoleOutput
+					// stand for in it: the console, or
+					// the ends of pipes
+    bool pipeEnds[MaxPipeEnds];		// Which pipe ends it has open,
+					// from Pipe or from Exec
+};
+
+// The process table.  A process with id "pid" is kept in slot
+// pid % MaxProcesses, so looking one up takes constant time; ids
+// are handed out in increasing order, skipping any that would
+// land on a slot in use.
+//
+// A process that exits stays in the table until its parent Joins
+// it, to hold its exit status.  If there is no parent to do so
+// (the initial processes, and those whose parent exited first),
+// its slot is reclaimed the next time one is needed.
+
+class ProcessTable {
+  public:
+    ProcessTable();
+    ~ProcessTable();
+
+    int Exec(char *fileName, int input, int output);
+					// Start a process running the program
+					// in "fileName", as a child of the
+					// current one, reading "input" and
+					// writing "output"; return its id,
+					// or -1
+    int Join(int pid);			// Wait for a child to exit, and
+					// return its exit status; -1 if
+					// "pid" is not a child
+    void Exit(int status);		// End the current process; halts
+					// Nachos if it was the last one
+
+    int ThreadFork(int func, int arg);	// Start a thread running "func(arg)"
+					// in the current process; return
+					// its id, or -1
+    int ThreadJoin(int tid);		// Wait for a thread of the current
+					// process to finish, and return its
+					// exit code; -1 if there is none
+    void ThreadExit(int exitCode);	// End the current thread; the
+					// process ends with its last thread
+
+    PCB *Lookup(int pid);		// The process with id "pid", or NULL
+    int Redirect(int id);		// The open file id that "id" stands
+					// for in the current process; -1
+					// for a pipe end it doesn't have
+    void AddPipeEnd(int id);		// The current process has opened
+					// the pipe end "id"
+    bool ClosePipeEnd(int id);		// It closes it; FALSE if it didn't
+					// have it open
+
+  private:
+    PCB *Allocate(char *fileName, int parentId);
+					// Make a PCB in a free slot
+    void Free(PCB *pcb);		// Take it out of the table
+    void EndProcess(PCB *pcb);		// Its last thread has finished
+
+    PCB *table[MaxProcesses];
+    int nextPid;			// The next id to try to hand out
+    int numRunning;			// Processes that haven't exited
+};
+
+#endif // PTABLE_H
@@ -0,0 +1,215 @@
+// ring.cc
+//	Routines to set up the rings of batched system calls, and to do
+//	a batch of the requests in one.
+//
+//	The kernel reaches a ring through its page frames, rather than
+//	the program's page table, since it owns them.  The words in it
+//	are in the simulated machine's byte order.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "main.h"
+#include "ring.h"
+#include "addrspace.h"
+#include "bitmap.h"
+#include "synch.h"
+
+#include <stddef.h>
+
+//----------------------------------------------------------------------
+// ProcessRing::ProcessRing
+// 	Remember that "s" has its ring at "addr", in "pageFrames".
+//----------------------------------------------------------------------
+
+ProcessRing::ProcessRing(AddrSpace *s, int addr, int *pageFrames)
+{
+    space = s;
+    vaddr = addr;
+    frames = pageFrames;
+    lock = new Lock("ring");
+}
+
+//----------------------------------------------------------------------
+// ProcessRing::~ProcessRing
+// 	Give the ring's page frames back; it must have been unmapped.
+//----------------------------------------------------------------------
+
+ProcessRing::~ProcessRing()
+{
+    for (unsigned int i = 0; i < RingPages; i++)
+	kernel->frameMap->Clear(frames[i]);
+    delete [] frames;
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// ProcessRing::Read, ProcessRing::Write
+// 	Get or set the word "offset" bytes into the ring.
+//----------------------------------------------------------------------
+
+int
+ProcessRing::Read(int offset)
+{
+    int paddr = frames[offset / PageSize] * PageSize + offset % PageSize;
+
+    return WordToHost(*(unsigned int *) &kernel->machine->mainMemory[paddr]);
+}
+
+void
+ProcessRing::Write(int offset, int value)
+{
+    int paddr = frames[offset / PageSize] * PageSize + offset % PageSize;
+
+    *(unsigned int *) &kernel->machine->mainMemory[paddr] =
+					WordToMachine((unsigned int) value);
+}
+
+//----------------------------------------------------------------------
+// RingTable::RingTable
+// 	Initialize the table; no program has a ring yet.
+//----------------------------------------------------------------------
+
+RingTable::RingTable()
+{
+    rings = new List<ProcessRing *>;
+}
+
+//----------------------------------------------------------------------
+// RingTable::~RingTable
+// 	Nachos is halting; throw the rings away.
+//----------------------------------------------------------------------
+
+RingTable::~RingTable()
+{
+    while (!rings->IsEmpty()) {
+	ProcessRing *ring = rings->RemoveFront();
+
+	ring->space->Unmap(ring->vaddr, RingPages);
+	delete ring;
+    }
+    delete rings;
+}
+
+//----------------------------------------------------------------------
+// RingTable::Find
+// 	Return the ring of "space", or NULL if it doesn't have one.
+//----------------------------------------------------------------------
+
+ProcessRing *
+RingTable::Find(AddrSpace *space)
+{
+    ListIterator<ProcessRing *> iter(rings);
+
+    for (; !iter.IsDone(); iter.Next()) {
+	if (iter.Item()->space == space)
+	    return iter.Item();
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// RingTable::Setup
+// 	Give the current program a ring, zeroed -- both queues empty --
+//	and mapped at pages it isn't using.  Return its address, or 0 if
+//	there isn't the memory.  A program that has a ring already gets
+//	the same one.
+//----------------------------------------------------------------------
+
+int
+RingTable::Setup()
+{
+    AddrSpace *space = kernel->currentThread->space;
+    ProcessRing *ring = Find(space);
+    int *frames, vaddr;
+
+    if (ring != NULL)
+	return ring->vaddr;
+    if ((int) RingPages > kernel->frameMap->NumClear())
+	return 0;
+    vaddr = space->Reserve(RingPages);
+    if (vaddr < 0)
+	return 0;
+
+    frames = new int[RingPages];
+    for (unsigned int i = 0; i < RingPages; i++) {
+	frames[i] = kernel->frameMap->FindAndSet();
+	bzero(&(kernel->machine->mainMemory[frames[i] * PageSize]), PageSize);
+    }
+    (void) space->Map(vaddr, frames, RingPages, TRUE);
+    rings->Append(new ProcessRing(space, vaddr, frames));
+
+    DEBUG(dbgSys, "Syscall ring at " << vaddr);
+    return vaddr;
+}
+
+//----------------------------------------------------------------------
+// RingTable::Enter
+// 	Do up to "count" of the requests in the current program's
+//	submission queue, oldest first, putting the result of each in
+//	the completion queue.  Stop early if there are no more requests,
+//	or no room for their results.
+//
+//	Return how many were done, or -1 if the program has no ring.
+//----------------------------------------------------------------------
+
+int
+RingTable::Enter(int count)
+{
+    ProcessRing *ring = Find(kernel->currentThread->space);
+    int done = 0, sqHead, cqTail, entry, completion, arg[3], tag, result;
+
+    if (ring == NULL)
+	return -1;
+
+    ring->lock->Acquire();
+    while (done < count) {
+	sqHead = ring->Read(offsetof(SyscallRing, sqHead));
+	cqTail = ring->Read(offsetof(SyscallRing, cqTail));
+	if (sqHead == ring->Read(offsetof(SyscallRing, sqTail))
+		|| cqTail - ring->Read(offsetof(SyscallRing, cqHead))
+							>= RingEntries)
+	    break;
+
+	entry = offsetof(SyscallRing, sq)
+		+ ((unsigned int) sqHead % RingEntries) * sizeof(SubmitEntry);
+	for (int i = 0; i < 3; i++)
+	    arg[i] = ring->Read(entry + offsetof(SubmitEntry, arg) + 4 * i);
+	tag = ring->Read(entry + offsetof(SubmitEntry, tag));
+	ring->Write(offsetof(SyscallRing, sqHead), sqHead + 1);
+
+	result = RingSyscall(ring->Read(entry + offsetof(SubmitEntry, op)), arg);
+
+	completion = offsetof(SyscallRing, cq)
+		+ ((unsigned int) cqTail % RingEntries) * sizeof(CompleteEntry);
+	ring->Write(completion + offsetof(CompleteEntry, tag), tag);
+	ring->Write(completion + offsetof(CompleteEntry, result), result);
+	ring->Write(offsetof(SyscallRing, cqTail), cqTail + 1);
+	done++;
+    }
+    ring->lock->Release();
+
+    DEBUG(dbgSys, "Syscall ring: " << done << " of " << count << " done");
+    return done;
+}
+
+//----------------------------------------------------------------------
+// RingTable::Release
+// 	Take the ring of "space", if it has one, out of it, and give
+//	back its frames.
+//----------------------------------------------------------------------
+
+void
+RingTable::Release(AddrSpace *space)
+{
+    ProcessRing *ring = Find(space);
+
+    if (ring == NULL)
+	return;
+    rings->Remove(ring);
+    space->Unmap(ring->vaddr, RingPages);
+    space->Release(ring->vaddr, RingPages);
+    delete ring;
+}
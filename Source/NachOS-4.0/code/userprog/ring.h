@@ -0,0 +1,75 @@
+// ring.h
+//	Data structures for batched system calls: a ring of requests
+//	and a ring of results, in pages shared by a user program and
+//	the kernel (see SyscallRing in syscall.h for the layout).
+//
+//	A program fills in requests without entering the kernel, and
+//	then has a batch of them done with one Enter system call; each
+//	is done just as if the program had trapped for it.  That saves
+//	the trap, the stub and the register shuffling for every call
+//	but one, which is most of the cost of a small call such as
+//	PrintChar.
+//
+//	The pages belong to the kernel, like a shared memory segment,
+//	and are mapped at the top of the program's address space.  They
+//	are given back when the program exits.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef RING_H
+#define RING_H
+
+#include "copyright.h"
+#include "list.h"
+#include "syscall.h"
+
+class AddrSpace;
+class Lock;
+
+#define RingPages	divRoundUp(sizeof(SyscallRing), PageSize)
+
+// Do one request, as if the program had made system call "op" with
+// the arguments "arg"; return what it returned (see exception.cc).
+
+extern int RingSyscall(int op, int *arg);
+
+// The ring of one program.
+
+class ProcessRing {
+  public:
+    ProcessRing(AddrSpace *s, int addr, int *pageFrames);
+    ~ProcessRing();			// Give back its frames
+
+    int Read(int offset);		// The word "offset" bytes into it
+    void Write(int offset, int value);
+
+    AddrSpace *space;			// Whose it is,
+    int vaddr;				// and where it is mapped
+    int *frames;			// Its page frames
+    Lock *lock;				// Held while a batch is done, so
+					// no request is done twice
+};
+
+// The following class defines the rings of all the programs.
+
+class RingTable {
+  public:
+    RingTable();
+    ~RingTable();
+
+    int Setup();			// Map the current program's ring;
+					// return where, or 0 if no memory
+    int Enter(int count);		// Do up to "count" requests; return
+					// how many, or -1 if there's no ring
+    void Release(AddrSpace *space);	// It is going away; free its ring
+
+  private:
+    ProcessRing *Find(AddrSpace *space);
+					// Its ring, or NULL
+
+    List<ProcessRing *> *rings;
+};
+
+#endif // RING_H
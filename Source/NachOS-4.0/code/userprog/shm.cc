@@ -0,0 +1,207 @@
+// shm.cc
+//	Routines to create shared memory segments, and to put them into
+//	and take them out of address spaces.
+//
+//	The segment owns its page frames; an address space that has it
+//	attached only borrows them, through AddrSpace::Map.  That way
+//	the frames outlive any one of the programs using them.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "main.h"
+#include "shm.h"
+#include "addrspace.h"
+#include "bitmap.h"
+
+//----------------------------------------------------------------------
+// ShmSegment::ShmSegment
+// 	Make a segment, and give it "pages" page frames filled with
+//	zeroes.  There must be enough free ones.
+//----------------------------------------------------------------------
+
+ShmSegment::ShmSegment(int segmentKey, int pages)
+{
+    key = segmentKey;
+    numPages = pages;
+    frames = new int[pages];
+    for (int i = 0; i < pages; i++) {
+	frames[i] = kernel->frameMap->FindAndSet();
+	ASSERT(frames[i] >= 0);
+	bzero(&(kernel->machine->mainMemory[frames[i] * PageSize]), PageSize);
+    }
+    refs = 0;
+}
+
+//----------------------------------------------------------------------
+// ShmSegment::~ShmSegment
+// 	Give the segment's page frames back.
+//----------------------------------------------------------------------
+
+ShmSegment::~ShmSegment()
+{
+    for (int i = 0; i < numPages; i++)
+	kernel->frameMap->Clear(frames[i]);
+    delete [] frames;
+}
+
+//----------------------------------------------------------------------
+// ShmTable::ShmTable
+// 	Initialize the table; there are no segments yet.
+//----------------------------------------------------------------------
+
+ShmTable::ShmTable()
+{
+    for (int i = 0; i < MaxShmSegments; i++)
+	segments[i] = NULL;
+    attachments = new List<ShmAttachment *>;
+}
+
+//----------------------------------------------------------------------
+// ShmTable::~ShmTable
+// 	Nachos is halting; throw away what is left.
+//----------------------------------------------------------------------
+
+ShmTable::~ShmTable()
+{
+    while (!attachments->IsEmpty())
+	delete attachments->RemoveFront();
+    delete attachments;
+    for (int i = 0; i < MaxShmSegments; i++)
+	delete segments[i];
+}
+
+//----------------------------------------------------------------------
+// ShmTable::Find
+// 	Return the segment called "key", or NULL if there isn't one.
+//----------------------------------------------------------------------
+
+ShmSegment *
+ShmTable::Find(int key)
+{
+    for (int i = 0; i < MaxShmSegments; i++) {
+	if (segments[i] != NULL && segments[i]->key == key)
+	    return segments[i];
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// ShmTable::Create
+// 	Make a segment called "key", big enough for "size" bytes, unless
+//	there already is one.  Return 0 if there is one now, -1 if there
+//	wasn't the memory or a free slot, or the one there already was
+//	is smaller than "size".
+//----------------------------------------------------------------------
+
+int
+ShmTable::Create(int key, int size)
+{
+    ShmSegment *segment = Find(key);
+    int pages = divRoundUp(size, PageSize);
+
+    if (segment != NULL)
+	return (segment->numPages >= pages) ? 0 : -1;
+    if (size <= 0 || pages > kernel->frameMap->NumClear())
+	return -1;
+
+    for (int i = 0; i < MaxShmSegments; i++) {
+	if (segments[i] == NULL) {
+	    segments[i] = new ShmSegment(key, pages);
+	    DEBUG(dbgAddr, "Shared segment " << key << ": " << pages << " pages");
+	    return 0;
+	}
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// ShmTable::Attach
+// 	Put the segment called "key" into the current address space,
+//	starting at "vaddr", which must be on a page boundary.  Return
+//	0, or -1 if there is no such segment, or the pages are in use.
+//----------------------------------------------------------------------
+
+int
+ShmTable::Attach(int key, int vaddr)
+{
+    AddrSpace *space = kernel->currentThread->space;
+    ShmSegment *segment = Find(key);
+
+    if (segment == NULL
+		|| !space->Map(vaddr, segment->frames, segment->numPages))
+	return -1;
+
+    segment->refs++;
+    attachments->Append(new ShmAttachment(space, vaddr, segment));
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// ShmTable::Remove
+// 	Take a segment out of the address space it was attached to.
+//	If that was the last attachment, the segment goes away.
+//----------------------------------------------------------------------
+
+void
+ShmTable::Remove(ShmAttachment *attachment)
+{
+    ShmSegment *segment = attachment->segment;
+
+    attachments->Remove(attachment);
+    attachment->space->Unmap(attachment->vaddr, segment->numPages);
+    delete attachment;
+
+    if (--segment->refs == 0) {
+	DEBUG(dbgAddr, "Shared segment " << segment->key << " gone");
+	for (int i = 0; i < MaxShmSegments; i++) {
+	    if (segments[i] == segment)
+		segments[i] = NULL;
+	}
+	delete segment;
+    }
+}
+
+//----------------------------------------------------------------------
+// ShmTable::Detach
+// 	Take the segment attached at "vaddr" out of the current address
+//	space.  Return 0, or -1 if there isn't one there.
+//----------------------------------------------------------------------
+
+int
+ShmTable::Detach(int vaddr)
+{
+    AddrSpace *space = kernel->currentThread->space;
+    ListIterator<ShmAttachment *> iter(attachments);
+
+    for (; !iter.IsDone(); iter.Next()) {
+	ShmAttachment *attachment = iter.Item();
+
+	if (attachment->space == space && attachment->vaddr == vaddr) {
+	    Remove(attachment);
+	    return 0;
+	}
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// ShmTable::DetachAll
+// 	Take every segment out of "space", before it is deleted.
+//----------------------------------------------------------------------
+
+void
+ShmTable::DetachAll(AddrSpace *space)
+{
+    ListIterator<ShmAttachment *> iter(attachments);
+    List<ShmAttachment *> mine;		// Remove changes the list
+
+    for (; !iter.IsDone(); iter.Next()) {
+	if (iter.Item()->space == space)
+	    mine.Append(iter.Item());
+    }
+    while (!mine.IsEmpty())
+	Remove(mine.RemoveFront());
+}
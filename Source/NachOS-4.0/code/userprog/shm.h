@@ -0,0 +1,82 @@
+// shm.h
+//	Data structures for shared memory: segments of page frames that
+//	several user programs can have in their address spaces at once,
+//	each at an address of its own choosing.
+//
+//	A segment is named by a key that the programs agree on.  The
+//	first ShmCreate with a key makes the segment, zero filled; each
+//	ShmAttach puts its frames into the caller's page table, and
+//	ShmDetach takes them out again.  The frames go back to the free
+//	list when the last attachment is gone, whether by ShmDetach or
+//	by the process exiting; a segment nobody has attached yet is
+//	kept until someone has.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SHM_H
+#define SHM_H
+
+#include "copyright.h"
+#include "list.h"
+
+class AddrSpace;
+
+#define MaxShmSegments	16		// segments that can exist at once
+
+// A segment of shared memory.
+
+class ShmSegment {
+  public:
+    ShmSegment(int segmentKey, int pages);
+					// Take "pages" free frames for it
+    ~ShmSegment();			// Give them back
+
+    int key;				// What the programs call it
+    int numPages;			// How big it is
+    int *frames;			// Its page frames
+    int refs;				// How many attachments it has
+};
+
+// One place a segment is attached: an address space, and where in it.
+
+class ShmAttachment {
+  public:
+    ShmAttachment(AddrSpace *s, int addr, ShmSegment *seg)
+	{ space = s; vaddr = addr; segment = seg; }
+
+    AddrSpace *space;
+    int vaddr;
+    ShmSegment *segment;
+};
+
+// The following class defines the table of all the shared memory
+// segments, and where they are attached.
+
+class ShmTable {
+  public:
+    ShmTable();
+    ~ShmTable();
+
+    int Create(int key, int size);	// Make a segment of at least "size"
+					// bytes called "key", unless there
+					// is one; 0 on success, -1 if there
+					// isn't the memory or the room, or
+					// the one there is is too small
+    int Attach(int key, int vaddr);	// Put it at "vaddr" in the current
+					// address space; 0 or -1
+    int Detach(int vaddr);		// Take the segment at "vaddr" out
+					// of it again; 0 or -1
+    void DetachAll(AddrSpace *space);	// It is going away; take them all
+
+  private:
+    ShmSegment *Find(int key);		// The segment "key", or NULL
+    void Remove(ShmAttachment *attachment);
+					// Undo an attachment
+
+    ShmSegment *segments[MaxShmSegments];
+    List<ShmAttachment *> *attachments;	// Where they are all attached
+};
+
+#endif // SHM_H
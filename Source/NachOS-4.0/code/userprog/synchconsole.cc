@@ -22,6 +22,8 @@ SynchConsoleInput::SynchConsoleInput(char *inputFile)
     consoleInput = new ConsoleInput(inputFile, this);
     lock = new Lock("console in");
     waitFor = new Semaphore("console in", 0);
+    available = 0;
+    pollers = new WaitQueue();
 }
 
 //----------------------------------------------------------------------
@@ -34,6 +36,7 @@ SynchConsoleInput::~SynchConsoleInput()
     delete consoleInput; 
     delete lock; 
     delete waitFor;
+    delete pollers;
 }
 
 //----------------------------------------------------------------------
@@ -48,6 +51,7 @@ SynchConsoleInput::GetChar()
 
     lock->Acquire();
     waitFor->P();	// wait for EOF or a char to be available.
+    available--;
     ch = consoleInput->GetChar();
     lock->Release();
     return ch;
@@ -56,13 +60,15 @@ SynchConsoleInput::GetChar()
 //----------------------------------------------------------------------
 // SynchConsoleInput::CallBack
 //      Interrupt handler called when keystroke is hit; wake up
-//	anyone waiting.
+//	anyone waiting, or polling.
 //----------------------------------------------------------------------
 
 void
 SynchConsoleInput::CallBack()
 {
+    available++;
     waitFor->V();
+    pollers->Wake();
 }
 
 //----------------------------------------------------------------------
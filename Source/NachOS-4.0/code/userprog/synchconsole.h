@@ -26,11 +26,16 @@ class SynchConsoleInput : public CallBackObj {
     ~SynchConsoleInput();		// Deallocate console device
 
     char GetChar();		// Read a character, waiting if necessary
-    
+    bool CanRead() { return available > 0; }
+				// Would GetChar return right away?
+
+    WaitQueue *pollers;		// threads in Poll, woken by each keystroke
+
   private:
     ConsoleInput *consoleInput;	// the hardware keyboard
     Lock *lock;			// only one reader at a time
     Semaphore *waitFor;		// wait for callBack
+    int available;		// keystrokes (or EOF) not yet read
 
     void CallBack();		// called when a keystroke is available
 };
@@ -34,6 +34,23 @@
 #define SC_ExecV 13
 #define SC_ThreadExit 14
 #define SC_ThreadJoin 15
+#define SC_Wait 16
+#define SC_Wake 17
+#define SC_Pipe 18
+#define SC_ExecIO 19
+#define SC_ShmCreate 20
+#define SC_ShmAttach 21
+#define SC_ShmDetach 22
+#define SC_Mmap 23
+#define SC_Munmap 24
+#define SC_AsyncRead 25
+#define SC_AsyncWrite 26
+#define SC_WaitIO 27
+#define SC_RingSetup 28
+#define SC_Enter 29
+#define SC_ReadV 30
+#define SC_WriteV 31
+#define SC_Poll 32
 
 #define SC_Add 42
 #define SC_Sub 43
@@ -196,6 +213,64 @@ int Seek(int position, OpenFileId id);
  */
 int Close(OpenFileId id);
 
+/* Vectored I/O: Read or Write the open file "id" once, as if the
+ * "count" pieces described by "iov" -- at most MaxIOVecs -- were one
+ * buffer, in order.  A write gathers the pieces together; a read fills
+ * one before the next.  Return the number of bytes read or written, or
+ * a negative error code.
+ */
+#define MaxIOVecs 16
+
+typedef struct {
+    char *base;			/* where a piece is, */
+    int len;			/* and how many bytes */
+} IOVec;
+
+int ReadV(IOVec *iov, int count, OpenFileId id);
+int WriteV(IOVec *iov, int count, OpenFileId id);
+
+/* Make a pipe: whatever is written to fds[1] can be read from fds[0],
+ * in order.  Reading an empty pipe waits for a writer, and returns 0
+ * once nobody has the write end open; writing to a full one waits
+ * for a reader.  Return 0 on success, -1 if there is no room.
+ */
+int Pipe(OpenFileId fds[2]);
+
+/* The open file id of mailbox "box" of this machine's post office.  It
+ * is always open; reading it waits for a message, and returns its data.
+ */
+#define MailBoxId(box) (64 + (box))
+
+/* Wait until at least one of the "count" open files in "fds" -- at most
+ * MaxPollFds -- can be read or written, as asked in its "events", without
+ * waiting.  Each "revents" is set to what it can do.  The console, pipe
+ * ends and mailboxes are waited for; files are always ready.  A thread
+ * in Poll takes no CPU time until one of them changes.
+ *
+ * "timeout" is how many ticks to wait at most: 0 not to wait, -1 to wait
+ * as long as it takes.  Return how many of "fds" are ready, 0 if the
+ * timeout is up, or a negative error code.
+ */
+#define PollIn 1		/* can be read without waiting */
+#define PollOut 2		/* can be written without waiting */
+#define PollInvalid 4		/* not open (in "revents" only) */
+#define MaxPollFds 16
+
+typedef struct {
+    OpenFileId id;
+    int events;			/* PollIn, PollOut, or both */
+    int revents;		/* which of them it can do now */
+} PollFd;
+
+int Poll(PollFd *fds, int count, int timeout);
+
+/* Run the executable "exec_name", like Exec, with "input" and "output"
+ * as its ConsoleInput and ConsoleOutput.  Each is the console, or the
+ * matching end of a pipe; the new program shares the end with its
+ * parent until it exits.  (Exec passes on the parent's own.)
+ */
+SpaceId ExecIO(char *exec_name, OpenFileId input, OpenFileId output);
+
 /* User-level thread operations: Fork and Yield.  To allow multiple
  * threads to run within a user program.
  *
@@ -203,10 +278,11 @@ int Close(OpenFileId id);
  */
 
 /* Fork a thread to run a procedure ("func") in the *same* address space
- * as the current thread.
+ * as the current thread, on a stack of its own, passing it "arg".
+ * If "func" returns, the thread exits with what it returned.
  * Return a positive ThreadId on success, negative error code on failure
  */
-ThreadId ThreadFork(void (*func)());
+ThreadId ThreadFork(int (*func)(int), int arg);
 
 /* Yield the CPU to another runnable thread, whether in this address space
  * or not.
@@ -224,6 +300,140 @@ int ThreadJoin(ThreadId id);
  */
 void ThreadExit(int ExitCode);
 
+/* Synchronization: the building blocks for locks and the like, kept
+ * in user memory so they only need the kernel when a thread has to
+ * wait (see test/mutex.c).
+ *
+ * Wait puts the calling thread to sleep until a Wake on the same word,
+ * but only if the word at "addr" still holds "expected" -- checking and
+ * going to sleep are atomic.  Return 0 after sleeping, EAGAIN if the
+ * word held something else, EFAULT if "addr" is bad.  A thread may also
+ * return from Wait without a Wake, so the caller should check again.
+ */
+int Wait(int *addr, int expected);
+
+/* Wake up to "count" of the threads waiting on the word at "addr",
+ * longest waiting first.  Return how many were woken, or EFAULT.
+ * Threads of different programs can use a word in shared memory.
+ */
+int Wake(int *addr, int count);
+
+/* Shared memory: page frames that several programs can have in their
+ * address spaces at once.  A segment is named by a "key" the programs
+ * agree on, and goes away once every program that attached it has
+ * detached it, or exited.
+ */
+
+/* Make a segment of at least "size" bytes called "key", filled with
+ * zeroes, unless there is one already.  Return 0 if there is one now,
+ * -1 if there isn't the memory for it, or the one there is is smaller.
+ */
+int ShmCreate(int key, int size);
+
+/* Put the segment "key" into this program's memory, starting at "addr",
+ * which must be a multiple of the page size and not in use.
+ * Return 0 on success, -1 on failure.
+ */
+int ShmAttach(int key, char *addr);
+
+/* Take the segment attached at "addr" out of this program's memory.
+ * Return 0 on success, -1 if there isn't one there.
+ */
+int ShmDetach(char *addr);
+
+/* Map "length" bytes of the open file "id", from byte "offset" on, into
+ * this program's memory, and return the address of the first, or 0 on
+ * failure.  Each page is read from the file when it is first touched;
+ * what the program writes goes back to the file on Munmap, when the
+ * file is closed, or when the program exits.  The file does not grow:
+ * bytes mapped past its end read as zero, and are not written back.
+ */
+char *Mmap(OpenFileId id, int offset, int length);
+
+/* Write back and unmap the mapping that Mmap returned "addr" for.
+ * Return 0 on success, -1 if there isn't one there.
+ */
+int Munmap(char *addr);
+
+/* Asynchronous I/O: start reading or writing an open file, and carry on
+ * while the kernel does it.  The request uses the file position, and
+ * moves it on as if all "size" bytes will be read or written.  If
+ * "status" is not 0, the word there holds EBUSY until the request is
+ * done, and then what Read or Write would have returned.
+ *
+ * Return a handle for the request, or a negative error code: EBADF if
+ * "id" is not an open file (the console and pipes can't be used this
+ * way), EINVAL if "size" is negative or more than 1024 pages (the most
+ * an address space can hold), EAGAIN if too many requests have not been
+ * waited for.
+ */
+typedef int IOHandle;
+
+IOHandle AsyncRead(char *buffer, int size, OpenFileId id, int *status);
+
+/* As AsyncRead.  The bytes are copied from "buffer" before it returns,
+ * so the buffer can be used again right away.
+ */
+IOHandle AsyncWrite(char *buffer, int size, OpenFileId id, int *status);
+
+/* Wait for the request "handle" to be done, unless it is already, and
+ * free the handle -- every request must be waited for.  Return what
+ * Read or Write would have, or EBADF if "handle" is not a request of
+ * this program.
+ */
+int WaitIO(IOHandle handle);
+
+/* Batched system calls: instead of trapping into the kernel for each
+ * call, a program writes the calls it wants into the submission queue
+ * of a ring shared with the kernel, and has the kernel do a batch of
+ * them with one Enter.  The result of each call, with the "tag" the
+ * program gave it, goes into the completion queue.
+ *
+ * Each queue is a ring of RingEntries entries, with two counters that
+ * only ever go up: the side that adds entries moves the tail, the side
+ * that takes them moves the head.  Entry "n" is at index
+ * n % RingEntries.  The program owns sqTail and cqHead; the kernel owns
+ * sqHead and cqTail.
+ *
+ * The calls that can be made this way are Read, Write, ReadV, WriteV,
+ * Seek, Create, Open, Close, PrintString, PrintChar, PrintNum, Add and
+ * Sub; any other completes with EINVAL.  So does a read or write of
+ * ConsoleInput, a pipe or a mailbox, which could wait indefinitely.
+ * A call that returns nothing completes with 0.
+ */
+#define RingEntries 16
+
+typedef struct {
+    int op;			/* SC_Read, SC_Write, ... */
+    int arg[3];			/* its arguments, as they would be passed */
+    int tag;			/* anything; copied to the completion */
+} SubmitEntry;
+
+typedef struct {
+    int tag;
+    int result;			/* what the call returned */
+} CompleteEntry;
+
+typedef struct {
+    int sqHead, sqTail;
+    int cqHead, cqTail;
+    SubmitEntry sq[RingEntries];
+    CompleteEntry cq[RingEntries];
+} SyscallRing;
+
+/* Map this program's ring into its memory, zeroed, and return where it
+ * is; a second call returns the same ring.  Return 0 if there isn't the
+ * memory for it.
+ */
+SyscallRing *RingSetup();
+
+/* Do up to "count" of the calls in the submission queue, in order, and
+ * return how many were done.  Fewer are done if the submission queue
+ * runs out, or the completion queue fills up.  Return -1 if the program
+ * has no ring.
+ */
+int Enter(int count);
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */
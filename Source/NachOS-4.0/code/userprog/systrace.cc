@@ -0,0 +1,393 @@
+// systrace.cc
+//	Routines to record the system calls made by user programs, and
+//	to print a trace of them afterwards.
+//
+//	Recording a call costs two records, copied into memory; the
+//	UNIX file is written a bufferful at a time.  The trace is in
+//	the host's byte order, so it must be printed on the same kind
+//	of machine it was made on.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "main.h"
+#include "systrace.h"
+#include "ptable.h"
+#include "syscall.h"
+
+// Syscall traces start with a magic number, like disk traces.
+
+const int SyscallTraceMagic = 0x53595343;
+
+// What a trace shows of each system call: its name, how many of its
+// arguments to print, and whether it returns anything (or, for
+// those that end the thread, returns at all).
+
+enum SyscallReturn { ReturnsValue, ReturnsNothing, NeverReturns };
+
+struct SyscallName {
+    int number;
+    char *name;
+    int numArgs;
+    SyscallReturn returns;
+};
+
+static SyscallName syscallNames[] = {
+    { SC_Halt, "Halt", 0, NeverReturns },
+    { SC_Exit, "Exit", 1, NeverReturns },
+    { SC_Exec, "Exec", 1, ReturnsValue },
+    { SC_Join, "Join", 1, ReturnsValue },
+    { SC_Create, "Create", 1, ReturnsValue },
+    { SC_Remove, "Remove", 1, ReturnsValue },
+    { SC_Open, "Open", 1, ReturnsValue },
+    { SC_Read, "Read", 3, ReturnsValue },
+    { SC_Write, "Write", 3, ReturnsValue },
+    { SC_Seek, "Seek", 2, ReturnsValue },
+    { SC_Close, "Close", 1, ReturnsValue },
+    { SC_ThreadFork, "ThreadFork", 2, ReturnsValue },
+    { SC_ThreadYield, "ThreadYield", 0, ReturnsNothing },
+    { SC_ExecV, "ExecV", 2, ReturnsValue },
+    { SC_ThreadExit, "ThreadExit", 1, NeverReturns },
+    { SC_ThreadJoin, "ThreadJoin", 1, ReturnsValue },
+    { SC_Wait, "Wait", 2, ReturnsValue },
+    { SC_Wake, "Wake", 2, ReturnsValue },
+    { SC_Pipe, "Pipe", 1, ReturnsValue },
+    { SC_ExecIO, "ExecIO", 3, ReturnsValue },
+    { SC_ShmCreate, "ShmCreate", 2, ReturnsValue },
+    { SC_ShmAttach, "ShmAttach", 2, ReturnsValue },
+    { SC_ShmDetach, "ShmDetach", 1, ReturnsValue },
+    { SC_Mmap, "Mmap", 3, ReturnsValue },
+    { SC_Munmap, "Munmap", 1, ReturnsValue },
+    { SC_AsyncRead, "AsyncRead", 4, ReturnsValue },
+    { SC_AsyncWrite, "AsyncWrite", 4, ReturnsValue },
+    { SC_WaitIO, "WaitIO", 1, ReturnsValue },
+    { SC_RingSetup, "RingSetup", 0, ReturnsValue },
+    { SC_Enter, "Enter", 1, ReturnsValue },
+    { SC_ReadV, "ReadV", 3, ReturnsValue },
+    { SC_WriteV, "WriteV", 3, ReturnsValue },
+    { SC_Poll, "Poll", 3, ReturnsValue },
+    { SC_Add, "Add", 2, ReturnsValue },
+    { SC_Sub, "Sub", 2, ReturnsValue },
+    { SC_ReadString, "ReadString", 2, ReturnsNothing },
+    { SC_PrintString, "PrintString", 1, ReturnsNothing },
+    { SC_ReadNum, "ReadNum", 0, ReturnsValue },
+    { SC_PrintNum, "PrintNum", 1, ReturnsNothing },
+    { SC_RandomNum, "RandomNum", 0, ReturnsValue },
+    { SC_ReadChar, "ReadChar", 0, ReturnsValue },
+    { SC_PrintChar, "PrintChar", 1, ReturnsNothing },
+};
+
+#define NumSyscallNames (sizeof(syscallNames) / sizeof(SyscallName))
+#define MaxSyscall	64		// Call numbers histograms are kept for
+#define HistogramBuckets 32		// Powers of two of latencies
+#define PendingDepth	4		// Calls a thread can be in at once
+					// (more than one with Enter)
+
+//----------------------------------------------------------------------
+// SyscallTrace::SyscallTrace
+// 	Start a trace of system calls, in a new UNIX file.
+//
+//	"fileName" -- the UNIX file to put it in
+//----------------------------------------------------------------------
+
+SyscallTrace::SyscallTrace(char *fileName)
+{
+    int magicNum = SyscallTraceMagic;
+
+    fileno = OpenForWrite(fileName);
+    WriteFile(fileno, (char *) &magicNum, sizeof(int));
+    startTime = WallTime();
+    sequence = 0;
+    procs = new ProcessTrace *[MaxProcesses];
+    for (int i = 0; i < MaxProcesses; i++)
+	procs[i] = NULL;
+}
+
+//----------------------------------------------------------------------
+// SyscallTrace::~SyscallTrace
+// 	Finish the trace, writing out the records of the processes
+//	still running.
+//----------------------------------------------------------------------
+
+SyscallTrace::~SyscallTrace()
+{
+    for (int i = 0; i < MaxProcesses; i++) {
+	if (procs[i] != NULL) {
+	    Flush(procs[i]);
+	    delete procs[i];
+	}
+    }
+    delete [] procs;
+    Close(fileno);
+}
+
+//----------------------------------------------------------------------
+// SyscallTrace::Enter, SyscallTrace::Return
+// 	Record that the current thread is making, or returning from,
+//	system call "number".  The arguments, and the result, are
+//	taken from its registers.
+//----------------------------------------------------------------------
+
+void
+SyscallTrace::Enter(int number)
+{
+    Record(number, FALSE);
+}
+
+void
+SyscallTrace::Return(int number)
+{
+    Record(number, TRUE);
+}
+
+//----------------------------------------------------------------------
+// SyscallTrace::Record
+// 	Add a record for the current thread to its process's buffer,
+//	writing the buffer out first if it is full.
+//----------------------------------------------------------------------
+
+void
+SyscallTrace::Record(int number, bool returning)
+{
+    Thread *thread = kernel->currentThread;
+    ProcessTrace *proc = procs[thread->processId % MaxProcesses];
+    SyscallTraceRecord *r;
+
+    if (proc == NULL) {
+	proc = new ProcessTrace;
+	proc->pid = thread->processId;
+	proc->count = 0;
+	procs[thread->processId % MaxProcesses] = proc;
+    }
+    if (proc->count == SyscallTraceSize)
+	Flush(proc);
+
+    r = &proc->buffer[proc->count++];
+    r->sequence = sequence++;
+    r->tick = kernel->stats->totalTicks;
+    r->hostTime = (int) ((WallTime() - startTime) * 1000000);
+    if (returning) {
+	r->value[0] = kernel->machine->ReadRegister(2);
+	r->value[1] = r->value[2] = r->value[3] = 0;
+    } else {
+	for (int i = 0; i < 4; i++)
+	    r->value[i] = kernel->machine->ReadRegister(4 + i);
+    }
+    r->number = number;
+    r->pid = thread->processId;
+    r->tid = thread->threadId;
+    r->returning = returning;
+}
+
+//----------------------------------------------------------------------
+// SyscallTrace::Release
+// 	Process "pid" has ended.  Write out the records it has left, and
+//	give back its buffer.
+//----------------------------------------------------------------------
+
+void
+SyscallTrace::Release(int pid)
+{
+    ProcessTrace *proc = procs[pid % MaxProcesses];
+
+    if (proc == NULL || proc->pid != pid)
+	return;
+    Flush(proc);
+    delete proc;
+    procs[pid % MaxProcesses] = NULL;
+}
+
+//----------------------------------------------------------------------
+// SyscallTrace::Flush
+// 	Write a process's buffered records out to the UNIX file.
+//----------------------------------------------------------------------
+
+void
+SyscallTrace::Flush(ProcessTrace *proc)
+{
+    if (proc->count > 0)
+	WriteFile(fileno, (char *) proc->buffer,
+		  proc->count * sizeof(SyscallTraceRecord));
+    proc->count = 0;
+}
+
+//----------------------------------------------------------------------
+// FindSyscall
+// 	Return what the trace shows of system call "number", or NULL
+//	if there is no such call.
+//----------------------------------------------------------------------
+
+static SyscallName *
+FindSyscall(int number)
+{
+    for (unsigned int i = 0; i < NumSyscallNames; i++) {
+	if (syscallNames[i].number == number)
+	    return &syscallNames[i];
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// CompareSequence
+// 	Order two trace records by when they were made, for qsort.
+//----------------------------------------------------------------------
+
+static int
+CompareSequence(const void *a, const void *b)
+{
+    return ((SyscallTraceRecord *) a)->sequence
+	   - ((SyscallTraceRecord *) b)->sequence;
+}
+
+//----------------------------------------------------------------------
+// PrintCall
+// 	Print one system call: when it was made, by whom, and with what
+//	arguments, then -- if "result" is not NULL -- what it returned
+//	and how long it took.
+//----------------------------------------------------------------------
+
+static void
+PrintCall(SyscallTraceRecord *call, SyscallTraceRecord *result)
+{
+    SyscallName *sc = FindSyscall(call->number);
+    int numArgs = (sc == NULL) ? 4 : sc->numArgs;
+
+    cout << call->tick << " [" << call->pid << "." << (int) call->tid << "] ";
+    if (sc == NULL)
+	cout << "syscall_" << call->number;
+    else
+	cout << sc->name;
+    cout << "(";
+    for (int i = 0; i < numArgs; i++)
+	cout << (i == 0 ? "" : ", ") << call->value[i];
+    cout << ")";
+
+    if (result == NULL)
+	cout << " = ?";
+    else {
+	if (sc == NULL || sc->returns == ReturnsValue)
+	    cout << " = " << result->value[0];
+	cout << " <" << result->tick - call->tick << " ticks, "
+	     << result->hostTime - call->hostTime << " us>";
+    }
+    cout << "\n";
+}
+
+//----------------------------------------------------------------------
+// SyscallTrace::Print
+// 	Print a trace captured with -st: each system call, in the order
+//	they were made, with its arguments, its result and how long it
+//	took, in simulated ticks and host microseconds.  Then, for each
+//	kind of call, how many were made, and a histogram of how long
+//	they took, in powers of two of ticks.
+//
+//	A call is printed once it returns, so a call that blocks is
+//	printed after those made while it waited.  Calls that never
+//	returned are printed with a result of "?".
+//
+//	"fileName" -- the UNIX file holding the trace
+//----------------------------------------------------------------------
+
+void
+SyscallTrace::Print(char *fileName)
+{
+    int fd = OpenForReadWrite(fileName, FALSE);
+    int magicNum = 0, size, numRecords;
+    SyscallTraceRecord *records, *r;
+    int pending[MaxProcesses][MaxUserThreads][PendingDepth];
+    int depth[MaxProcesses][MaxUserThreads];
+    int calls[MaxSyscall], histogram[MaxSyscall][HistogramBuckets];
+    int totalTicks[MaxSyscall], totalHostTime[MaxSyscall];
+
+    if (fd < 0) {
+	cout << "Can't read syscall trace " << fileName << "\n";
+	return;
+    }
+    Lseek(fd, 0, 2);
+    size = Tell(fd) - sizeof(int);
+    Lseek(fd, 0, 0);
+    if (size >= 0)
+	Read(fd, (char *) &magicNum, sizeof(int));
+    if (magicNum != SyscallTraceMagic
+	    || size % sizeof(SyscallTraceRecord) != 0) {
+	cout << fileName << " is not a syscall trace\n";
+	Close(fd);
+	return;
+    }
+    numRecords = size / sizeof(SyscallTraceRecord);
+    records = new SyscallTraceRecord[numRecords + 1];
+    if (size > 0)
+	Read(fd, (char *) records, size);
+    Close(fd);
+    qsort(records, numRecords, sizeof(SyscallTraceRecord), CompareSequence);
+
+    bzero(depth, sizeof(depth));
+    bzero(calls, sizeof(calls));
+    bzero(histogram, sizeof(histogram));
+    bzero(totalTicks, sizeof(totalTicks));
+    bzero(totalHostTime, sizeof(totalHostTime));
+
+    for (int i = 0; i < numRecords; i++) {
+	r = &records[i];
+	int p = r->pid % MaxProcesses, t = r->tid % MaxUserThreads;
+	SyscallName *sc = FindSyscall(r->number);
+
+	if (!r->returning) {
+	    if (sc != NULL && sc->returns == NeverReturns)
+		PrintCall(r, NULL);
+	    else if (depth[p][t] < PendingDepth)
+		pending[p][t][depth[p][t]++] = i;
+	    continue;
+	}
+	if (depth[p][t] == 0)
+	    continue;			// entered before the trace started
+	SyscallTraceRecord *call = &records[pending[p][t][--depth[p][t]]];
+	int ticks = r->tick - call->tick, bucket = 0;
+
+	PrintCall(call, r);
+	if (r->number < 0 || r->number >= MaxSyscall)
+	    continue;
+	while (bucket < HistogramBuckets - 1 && (1 << bucket) <= ticks)
+	    bucket++;
+	calls[r->number]++;
+	histogram[r->number][bucket]++;
+	totalTicks[r->number] += ticks;
+	totalHostTime[r->number] += r->hostTime - call->hostTime;
+    }
+    for (int p = 0; p < MaxProcesses; p++) {
+	for (int t = 0; t < MaxUserThreads; t++) {
+	    for (int d = 0; d < depth[p][t]; d++)
+		PrintCall(&records[pending[p][t][d]], NULL);
+	}
+    }
+
+    cout << "\nLatency of each system call, in ticks:\n";
+    for (int n = 0; n < MaxSyscall; n++) {
+	if (calls[n] == 0)
+	    continue;
+	SyscallName *sc = FindSyscall(n);
+	int most = 0;
+
+	for (int b = 0; b < HistogramBuckets; b++)
+	    if (histogram[n][b] > most)
+		most = histogram[n][b];
+	cout << "\n" << (sc == NULL ? "syscall" : sc->name) << ": "
+	     << calls[n] << " calls, mean " << totalTicks[n] / calls[n]
+	     << " ticks, " << totalHostTime[n] / calls[n] << " us\n";
+	for (int b = 0; b < HistogramBuckets; b++) {
+	    if (histogram[n][b] == 0)
+		continue;
+	    if (b == 0)
+		cout << "    0";
+	    else
+		cout << "    " << (1 << (b - 1)) << "-" << (1 << b) - 1;
+	    cout << ": " << histogram[n][b] << " ";
+	    for (int i = 0; i < (histogram[n][b] * 40 + most - 1) / most; i++)
+		cout << "@";
+	    cout << "\n";
+	}
+    }
+    delete [] records;
+}
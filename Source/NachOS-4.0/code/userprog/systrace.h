@@ -0,0 +1,80 @@
+// systrace.h
+//	Data structures for tracing the system calls made by user
+//	programs, cheaply enough to leave on under load.
+//
+//	Each call adds a binary record when it is entered, and another
+//	when it returns to the program.  The records go into a buffer of
+//	the calling process's, which is written out to a UNIX file only
+//	when it fills up, or when the process ends.  Nothing is printed
+//	while the programs run; the trace is decoded afterwards (see
+//	SyscallTrace::Print).
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SYSTRACE_H
+#define SYSTRACE_H
+
+#include "copyright.h"
+
+#define SyscallTraceSize 128		// Records a process buffers before
+					// they are written out
+
+// What the trace records about a system call being entered, or
+// returning.  The records of all processes are numbered in the order
+// they were made, since each process's are written out separately.
+
+class SyscallTraceRecord {
+  public:
+    int sequence;			// Which record this is
+    int tick;				// Simulated time it was made
+    int hostTime;			// Host time, in microseconds since
+					// the trace was started
+    int value[4];			// On entry, the arguments (r4-r7);
+					// on return, the result (r2)
+    short number;			// Which system call
+    short pid;				// Which process made it,
+    char tid;				// and which of its threads
+    char returning;			// Is it returning?
+};
+
+// The records a process has buffered.
+
+class ProcessTrace {
+  public:
+    int pid;				// Whose they are
+    int count;				// How many there are
+    SyscallTraceRecord buffer[SyscallTraceSize];
+};
+
+// The trace of the system calls of all the user programs.  If
+// kernel->syscallTrace is set, ExceptionHandler adds every call to it.
+
+class SyscallTrace {
+  public:
+    SyscallTrace(char *fileName);	// Start a trace in a new UNIX file
+    ~SyscallTrace();			// Write out what is left, and close
+
+    void Enter(int number);		// The current thread is making
+					// system call "number"
+    void Return(int number);		// It is returning from it
+    void Release(int pid);		// The process has ended; write out
+					// its records
+
+    static void Print(char *fileName);	// Print a trace, strace-style, and
+					// how long each kind of call took
+
+  private:
+    void Record(int number, bool returning);
+					// Add a record for the current thread
+    void Flush(ProcessTrace *proc);	// Write out its buffered records
+
+    int fileno;				// The UNIX file
+    double startTime;			// When the trace was started
+    int sequence;			// The number of the next record
+    ProcessTrace **procs;		// Process "pid" is in slot
+					// pid % MaxProcesses, or NULL
+};
+
+#endif // SYSTRACE_H
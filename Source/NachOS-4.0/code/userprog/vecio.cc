@@ -0,0 +1,100 @@
+// vecio.cc
+//	Routines to read and write open files from several pieces of
+//	user memory at once.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "main.h"
+#include "vecio.h"
+#include "addrspace.h"
+#include "ptable.h"
+#include "pipe.h"
+#include "filesys.h"
+#include "syscall.h"
+
+//----------------------------------------------------------------------
+// VectorIO
+// 	Read or write the open file "fileId" of the current program, to
+//	or from the "count" pieces of its memory described by the IOVecs
+//	at "vecAddr".
+//
+//	Return the number of bytes read or written; EINVAL if there are
+//	too many pieces, or too many bytes in them; EFAULT if the IOVecs
+//	or a piece isn't in the program's memory; EBADF if the file isn't
+//	open (or is the console); or the error the file or pipe gave.
+//----------------------------------------------------------------------
+
+int
+VectorIO(int vecAddr, int count, int fileId, bool writing)
+{
+    AddrSpace *space = kernel->currentThread->space;
+    int vec[2 * MaxIOVecs];		// base and len of each piece
+    int total = 0, done = 0, result;
+    OpenFile *file = NULL;
+    char *buffer;
+
+    if (count < 0 || count > MaxIOVecs)
+	return EINVAL;
+    if (!space->Copy(vecAddr, (char *) vec, count * sizeof(IOVec), FALSE))
+	return EFAULT;
+    for (int i = 0; i < 2 * count; i++)
+	vec[i] = WordToHost((unsigned int) vec[i]);
+    for (int i = 0; i < count; i++) {
+	if (vec[2 * i + 1] < 0
+		|| vec[2 * i + 1] > MaxVirtualPages * PageSize - total)
+	    return EINVAL;
+	total += vec[2 * i + 1];
+    }
+
+    fileId = kernel->processTable->Redirect(fileId);
+    if (kernel->pipes->IsPipe(fileId)) {
+	for (int i = 0; i < count; i++) {
+	    if (vec[2 * i + 1] == 0)
+		continue;
+	    result = writing
+		? kernel->pipes->Write(fileId, vec[2 * i], vec[2 * i + 1])
+		: kernel->pipes->Read(fileId, vec[2 * i], vec[2 * i + 1]);
+	    if (result < 0)
+		return (done > 0) ? done : result;
+	    done += result;
+	    if (result < vec[2 * i + 1])
+		break;
+	}
+	return done;
+    }
+
+    if (fileId >= 2 && fileId < 20)
+	file = kernel->fileSystem->ListFile[fileId];
+    if (file == NULL)
+	return EBADF;			// not open, or the console
+
+    buffer = new char[total];
+    if (writing) {
+	for (int i = 0; i < count && done >= 0; i++) {
+	    if (!space->Copy(vec[2 * i], buffer + done, vec[2 * i + 1], FALSE))
+		done = EFAULT;
+	    else
+		done += vec[2 * i + 1];
+	}
+	if (done >= 0)
+	    done = file->Write(buffer, total);
+    } else {
+	result = file->Read(buffer, total);
+	for (int i = 0; i < count && done < result; i++) {
+	    int n = min(vec[2 * i + 1], result - done);
+
+	    if (!space->Copy(vec[2 * i], buffer + done, n, TRUE))
+		break;
+	    done += n;
+	}
+	if (result < 0)
+	    done = result;		// the file's error
+	else if (done < result)
+	    done = EFAULT;
+    }
+    delete [] buffer;
+    return done;
+}
@@ -0,0 +1,25 @@
+// vecio.h
+//	The ReadV and WriteV system calls: reading or writing an open
+//	file from several pieces of user memory at once.
+//
+//	A file is read or written in one go: the pieces are gathered
+//	into one buffer, or it is scattered over them, so the file system
+//	sees a single request.  A pipe is done a piece at a time, until
+//	one comes up short.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef VECIO_H
+#define VECIO_H
+
+#include "copyright.h"
+
+// Read, or write if "writing", the open file "fileId" of the current
+// program, from the "count" pieces described at "vecAddr" (see ReadV
+// in syscall.h).  Return how many bytes were done, or an error.
+
+extern int VectorIO(int vecAddr, int count, int fileId, bool writing);
+
+#endif // VECIO_H